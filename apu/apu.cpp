@@ -180,7 +180,8 @@
 #include "apu.h"
 #include "snapshot.h"
 #include "display.h"
-#include "hermite_resampler.h"
+#include "block_resampler.h"
+#include "audiocapture.h"
 
 #include "snes/snes.hpp"
 
@@ -196,35 +197,51 @@ namespace SNES
 {
 #include "bapu/dsp/blargg_endian.h"
 
-	CPU	cpu;
+	S9X_TLS CPU	cpu;
 }
 
+// What S9xMixSamples() and S9xGetSampleCount() share with the emulation. A
+// frontend may call them on its own sound thread, which has its own copy of
+// the thread-local state in multi-instance builds, so they only reach the
+// instance through this and S9xSetSoundOutput() can hand it to that thread.
+struct SSoundOutput
+{
+	const struct SSettings	*settings;
+	Resampler	*resampler;
+	uint8		*shrink_buffer;
+	int			shrink_buffer_size;
+	int			lag_master;
+	int			lag;
+
+	// the producer (emulation) and consumer (S9xMixSamples) each own one counter
+	uint32		underruns;
+	uint32		overruns;
+};
+
 namespace spc
 {
-	static apu_callback	sa_callback     = NULL;
-	static void			*extra_data     = NULL;
+	static S9X_TLS apu_callback	sa_callback     = NULL;
+	static S9X_TLS void			*extra_data     = NULL;
 
-	static bool8		sound_in_sync   = TRUE;
-	static bool8		sound_enabled   = FALSE;
+	static S9X_TLS bool8		sound_in_sync   = TRUE;
+	static S9X_TLS bool8		sound_enabled   = FALSE;
 
-	static int			buffer_size;
-	static int			lag_master      = 0;
-	static int			lag             = 0;
+	static S9X_TLS int			buffer_size;
 
-	static uint8		*landing_buffer = NULL;
-	static uint8		*shrink_buffer  = NULL;
+	static S9X_TLS uint8		*landing_buffer = NULL;
 
-	static Resampler	*resampler      = NULL;
+	static S9X_TLS SSoundOutput	own_output;
+	static S9X_TLS SSoundOutput	*output         = NULL;
 
-	static int32		reference_time;
-	static uint32		remainder;
+	static S9X_TLS int32		reference_time;
+	static S9X_TLS uint32		remainder;
 
 	static const int	timing_hack_numerator   = 256;
-	static int			timing_hack_denominator = 256;
+	static S9X_TLS int			timing_hack_denominator = 256;
 	/* Set these to NTSC for now. Will change to PAL in S9xAPUTimingSetSpeedup
 	   if necessary on game load. */
-	static uint32		ratio_numerator = APU_NUMERATOR_NTSC;
-	static uint32		ratio_denominator = APU_DENOMINATOR_NTSC;
+	static S9X_TLS uint32		ratio_numerator = APU_NUMERATOR_NTSC;
+	static S9X_TLS uint32		ratio_denominator = APU_DENOMINATOR_NTSC;
 }
 
 static void EightBitize (uint8 *, int);
@@ -272,68 +289,79 @@ static void ReverseStereo (uint8 *src_buffer, int sample_count)
 
 bool8 S9xMixSamples (uint8 *buffer, int sample_count)
 {
-	static int	shrink_buffer_size = -1;
-	uint8		*dest;
+	const struct SSettings	*settings = spc::output->settings;
+	uint8					*dest;
+
+	if (settings->SkipSound)
+	{
+		// silence, sample_count samples in the output format
+		memset(buffer, (settings->SixteenBitSound ? 0 : 128), sample_count << (settings->SixteenBitSound ? 1 : 0));
+		return (FALSE);
+	}
 
-	if (!Settings.SixteenBitSound || !Settings.Stereo)
+	if (!settings->SixteenBitSound || !settings->Stereo)
 	{
 		/* We still need both stereo samples for generating the mono sample */
-		if (!Settings.Stereo)
+		if (!settings->Stereo)
 			sample_count <<= 1;
 
 		/* We still have to generate 16-bit samples for bit-dropping, too */
-		if (shrink_buffer_size < (sample_count << 1))
+		if (spc::output->shrink_buffer_size < (sample_count << 1))
 		{
-			delete[] spc::shrink_buffer;
-			spc::shrink_buffer = new uint8[sample_count << 1];
-			shrink_buffer_size = sample_count << 1;
+			delete[] spc::output->shrink_buffer;
+			spc::output->shrink_buffer = new uint8[sample_count << 1];
+			spc::output->shrink_buffer_size = sample_count << 1;
 		}
 
-		dest = spc::shrink_buffer;
+		dest = spc::output->shrink_buffer;
 	}
 	else
 		dest = buffer;
 
-	if (Settings.Mute)
+	if (settings->Mute)
 	{
-		memset(dest, 0, sample_count << 1);
-		spc::resampler->clear();
+		// This is the consumer's side, the emulation may be pushing samples
+		// right now, so only drop what is there instead of clearing.
+		memset(buffer, (settings->SixteenBitSound ? 0 : 128), (sample_count << (settings->SixteenBitSound ? 1 : 0)) >> (settings->Stereo ? 0 : 1));
+		spc::output->resampler->drain();
 
 		return (FALSE);
 	}
 	else
 	{
-		if (spc::resampler->avail() >= (sample_count + spc::lag))
+		if (spc::output->resampler->avail() >= (sample_count + spc::output->lag))
 		{
-			spc::resampler->read((short *) dest, sample_count);
-			if (spc::lag == spc::lag_master)
-				spc::lag = 0;
+			spc::output->resampler->read((short *) dest, sample_count);
+			if (spc::output->lag == spc::output->lag_master)
+				spc::output->lag = 0;
 		}
 		else
 		{
-			memset(buffer, (Settings.SixteenBitSound ? 0 : 128), (sample_count << (Settings.SixteenBitSound ? 1 : 0)) >> (Settings.Stereo ? 0 : 1));
-			if (spc::lag == 0)
-				spc::lag = spc::lag_master;
+			memset(buffer, (settings->SixteenBitSound ? 0 : 128), (sample_count << (settings->SixteenBitSound ? 1 : 0)) >> (settings->Stereo ? 0 : 1));
+			if (spc::output->lag == 0)
+				spc::output->lag = spc::output->lag_master;
+
+			spc::output->underruns++;
 
 			return (FALSE);
 		}
 	}
 
-	if (Settings.ReverseStereo && Settings.Stereo)
+	if (settings->ReverseStereo && settings->Stereo)
 		ReverseStereo(dest, sample_count);
 
-	if (!Settings.Stereo || !Settings.SixteenBitSound)
+	if (!settings->Stereo || !settings->SixteenBitSound)
 	{
-		if (!Settings.Stereo)
+		if (!settings->Stereo)
 		{
 			DeStereo(dest, sample_count);
 			sample_count >>= 1;
 		}
 
-		if (!Settings.SixteenBitSound)
+		if (!settings->SixteenBitSound)
 			EightBitize(dest, sample_count);
 
-		memcpy(buffer, dest, (sample_count << (Settings.SixteenBitSound ? 1 : 0)));
+		memcpy(buffer, dest, (sample_count << (settings->SixteenBitSound ? 1 : 0)));
 	}
 
 	return (TRUE);
@@ -341,18 +369,31 @@ bool8 S9xMixSamples (uint8 *buffer, int sample_count)
 
 int S9xGetSampleCount (void)
 {
-	return (spc::resampler->avail() >> (Settings.Stereo ? 0 : 1));
+	const struct SSettings	*settings = spc::output->settings;
+
+	if (settings->SkipSound)
+		return (0);
+
+	return (spc::output->resampler->avail() >> (settings->Stereo ? 0 : 1));
 }
 
 /* TODO: Attach */
 void S9xFinalizeSamples (void)
 {
+	if (Settings.SkipSound)
+	{
+		// the DSP doesn't produce samples, so there is nothing to land
+		spc::sound_in_sync = TRUE;
+		return;
+	}
+
 	if (!Settings.Mute)
 	{
-		if (!spc::resampler->push((short *) spc::landing_buffer, SNES::dsp.spc_dsp.sample_count ()))
+		if (!spc::output->resampler->push((short *) spc::landing_buffer, SNES::dsp.spc_dsp.sample_count ()))
 		{
 			/* We weren't able to process the entire buffer. Potential overrun. */
 			spc::sound_in_sync = FALSE;
+			spc::output->overruns++;
 
 			if (Settings.SoundSync && !Settings.TurboMode)
 				return;
@@ -362,14 +403,38 @@ void S9xFinalizeSamples (void)
 	if (!Settings.SoundSync || Settings.TurboMode || Settings.Mute)
 		spc::sound_in_sync = TRUE;
 	else
-	if (spc::resampler->space_empty() >= spc::resampler->space_filled())
+	if (spc::output->resampler->space_empty() >= spc::output->resampler->space_filled())
 		spc::sound_in_sync = TRUE;
 	else
 		spc::sound_in_sync = FALSE;
 
+	if (S9xAudioCaptureActive())
+		S9xAudioCaptureSamples((int16 *) spc::landing_buffer, SNES::dsp.spc_dsp.sample_count());
+
 	SNES::dsp.spc_dsp.set_output((SNES::SPC_DSP::sample_t *) spc::landing_buffer, spc::buffer_size);
 }
 
+int S9xGetPendingSampleCount (void)
+{
+	return (SNES::dsp.spc_dsp.sample_count());
+}
+
+struct SSoundOutput * S9xGetSoundOutput (void)
+{
+	return (spc::output);
+}
+
+void S9xSetSoundOutput (struct SSoundOutput *output)
+{
+	spc::output = output;
+}
+
+void S9xGetSampleStats (uint32 *underruns, uint32 *overruns)
+{
+	*underruns = spc::output->underruns;
+	*overruns  = spc::output->overruns;
+}
+
 void S9xLandSamples (void)
 {
 	if (spc::sa_callback != NULL)
@@ -380,8 +445,8 @@ void S9xLandSamples (void)
 
 void S9xClearSamples (void)
 {
-	spc::resampler->clear();
-	spc::lag = spc::lag_master;
+	spc::output->resampler->clear();
+	spc::output->lag = spc::output->lag_master;
 }
 
 bool8 S9xSyncSound (void)
@@ -406,7 +471,7 @@ static void UpdatePlaybackRate (void)
 		Settings.SoundInputRate = APU_DEFAULT_INPUT_RATE;
 
 	double time_ratio = (double) Settings.SoundInputRate * spc::timing_hack_numerator / (Settings.SoundPlaybackRate * spc::timing_hack_denominator);
-	spc::resampler->time_ratio(time_ratio);
+	spc::output->resampler->time_ratio(time_ratio);
 }
 
 bool8 S9xInitSound (int buffer_ms, int lag_ms)
@@ -417,10 +482,10 @@ bool8 S9xInitSound (int buffer_ms, int lag_ms)
 	int	sample_count     = buffer_ms * 32000 / 1000;
 	int	lag_sample_count = lag_ms    * 32000 / 1000;
 
-	spc::lag_master = lag_sample_count;
+	spc::output->lag_master = lag_sample_count;
 	if (Settings.Stereo)
-		spc::lag_master <<= 1;
-	spc::lag = spc::lag_master;
+		spc::output->lag_master <<= 1;
+	spc::output->lag = spc::output->lag_master;
 
 	if (sample_count < APU_MINIMUM_SAMPLE_COUNT)
 		sample_count = APU_MINIMUM_SAMPLE_COUNT;
@@ -441,19 +506,20 @@ bool8 S9xInitSound (int buffer_ms, int lag_ms)
 
 	/* The resampler and spc unit use samples (16-bit short) as
 	   arguments. Use 2x in the resampler for buffer leveling with SoundSync */
-	if (!spc::resampler)
+	if (!spc::output->resampler)
 	{
-		spc::resampler = new HermiteResampler(spc::buffer_size >> (Settings.SoundSync ? 0 : 1));
-		if (!spc::resampler)
+		spc::output->resampler = new BlockResampler(spc::buffer_size >> (Settings.SoundSync ? 0 : 1), Settings.SoundResampler);
+		if (!spc::output->resampler)
 		{
 			delete[] spc::landing_buffer;
 			return (FALSE);
 		}
 	}
 	else
-		spc::resampler->resize(spc::buffer_size >> (Settings.SoundSync ? 0 : 1));
+		spc::output->resampler->resize(spc::buffer_size >> (Settings.SoundSync ? 0 : 1));
 
 	SNES::dsp.spc_dsp.set_output ((SNES::SPC_DSP::sample_t *) spc::landing_buffer, spc::buffer_size);
+	SNES::dsp.spc_dsp.skip_output (Settings.SkipSound);
 
 	UpdatePlaybackRate();
 
@@ -474,6 +540,15 @@ void S9xSetSoundMute (bool8 mute)
 		Settings.Mute = TRUE;
 }
 
+void S9xSetSoundSkip (bool8 skip)
+{
+	Settings.SkipSound = skip;
+	SNES::dsp.spc_dsp.skip_output (skip);
+
+	if (spc::output->resampler)
+		spc::output->resampler->clear();
+}
+
 void S9xDumpSPCSnapshot (void)
 {
 	SNES::dsp.spc_dsp.dump_spc_snapshot();
@@ -489,18 +564,26 @@ static void SPCSnapshotCallback (void)
 bool8 S9xInitAPU (void)
 {
 	spc::landing_buffer = NULL;
-	spc::shrink_buffer  = NULL;
-	spc::resampler      = NULL;
+
+	spc::output = &spc::own_output;
+	spc::output->settings           = &Settings;
+	spc::output->resampler          = NULL;
+	spc::output->shrink_buffer      = NULL;
+	spc::output->shrink_buffer_size = 0;
+	spc::output->lag_master         = 0;
+	spc::output->lag                = 0;
+	spc::output->underruns          = 0;
+	spc::output->overruns           = 0;
 
 	return (TRUE);
 }
 
 void S9xDeinitAPU (void)
 {
-	if (spc::resampler)
+	if (spc::output->resampler)
 	{
-		delete spc::resampler;
-		spc::resampler = NULL;
+		delete spc::output->resampler;
+		spc::output->resampler = NULL;
 	}
 
 	if (spc::landing_buffer)
@@ -509,10 +592,10 @@ void S9xDeinitAPU (void)
 		spc::landing_buffer = NULL;
 	}
 
-	if (spc::shrink_buffer)
+	if (spc::output->shrink_buffer)
 	{
-		delete[] spc::shrink_buffer;
-		spc::shrink_buffer = NULL;
+		delete[] spc::output->shrink_buffer;
+		spc::output->shrink_buffer = NULL;
 	}
 }
 
@@ -588,9 +671,10 @@ void S9xResetAPU (void)
 	SNES::smp.power ();
 	SNES::dsp.power ();
 	SNES::dsp.spc_dsp.set_output ((SNES::SPC_DSP::sample_t *) spc::landing_buffer, spc::buffer_size >> 1);
+	SNES::dsp.spc_dsp.skip_output (Settings.SkipSound);
 	SNES::dsp.spc_dsp.set_spc_snapshot_callback(SPCSnapshotCallback);
 
-	spc::resampler->clear();
+	spc::output->resampler->clear();
 }
 
 void S9xSoftResetAPU (void)
@@ -602,7 +686,7 @@ void S9xSoftResetAPU (void)
 	SNES::dsp.reset ();
 	SNES::dsp.spc_dsp.set_output ((SNES::SPC_DSP::sample_t *) spc::landing_buffer, spc::buffer_size >> 1);
 
-	spc::resampler->clear();
+	spc::output->resampler->clear();
 }
 
 void S9xAPUSaveState (uint8 *block)
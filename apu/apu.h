@@ -210,10 +210,19 @@ bool8 S9xSyncSound (void);
 int S9xGetSampleCount (void);
 void S9xSetSoundControl (uint8);
 void S9xSetSoundMute (bool8);
+void S9xSetSoundSkip (bool8);
 void S9xLandSamples (void);
 void S9xFinalizeSamples (void);
 void S9xClearSamples (void);
+void S9xGetSampleStats (uint32 *, uint32 *);
+int S9xGetPendingSampleCount (void);
 bool8 S9xMixSamples (uint8 *, int);
 void S9xSetSamplesAvailableCallback (apu_callback, void *);
 
+// A sound thread that isn't the emulation thread has to adopt the instance's
+// output before it calls S9xMixSamples() or S9xGetSampleCount().
+struct SSoundOutput;
+struct SSoundOutput * S9xGetSoundOutput (void);
+void S9xSetSoundOutput (struct SSoundOutput *);
+
 #endif
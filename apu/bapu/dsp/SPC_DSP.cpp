@@ -126,6 +126,58 @@ static short const gauss [512] =
 1299,1300,1300,1301,1302,1302,1303,1303,1303,1304,1304,1304,1304,1304,1305,1305,
 };
 
+#if !defined (SPC_DSP_SSE2) && (defined (__SSE2__) || defined (_M_X64))
+	#define SPC_DSP_SSE2 1
+#endif
+
+#if SPC_DSP_SSE2
+
+#include <emmintrin.h>
+
+// The four weights for each fractional position, in input order and padded to
+// 32 bits, so all four products come out of one pmaddwd
+static short gauss_taps [256] [8];
+
+static struct gauss_taps_init_t
+{
+	gauss_taps_init_t()
+	{
+		for ( int offset = 0; offset < 256; offset++ )
+		{
+			short* t = gauss_taps [offset];
+			t [0] = gauss [255 - offset];
+			t [2] = gauss [511 - offset];
+			t [4] = gauss [256 + offset];
+			t [6] = gauss [      offset];
+			t [1] = t [3] = t [5] = t [7] = 0;
+		}
+	}
+} const gauss_taps_init;
+
+inline int SPC_DSP::interpolate( voice_t const* v )
+{
+	int offset = v->interp_pos >> 4 & 0xFF;
+
+	// Decoded samples fit in 16 bits, so the low half of each int is the
+	// sample itself and the weight times zero drops the high half
+	__m128i in = _mm_loadu_si128( (__m128i const*) &v->buf [(v->interp_pos >> 12) + v->buf_pos] );
+	__m128i p  = _mm_madd_epi16( in, _mm_loadu_si128( (__m128i const*) gauss_taps [offset] ) );
+	p = _mm_srai_epi32( p, 11 );
+
+	int out;
+	out  = _mm_cvtsi128_si32( p );
+	out += _mm_cvtsi128_si32( _mm_shuffle_epi32( p, 0x55 ) );
+	out += _mm_cvtsi128_si32( _mm_shuffle_epi32( p, 0xAA ) );
+	out = (int16_t) out;
+	out += _mm_cvtsi128_si32( _mm_shuffle_epi32( p, 0xFF ) );
+
+	CLAMP16( out );
+	out &= ~1;
+	return out;
+}
+
+#else
+
 inline int SPC_DSP::interpolate( voice_t const* v )
 {
 	// Make pointers into gaussian based on fractional position between samples
@@ -146,6 +198,8 @@ inline int SPC_DSP::interpolate( voice_t const* v )
 	return out;
 }
 
+#endif
+
 
 //// Counters
 
@@ -453,11 +507,17 @@ VOICE_CLOCK( V3c )
 
 	// Gaussian interpolation
 	{
-		int output = interpolate( v );
+		int output = 0;
+
+		// Output is silent with a zero envelope anyway
+		if ( v->env )
+		{
+			output = interpolate( v );
 
-		// Noise
-		if ( m.t_non & v->vbit )
-			output = (int16_t) (m.noise * 2);
+			// Noise
+			if ( m.t_non & v->vbit )
+				output = (int16_t) (m.noise * 2);
+		}
 
 		// Apply envelope
 		m.t_output = (output * v->env) >> 11 & ~1;
@@ -686,6 +746,14 @@ ECHO_CLOCK( 26 )
 }
 ECHO_CLOCK( 27 )
 {
+	// t_main_out is part of saved states, so it's kept up even without output
+	if ( m.skip_output )
+	{
+		m.t_main_out [0] = 0;
+		m.t_main_out [1] = 0;
+		return;
+	}
+
 	// Output
 	int l = m.t_main_out [0];
 	int r = echo_output( 1 );
@@ -821,6 +889,7 @@ void SPC_DSP::init( void* ram_64k )
 {
 	m.ram = (uint8_t*) ram_64k;
 	mute_voices( 0 );
+	skip_output( false );
 	disable_surround( false );
 	set_output( 0, 0 );
 	reset();
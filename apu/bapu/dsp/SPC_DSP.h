@@ -51,6 +51,10 @@ public:
 	enum { voice_count = 8 };
 	void mute_voices( int mask );
 
+	// If true, runs everything the SPC700 can observe (ENDX, ENVX, OUTX, echo
+	// buffer writes) but doesn't mix or generate output samples.
+	void skip_output( bool skip );
+
 // State
 
 	// Resets DSP and uses supplied values to initialize registers
@@ -193,6 +197,7 @@ private:
 		// non-emulation state
 		uint8_t* ram; // 64K shared RAM between DSP and SMP
 		int mute_mask;
+		bool skip_output;
 		sample_t* out;
 		sample_t* out_end;
 		sample_t* out_begin;
@@ -286,6 +291,8 @@ inline void SPC_DSP::write( int addr, int data )
 
 inline void SPC_DSP::mute_voices( int mask ) { m.mute_mask = mask; }
 
+inline void SPC_DSP::skip_output( bool skip ) { m.skip_output = skip; }
+
 inline bool SPC_DSP::check_kon()
 {
 	bool old = m.kon_check;
@@ -49,6 +49,46 @@ void SMP::op_write(uint16 addr, uint8 data) {
   apuram[addr] = data;  //all writes go to RAM, even MMIO writes
 }
 
+void SMP::op_batched_flush() {
+  if(batched_cycles) {
+    tick(batched_cycles);
+    batched_cycles = 0;
+  }
+}
+
+void SMP::op_batched_io() {
+  batched_cycles++;
+}
+
+void SMP::op_batched_io(unsigned clocks) {
+  batched_cycles += clocks;
+}
+
+//$00f2 and the $00f4-$00f9 ports and RAM don't depend on the cycle within
+//the instruction: the CPU side only moves between calls to enter()
+static alwaysinline bool op_batched_timed(uint16 addr) {
+  return addr != 0x00f2 && (addr < 0x00f4 || addr > 0x00f9);
+}
+
+uint8 SMP::op_batched_read(uint16 addr) {
+  batched_cycles++;
+  if((addr & 0xfff0) == 0x00f0) {
+    if(op_batched_timed(addr)) op_batched_flush();
+    return mmio_read(addr);
+  }
+  if(addr >= 0xffc0 && status.iplrom_enable) return iplrom[addr & 0x3f];
+  return apuram[addr];
+}
+
+void SMP::op_batched_write(uint16 addr, uint8 data) {
+  batched_cycles++;
+  if((addr & 0xfff0) == 0x00f0) {
+    if(op_batched_timed(addr)) op_batched_flush();
+    mmio_write(addr, data);
+  }
+  apuram[addr] = data;
+}
+
 void SMP::op_step() {
   #define op_readpc() op_read(regs.pc++)
   #define op_readdp(addr) op_read((regs.p.p << 8) + addr)
@@ -115,6 +155,35 @@ void SMP::op_step() {
   #endif // defined(CYCLE_ACCURATE)
 }
 
+//Runs the same pseudo-cycle opcodes with the bus accessors swapped out, until
+//clock reaches zero. No step ever spans more than 12 cycles, so one
+//Timer::tick(clocks) per flush sees at most one stage 1 overflow, exactly as
+//the per-cycle ticks would.
+void SMP::enter_batched() {
+  #define op_io    op_batched_io
+  #define op_read  op_batched_read
+  #define op_write op_batched_write
+
+  while(clock < 0) {
+    if(opcode_cycle == 0)
+      opcode_number = op_readpc();
+
+    switch(opcode_number) {
+      #include "core/oppseudo_misc.cpp"
+      #include "core/oppseudo_mov.cpp"
+      #include "core/oppseudo_pc.cpp"
+      #include "core/oppseudo_read.cpp"
+      #include "core/oppseudo_rmw.cpp"
+    }
+
+    op_batched_flush();
+  }
+
+  #undef op_io
+  #undef op_read
+  #undef op_write
+}
+
 const unsigned SMP::cycle_count_table[256] = {
   #define c 12
 //0 1 2 3   4 5 6 7   8 9 A B   C D E F
@@ -9,9 +9,9 @@ namespace SNES {
 #if defined(DEBUGGER)
   #include "debugger/debugger.cpp"
   #include "debugger/disassembler.cpp"
-  SMPDebugger smp;
+  S9X_TLS SMPDebugger smp;
 #else
-  SMP smp;
+  S9X_TLS SMP smp;
 #endif
 
 #include "algorithms.cpp"
@@ -41,6 +41,12 @@ void SMP::synchronize_dsp() {
 }
 
 void SMP::enter() {
+#if defined(SNES9X) && !defined(DEBUGGER)
+  if(Settings.FastSPC700) {
+    enter_batched();
+    return;
+  }
+#endif
   while(clock < 0) op_step();
 }
 
@@ -70,6 +76,7 @@ void SMP::reset() {
 
   opcode_number = 0;
   opcode_cycle = 0;
+  batched_cycles = 0;
 
   regs.pc = 0xffc0;
   regs.sp = 0xef;
@@ -102,6 +102,17 @@ public:
   debugvirtual alwaysinline uint8 op_read(uint16 addr);
   debugvirtual alwaysinline void op_write(uint16 addr, uint8 data);
   debugvirtual alwaysinline void op_step();
+
+  //opcode-granular core: bus cycles are only counted, and timers, clock and
+  //dsp.clock catch up at the end of each step or before a timer, control or
+  //DSP data register access
+  unsigned batched_cycles;
+  alwaysinline void op_batched_flush();
+  alwaysinline void op_batched_io();
+  alwaysinline void op_batched_io(unsigned clocks);
+  alwaysinline uint8 op_batched_read(uint16 addr);
+  alwaysinline void op_batched_write(uint16 addr, uint8 data);
+  void enter_batched();
   static const unsigned cycle_count_table[256];
   uint64 cycle_table_cpu[256];
   unsigned cycle_table_dsp[256];
@@ -126,7 +137,7 @@ public:
 
 #if defined(DEBUGGER)
   #include "debugger/debugger.hpp"
-  extern SMPDebugger smp;
+  extern S9X_TLS SMPDebugger smp;
 #else
-  extern SMP smp;
+  extern S9X_TLS SMP smp;
 #endif
@@ -53,7 +53,7 @@ public:
     }
 };
 
-extern CPU cpu;
+extern S9X_TLS CPU cpu;
 
 } /* namespace SNES */
 
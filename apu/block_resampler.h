@@ -0,0 +1,401 @@
+/* Block resampler with selectable kernels, after the Hermite resampler */
+
+#ifndef __BLOCK_RESAMPLER_H
+#define __BLOCK_RESAMPLER_H
+
+#include <math.h>
+#include "resampler.h"
+
+#if !defined (RESAMPLER_SSE2) && (defined (__SSE2__) || defined (_M_X64))
+#define RESAMPLER_SSE2 1
+#endif
+
+#if RESAMPLER_SSE2
+#include <emmintrin.h>
+#endif
+
+#undef CLAMP
+#undef SHORT_CLAMP
+#define CLAMP(x, low, high) (((x) > (high)) ? (high) : (((x) < (low)) ? (low) : (x)))
+#define SHORT_CLAMP(n) ((short) CLAMP((n), -32768, 32767))
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RESAMPLER_MAX_TAPS    8
+#define RESAMPLER_SINC_PHASES 256
+
+/* Each read converts the frames it is going to consume out of the ring into
+   planar float runs behind the kernel's history, so every output sample is a
+   short dot product over contiguous memory. Four-tap kernels filter four
+   outputs per SSE2 pass. Output is produced between taps
+   (taps / 2 - 1) and (taps / 2) of the window at fraction r_frac. */
+
+class BlockResampler : public Resampler
+{
+    protected:
+
+        int   kernel;
+        int   taps;
+        float r_step;
+        float r_frac;
+
+        float *work_left, *work_right;
+        int   work_frames;
+        int   *sched_pos;
+        float *sched_mu;
+        int   sched_frames;
+
+        float sinc_table[(RESAMPLER_SINC_PHASES + 1) * RESAMPLER_MAX_TAPS];
+
+        void
+        build_sinc (double ratio)
+        {
+            double cutoff = ratio > 1.0 ? 1.0 / ratio : 1.0;
+
+            for (int p = 0; p <= RESAMPLER_SINC_PHASES; p++)
+            {
+                double mu = (double) p / RESAMPLER_SINC_PHASES;
+                double sum = 0.0;
+                float  *row = sinc_table + p * RESAMPLER_MAX_TAPS;
+
+                for (int k = 0; k < RESAMPLER_MAX_TAPS; k++)
+                {
+                    double x = k - (RESAMPLER_MAX_TAPS / 2 - 1) - mu;
+                    double w = x * M_PI / (RESAMPLER_MAX_TAPS / 2);
+                    double s = x == 0.0 ? 1.0 : sin (x * cutoff * M_PI) / (x * cutoff * M_PI);
+
+                    /* Blackman window over the kernel width */
+                    w = fabs (x) >= RESAMPLER_MAX_TAPS / 2 ? 0.0 : 0.42 + 0.5 * cos (w) + 0.08 * cos (2.0 * w);
+
+                    row[k] = (float) (s * w);
+                    sum += row[k];
+                }
+
+                for (int k = 0; k < RESAMPLER_MAX_TAPS; k++)
+                    row[k] = (float) (row[k] / sum);
+            }
+        }
+
+        inline void
+        coefficients (float mu, float *c)
+        {
+            switch (kernel)
+            {
+                case RESAMPLER_LINEAR:
+                    c[0] = 0.0f;
+                    c[1] = 1.0f - mu;
+                    c[2] = mu;
+                    c[3] = 0.0f;
+                    break;
+
+                case RESAMPLER_HERMITE:
+                {
+                    /* The Hermite resampler's basis, folded into per-tap weights */
+                    float mu2 = mu * mu;
+                    float mu3 = mu2 * mu;
+                    float a0 = +2 * mu3 - 3 * mu2 + 1;
+                    float a1 =      mu3 - 2 * mu2 + mu;
+                    float a2 =      mu3 -     mu2;
+                    float a3 = -2 * mu3 + 3 * mu2;
+
+                    c[0] = -0.5f * a1;
+                    c[1] = a0 - 0.5f * a2;
+                    c[2] = a3 + 0.5f * a1;
+                    c[3] = 0.5f * a2;
+                    break;
+                }
+
+                default:
+                {
+                    float phase = mu * RESAMPLER_SINC_PHASES;
+                    int   p = (int) phase;
+                    float f;
+
+                    if (p >= RESAMPLER_SINC_PHASES)
+                        p = RESAMPLER_SINC_PHASES - 1;
+                    f = phase - p;
+
+                    const float *r0 = sinc_table + p * RESAMPLER_MAX_TAPS;
+                    const float *r1 = r0 + RESAMPLER_MAX_TAPS;
+
+                    for (int k = 0; k < RESAMPLER_MAX_TAPS; k++)
+                        c[k] = r0[k] + (r1[k] - r0[k]) * f;
+                    break;
+                }
+            }
+        }
+
+        /* Deinterleaves frames from the ring into the work runs */
+        void
+        convert (const short *src, int frames, int at)
+        {
+            float *l = work_left + at;
+            float *r = work_right + at;
+            int   i = 0;
+
+#if RESAMPLER_SSE2
+            for (; i + 4 <= frames; i += 4)
+            {
+                __m128i v = _mm_loadu_si128 ((const __m128i *) (src + (i << 1)));
+
+                _mm_storeu_ps (l + i, _mm_cvtepi32_ps (_mm_srai_epi32 (_mm_slli_epi32 (v, 16), 16)));
+                _mm_storeu_ps (r + i, _mm_cvtepi32_ps (_mm_srai_epi32 (v, 16)));
+            }
+#endif
+            for (; i < frames; i++)
+            {
+                l[i] = src[(i << 1)];
+                r[i] = src[(i << 1) + 1];
+            }
+        }
+
+        inline void
+        filter (const float *l, const float *r, const float *c, short *out)
+        {
+#if RESAMPLER_SSE2
+            __m128 sl = _mm_mul_ps (_mm_loadu_ps (c), _mm_loadu_ps (l));
+            __m128 sr = _mm_mul_ps (_mm_loadu_ps (c), _mm_loadu_ps (r));
+
+            if (taps == 8)
+            {
+                sl = _mm_add_ps (sl, _mm_mul_ps (_mm_loadu_ps (c + 4), _mm_loadu_ps (l + 4)));
+                sr = _mm_add_ps (sr, _mm_mul_ps (_mm_loadu_ps (c + 4), _mm_loadu_ps (r + 4)));
+            }
+
+            /* Horizontal sums of both channels, left in lane 0, right in lane 1 */
+            __m128 s = _mm_add_ps (_mm_unpacklo_ps (sl, sr), _mm_unpackhi_ps (sl, sr));
+            s = _mm_add_ps (s, _mm_movehl_ps (s, s));
+
+            __m128i v = _mm_cvtps_epi32 (s);
+            v = _mm_packs_epi32 (v, v);
+
+            int pair = _mm_cvtsi128_si32 (v);
+            memcpy (out, &pair, sizeof (pair));
+#else
+            float sl = 0.0f, sr = 0.0f;
+
+            for (int k = 0; k < taps; k++)
+            {
+                sl += c[k] * l[k];
+                sr += c[k] * r[k];
+            }
+
+            out[0] = SHORT_CLAMP ((int) floor (sl + 0.5f));
+            out[1] = SHORT_CLAMP ((int) floor (sr + 0.5f));
+#endif
+        }
+
+#if RESAMPLER_SSE2
+        /* Four outputs of a four-tap kernel at once, one output per lane */
+        inline void
+        filter4 (const int *pos, const float *mu, short *out)
+        {
+            __m128 m = _mm_loadu_ps (mu);
+            __m128 c0, c1, c2, c3;
+
+            if (kernel == RESAMPLER_LINEAR)
+            {
+                c0 = c3 = _mm_setzero_ps ();
+                c1 = _mm_sub_ps (_mm_set1_ps (1.0f), m);
+                c2 = m;
+            }
+            else
+            {
+                __m128 half = _mm_set1_ps (0.5f);
+                __m128 two = _mm_set1_ps (2.0f);
+                __m128 three = _mm_set1_ps (3.0f);
+                __m128 m2 = _mm_mul_ps (m, m);
+                __m128 m3 = _mm_mul_ps (m2, m);
+                __m128 a0 = _mm_add_ps (_mm_sub_ps (_mm_mul_ps (two, m3), _mm_mul_ps (three, m2)), _mm_set1_ps (1.0f));
+                __m128 a1 = _mm_add_ps (_mm_sub_ps (m3, _mm_mul_ps (two, m2)), m);
+                __m128 a2 = _mm_sub_ps (m3, m2);
+                __m128 a3 = _mm_sub_ps (_mm_mul_ps (three, m2), _mm_mul_ps (two, m3));
+
+                c0 = _mm_mul_ps (_mm_set1_ps (-0.5f), a1);
+                c1 = _mm_sub_ps (a0, _mm_mul_ps (half, a2));
+                c2 = _mm_add_ps (a3, _mm_mul_ps (half, a1));
+                c3 = _mm_mul_ps (half, a2);
+            }
+
+            __m128 l0 = _mm_loadu_ps (work_left + pos[0]);
+            __m128 l1 = _mm_loadu_ps (work_left + pos[1]);
+            __m128 l2 = _mm_loadu_ps (work_left + pos[2]);
+            __m128 l3 = _mm_loadu_ps (work_left + pos[3]);
+            __m128 r0 = _mm_loadu_ps (work_right + pos[0]);
+            __m128 r1 = _mm_loadu_ps (work_right + pos[1]);
+            __m128 r2 = _mm_loadu_ps (work_right + pos[2]);
+            __m128 r3 = _mm_loadu_ps (work_right + pos[3]);
+
+            /* Windows become tap vectors */
+            _MM_TRANSPOSE4_PS (l0, l1, l2, l3);
+            _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+
+            __m128 sl = _mm_add_ps (_mm_add_ps (_mm_mul_ps (c0, l0), _mm_mul_ps (c1, l1)),
+                                    _mm_add_ps (_mm_mul_ps (c2, l2), _mm_mul_ps (c3, l3)));
+            __m128 sr = _mm_add_ps (_mm_add_ps (_mm_mul_ps (c0, r0), _mm_mul_ps (c1, r1)),
+                                    _mm_add_ps (_mm_mul_ps (c2, r2), _mm_mul_ps (c3, r3)));
+
+            /* L0-3 R0-3, saturated, then interleaved back to L R pairs */
+            __m128i v = _mm_packs_epi32 (_mm_cvtps_epi32 (sl), _mm_cvtps_epi32 (sr));
+            _mm_storeu_si128 ((__m128i *) out, _mm_unpacklo_epi16 (v, _mm_srli_si128 (v, 8)));
+        }
+#endif
+
+    public:
+        BlockResampler (int num_samples, int kernel = RESAMPLER_HERMITE) : Resampler (num_samples)
+        {
+            this->kernel = kernel;
+            taps = (kernel == RESAMPLER_SINC) ? RESAMPLER_MAX_TAPS : 4;
+            r_step = 1.0f;
+            work_left = work_right = NULL;
+            work_frames = 0;
+            sched_pos = NULL;
+            sched_mu = NULL;
+            sched_frames = 0;
+            build_sinc (1.0);
+            clear ();
+        }
+
+        ~BlockResampler ()
+        {
+            delete[] work_left;
+            delete[] work_right;
+            delete[] sched_pos;
+            delete[] sched_mu;
+        }
+
+        void
+        time_ratio (double ratio)
+        {
+            r_step = ratio;
+            if (kernel == RESAMPLER_SINC)
+                build_sinc (ratio);
+            clear ();
+        }
+
+        void
+        clear (void)
+        {
+            ring_buffer::clear ();
+            r_frac = 1.0;
+
+            if (work_left)
+            {
+                memset (work_left,  0, sizeof (float) * taps);
+                memset (work_right, 0, sizeof (float) * taps);
+            }
+        }
+
+        void
+        read (short *data, int num_samples)
+        {
+            int t = tail;
+            int out_frames = num_samples >> 1;
+            int frames = space_filled () >> 2;
+            int needed = (int) ceil (out_frames * r_step) + 2;
+
+            if (frames > needed)
+                frames = needed;
+
+            if (work_frames < taps + frames)
+            {
+                float *l = new float[taps + frames];
+                float *r = new float[taps + frames];
+
+                if (work_left)
+                {
+                    memcpy (l, work_left,  sizeof (float) * taps);
+                    memcpy (r, work_right, sizeof (float) * taps);
+                    delete[] work_left;
+                    delete[] work_right;
+                }
+                else
+                {
+                    memset (l, 0, sizeof (float) * taps);
+                    memset (r, 0, sizeof (float) * taps);
+                }
+
+                work_left   = l;
+                work_right  = r;
+                work_frames = taps + frames;
+            }
+
+            /* At most two contiguous runs: up to the end of the ring, then from its start */
+            int start = offset (t) >> 2;
+            int ring_frames = buffer_size >> 2;
+            int first = MIN (frames, ring_frames - start);
+
+            convert ((short *) buffer + (start << 1), first, taps);
+            convert ((short *) buffer, frames - first, taps + first);
+
+            if (sched_frames < out_frames)
+            {
+                delete[] sched_pos;
+                delete[] sched_mu;
+                sched_pos    = new int[out_frames];
+                sched_mu     = new float[out_frames];
+                sched_frames = out_frames;
+            }
+
+            /* Lay out the window and fraction of every output first, then
+               filter the whole run */
+            int   o_position = 0;
+            int   consumed = 0;
+            float frac = r_frac;
+
+            while (o_position < out_frames && consumed < frames)
+            {
+                while (frac <= 1.0f && o_position < out_frames)
+                {
+                    sched_pos[o_position] = consumed;
+                    sched_mu[o_position]  = frac;
+
+                    o_position++;
+                    frac += r_step;
+                }
+
+                if (frac > 1.0f)
+                {
+                    frac -= 1.0f;
+                    consumed++;
+                }
+            }
+
+            float c[RESAMPLER_MAX_TAPS];
+            int   i = 0;
+
+#if RESAMPLER_SSE2
+            if (taps == 4)
+            {
+                for (; i + 4 <= o_position; i += 4)
+                    filter4 (sched_pos + i, sched_mu + i, data + (i << 1));
+            }
+#endif
+            for (; i < o_position; i++)
+            {
+                coefficients (sched_mu[i], c);
+                filter (work_left + sched_pos[i], work_right + sched_pos[i], c, data + (i << 1));
+            }
+
+            r_frac = frac;
+
+            /* Keep the last taps frames as the next window's history */
+            memmove (work_left,  work_left  + consumed, sizeof (float) * taps);
+            memmove (work_right, work_right + consumed, sizeof (float) * taps);
+
+            if (o_position < out_frames)
+                memset (data + (o_position << 1), 0, (out_frames - o_position) << 2);
+
+            RING_STORE_RELEASE (&tail, advance (t, consumed << 2));
+        }
+
+        inline int
+        avail (void)
+        {
+            return (int) floor (((space_filled () >> 2) - r_frac) / r_step) * 2;
+        }
+};
+
+#endif /* __BLOCK_RESAMPLER_H */
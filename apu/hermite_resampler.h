@@ -66,13 +66,15 @@ class HermiteResampler : public Resampler
         void
         read (short *data, int num_samples)
         {
-            int i_position = start >> 1;
+            int t = tail;
+            int i_position = offset (t) >> 1;
             int max_samples = buffer_size >> 1;
             short *internal_buffer = (short *) buffer;
             int o_position = 0;
             int consumed = 0;
+            int available = space_filled () >> 1;
 
-            while (o_position < num_samples && consumed < buffer_size)
+            while (o_position < num_samples && consumed < available)
             {
                 int s_left = internal_buffer[i_position];
                 int s_right = internal_buffer[i_position + 1];
@@ -111,16 +113,13 @@ class HermiteResampler : public Resampler
                 }
             }
 
-            size -= consumed << 1;
-            start += consumed << 1;
-            if (start >= buffer_size)
-                start -= buffer_size;
+            RING_STORE_RELEASE (&tail, advance (t, consumed << 1));
         }
 
         inline int
         avail (void)
         {
-            return (int) floor (((size >> 2) - r_frac) / r_step) * 2;
+            return (int) floor (((space_filled () >> 2) - r_frac) / r_step) * 2;
         }
 };
 
@@ -5,6 +5,15 @@
 
 #include "ring_buffer.h"
 
+/* Interpolation kernels a resampler may be built with. Hermite is zero so
+   ports that clear their settings keep the old behaviour. */
+enum
+{
+    RESAMPLER_HERMITE = 0,
+    RESAMPLER_LINEAR  = 1,
+    RESAMPLER_SINC    = 2
+};
+
 class Resampler : public ring_buffer
 {
     public:
@@ -32,18 +41,6 @@ class Resampler : public ring_buffer
             return true;
         }
 
-        inline int
-        space_empty (void)
-        {
-            return buffer_size - size;
-        }
-    
-        inline int
-        space_filled (void)
-        {
-            return size;
-        }
-        
         inline int
         max_write (void)
         {
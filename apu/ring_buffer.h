@@ -8,14 +8,72 @@
 #undef MIN
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
+/* Single-producer/single-consumer: one thread may push while another pulls
+   without a lock. clear, resize and cache_silence need both sides idle. */
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define RING_LOAD_ACQUIRE(p)     ring_load_acquire (p)
+#define RING_STORE_RELEASE(p, v) ring_store_release (p, v)
+
+static inline int
+ring_load_acquire (volatile int *p)
+{
+    int v = *p;
+    _ReadWriteBarrier ();
+    return v;
+}
+
+static inline void
+ring_store_release (volatile int *p, int v)
+{
+    _ReadWriteBarrier ();
+    *p = v;
+}
+#else
+#define RING_LOAD_ACQUIRE(p)     __atomic_load_n (p, __ATOMIC_ACQUIRE)
+#define RING_STORE_RELEASE(p, v) __atomic_store_n (p, v, __ATOMIC_RELEASE)
+#endif
+
+#define RING_CACHE_LINE 64
+
 class ring_buffer
 {
 protected:
-    int size;
     int buffer_size;
-    int start;
     unsigned char *buffer;
 
+    /* Positions run over twice the buffer size, so a full buffer and an
+       empty one can be told apart. Each lives on its own cache line and is
+       only written by its own side. */
+    char pad0[RING_CACHE_LINE];
+    volatile int head;          /* written by the producer */
+    char pad1[RING_CACHE_LINE - sizeof (int)];
+    volatile int tail;          /* written by the consumer */
+    char pad2[RING_CACHE_LINE - sizeof (int)];
+
+    inline int
+    advance (int pos, int bytes)
+    {
+        pos += bytes;
+        if (pos >= (buffer_size << 1))
+            pos -= buffer_size << 1;
+        return pos;
+    }
+
+    inline int
+    offset (int pos)
+    {
+        return pos >= buffer_size ? pos - buffer_size : pos;
+    }
+
+    inline int
+    filled (int h, int t)
+    {
+        int n = h - t;
+        return n < 0 ? n + (buffer_size << 1) : n;
+    }
+
 public:
     ring_buffer (int buffer_size)
     {
@@ -23,8 +81,8 @@ public:
         buffer = new unsigned char[this->buffer_size];
         memset (buffer, 0, this->buffer_size);
 
-        size = 0;
-        start = 0;
+        head = 0;
+        tail = 0;
     }
 
     ~ring_buffer (void)
@@ -35,10 +93,13 @@ public:
     bool
     push (unsigned char *src, int bytes)
     {
-        if (space_empty () < bytes)
+        int h = head;
+        int t = RING_LOAD_ACQUIRE (&tail);
+
+        if (buffer_size - filled (h, t) < bytes)
             return false;
 
-        int end = (start + size) % buffer_size;
+        int end = offset (h);
         int first_write_size = MIN (bytes, buffer_size - end);
 
         memcpy (buffer + end, src, first_write_size);
@@ -46,7 +107,7 @@ public:
         if (bytes > first_write_size)
             memcpy (buffer, src + first_write_size, bytes - first_write_size);
 
-        size += bytes;
+        RING_STORE_RELEASE (&head, advance (h, bytes));
 
         return true;
     }
@@ -54,37 +115,49 @@ public:
     bool
     pull (unsigned char *dst, int bytes)
     {
-        if (space_filled () < bytes)
+        int h = RING_LOAD_ACQUIRE (&head);
+        int t = tail;
+
+        if (filled (h, t) < bytes)
             return false;
 
+        int start = offset (t);
+
         memcpy (dst, buffer + start, MIN (bytes, buffer_size - start));
 
         if (bytes > (buffer_size - start))
             memcpy (dst + (buffer_size - start), buffer, bytes - (buffer_size - start));
 
-        start = (start + bytes) % buffer_size;
-        size -= bytes;
+        RING_STORE_RELEASE (&tail, advance (t, bytes));
 
         return true;
     }
 
+    /* Consumer side: drops everything pushed so far, while the producer may
+       keep pushing. */
+    inline void
+    drain (void)
+    {
+        RING_STORE_RELEASE (&tail, RING_LOAD_ACQUIRE (&head));
+    }
+
     inline int
     space_empty (void)
     {
-        return buffer_size - size;
+        return buffer_size - space_filled ();
     }
 
     inline int
     space_filled (void)
     {
-        return size;
+        return filled (RING_LOAD_ACQUIRE (&head), RING_LOAD_ACQUIRE (&tail));
     }
 
     void
     clear (void)
     {
-        start = 0;
-        size = 0;
+        head = 0;
+        tail = 0;
         memset (buffer, 0, buffer_size);
     }
 
@@ -96,15 +169,15 @@ public:
         buffer = new unsigned char[buffer_size];
         memset (buffer, 0, this->buffer_size);
 
-        size = 0;
-        start = 0;
+        head = 0;
+        tail = 0;
     }
 
     inline void
     cache_silence (void)
     {
         clear ();
-        size = buffer_size;
+        head = buffer_size;
     }
 };
 
@@ -0,0 +1,918 @@
+/***********************************************************************************
+  Snes9x - Portable Super Nintendo Entertainment System (TM) emulator.
+
+  (c) Copyright 1996 - 2002  Gary Henderson (gary.henderson@ntlworld.com),
+                             Jerremy Koot (jkoot@snes9x.com)
+
+  (c) Copyright 2002 - 2004  Matthew Kendora
+
+  (c) Copyright 2002 - 2005  Peter Bortas (peter@bortas.org)
+
+  (c) Copyright 2004 - 2005  Joel Yliluoma (http://iki.fi/bisqwit/)
+
+  (c) Copyright 2001 - 2006  John Weidman (jweidman@slip.net)
+
+  (c) Copyright 2002 - 2006  funkyass (funkyass@spam.shaw.ca),
+                             Kris Bleakley (codeviolation@hotmail.com)
+
+  (c) Copyright 2002 - 2010  Brad Jorsch (anomie@users.sourceforge.net),
+                             Nach (n-a-c-h@users.sourceforge.net),
+
+  (c) Copyright 2002 - 2011  zones (kasumitokoduck@yahoo.com)
+
+  (c) Copyright 2006 - 2007  nitsuja
+
+  (c) Copyright 2009 - 2011  BearOso,
+                             OV2
+
+
+  BS-X C emulator code
+  (c) Copyright 2005 - 2006  Dreamer Nom,
+                             zones
+
+  C4 x86 assembler and some C emulation code
+  (c) Copyright 2000 - 2003  _Demo_ (_demo_@zsnes.com),
+                             Nach,
+                             zsKnight (zsknight@zsnes.com)
+
+  C4 C++ code
+  (c) Copyright 2003 - 2006  Brad Jorsch,
+                             Nach
+
+  DSP-1 emulator code
+  (c) Copyright 1998 - 2006  _Demo_,
+                             Andreas Naive (andreasnaive@gmail.com),
+                             Gary Henderson,
+                             Ivar (ivar@snes9x.com),
+                             John Weidman,
+                             Kris Bleakley,
+                             Matthew Kendora,
+                             Nach,
+                             neviksti (neviksti@hotmail.com)
+
+  DSP-2 emulator code
+  (c) Copyright 2003         John Weidman,
+                             Kris Bleakley,
+                             Lord Nightmare (lord_nightmare@users.sourceforge.net),
+                             Matthew Kendora,
+                             neviksti
+
+  DSP-3 emulator code
+  (c) Copyright 2003 - 2006  John Weidman,
+                             Kris Bleakley,
+                             Lancer,
+                             z80 gaiden
+
+  DSP-4 emulator code
+  (c) Copyright 2004 - 2006  Dreamer Nom,
+                             John Weidman,
+                             Kris Bleakley,
+                             Nach,
+                             z80 gaiden
+
+  OBC1 emulator code
+  (c) Copyright 2001 - 2004  zsKnight,
+                             pagefault (pagefault@zsnes.com),
+                             Kris Bleakley
+                             Ported from x86 assembler to C by sanmaiwashi
+
+  SPC7110 and RTC C++ emulator code used in 1.39-1.51
+  (c) Copyright 2002         Matthew Kendora with research by
+                             zsKnight,
+                             John Weidman,
+                             Dark Force
+
+  SPC7110 and RTC C++ emulator code used in 1.52+
+  (c) Copyright 2009         byuu,
+                             neviksti
+
+  S-DD1 C emulator code
+  (c) Copyright 2003         Brad Jorsch with research by
+                             Andreas Naive,
+                             John Weidman
+
+  S-RTC C emulator code
+  (c) Copyright 2001 - 2006  byuu,
+                             John Weidman
+
+  ST010 C++ emulator code
+  (c) Copyright 2003         Feather,
+                             John Weidman,
+                             Kris Bleakley,
+                             Matthew Kendora
+
+  Super FX x86 assembler emulator code
+  (c) Copyright 1998 - 2003  _Demo_,
+                             pagefault,
+                             zsKnight
+
+  Super FX C emulator code
+  (c) Copyright 1997 - 1999  Ivar,
+                             Gary Henderson,
+                             John Weidman
+
+  Sound emulator code used in 1.5-1.51
+  (c) Copyright 1998 - 2003  Brad Martin
+  (c) Copyright 1998 - 2006  Charles Bilyue'
+
+  Sound emulator code used in 1.52+
+  (c) Copyright 2004 - 2007  Shay Green (gblargg@gmail.com)
+
+  SH assembler code partly based on x86 assembler code
+  (c) Copyright 2002 - 2004  Marcus Comstedt (marcus@mc.pp.se)
+
+  2xSaI filter
+  (c) Copyright 1999 - 2001  Derek Liauw Kie Fa
+
+  HQ2x, HQ3x, HQ4x filters
+  (c) Copyright 2003         Maxim Stepin (maxim@hiend3d.com)
+
+  NTSC filter
+  (c) Copyright 2006 - 2007  Shay Green
+
+  GTK+ GUI code
+  (c) Copyright 2004 - 2011  BearOso
+
+  Win32 GUI code
+  (c) Copyright 2003 - 2006  blip,
+                             funkyass,
+                             Matthew Kendora,
+                             Nach,
+                             nitsuja
+  (c) Copyright 2009 - 2011  OV2
+
+  Mac OS GUI code
+  (c) Copyright 1998 - 2001  John Stiles
+  (c) Copyright 2001 - 2011  zones
+
+
+  Specific ports contains the works of other authors. See headers in
+  individual files.
+
+
+  Snes9x homepage: http://www.snes9x.com/
+
+  Permission to use, copy, modify and/or distribute Snes9x in both binary
+  and source form, for non-commercial purposes, is hereby granted without
+  fee, providing that this license information and copyright notice appear
+  with all copies and any derived work.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event shall the authors be held liable for any damages
+  arising from the use of this software or it's derivatives.
+
+  Snes9x is freeware for PERSONAL USE only. Commercial users should
+  seek permission of the copyright holders first. Commercial use includes,
+  but is not limited to, charging money for Snes9x or software derived from
+  Snes9x, including Snes9x or derivatives in commercial game bundles, and/or
+  using Snes9x as a promotion for your commercial product.
+
+  The copyright holders request that bug fixes and improvements to the code
+  should be forwarded to them so everyone can benefit from the modifications
+  in future versions.
+
+  Super NES and Super Nintendo Entertainment System are trademarks of
+  Nintendo Co., Limited and its subsidiary companies.
+ ***********************************************************************************/
+
+
+
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef HAVE_STRINGS_H
+#include <strings.h>
+#endif
+#ifdef USE_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+#include "snes9x.h"
+#include "apu/apu.h"
+#include "apu/ring_buffer.h"
+#include "audiocapture.h"
+
+#define CAPTURE_RATE			32000
+#define CAPTURE_QUEUE_SIZE		(1 << 20)
+#define CAPTURE_MAX_RECORD		16384	// stereo samples in one queued record
+
+#define FLAC_BLOCK_SIZE			4096
+#define FLAC_MAX_ORDER			4
+#define FLAC_MAX_PARTITION		4
+#define FLAC_MAX_FRAME_SIZE		(FLAC_BLOCK_SIZE * 2 * 3 + 64)
+
+enum
+{
+	CAPTURE_SAMPLES = 0,
+	CAPTURE_MARKER  = 1
+};
+
+struct SCaptureRecord
+{
+	uint32	type;
+	uint32	count;		// stereo samples that follow, or the frame number of a marker
+	uint64	position;	// first stereo sample of the record or the frame
+};
+
+struct SAudioCapture
+{
+	FILE	*file;
+	FILE	*frames;
+	bool8	flac;
+	bool8	restore_skip;
+
+	// emulation thread
+	uint64	position;
+	uint32	frame;
+
+	// writer
+	uint64	written;
+	uint8	*record;
+	int16	*block;
+	int		block_fill;
+	uint32	flac_frame;
+	uint32	min_frame_size;
+	uint32	max_frame_size;
+	uint8	*frame_buf;
+	int32	*channels;
+	uint32	*residual;
+
+#ifdef USE_THREADS
+	ring_buffer		*queue;
+	uint8			*staging;
+	pthread_t		thread;
+	volatile int	stop;
+	uint32			stalls;
+#endif
+};
+
+static S9X_TLS SAudioCapture	*capture = NULL;
+
+static void PutLE16 (uint8 *p, uint32 v)
+{
+	p[0] = (uint8) v;
+	p[1] = (uint8) (v >> 8);
+}
+
+static void PutLE32 (uint8 *p, uint32 v)
+{
+	PutLE16(p, v);
+	PutLE16(p + 2, v >> 16);
+}
+
+static void PutBE24 (uint8 *p, uint32 v)
+{
+	p[0] = (uint8) (v >> 16);
+	p[1] = (uint8) (v >> 8);
+	p[2] = (uint8) v;
+}
+
+// WAV
+
+static void WriteWAVHeader (SAudioCapture *c)
+{
+	uint8	h[44];
+	uint64	bytes = c->written * 4;
+	uint32	data = bytes > 0xffffffffu - 36 ? 0xffffffffu - 36 : (uint32) bytes;
+
+	memcpy(h, "RIFF", 4);
+	PutLE32(h + 4, 36 + data);
+	memcpy(h + 8, "WAVEfmt ", 8);
+	PutLE32(h + 16, 16);
+	PutLE16(h + 20, 1);					// PCM
+	PutLE16(h + 22, 2);
+	PutLE32(h + 24, CAPTURE_RATE);
+	PutLE32(h + 28, CAPTURE_RATE * 4);
+	PutLE16(h + 32, 4);
+	PutLE16(h + 34, 16);
+	memcpy(h + 36, "data", 4);
+	PutLE32(h + 40, data);
+
+	fwrite(h, 1, sizeof(h), c->file);
+}
+
+static void WriteWAVSamples (SAudioCapture *c, const int16 *samples, int count)
+{
+#ifdef LSB_FIRST
+	fwrite(samples, 4, count, c->file);
+#else
+	uint8	*p = c->record;
+
+	for (int i = 0; i < count * 2; i++)
+		PutLE16(p + i * 2, (uint16) samples[i]);
+
+	fwrite(p, 4, count, c->file);
+#endif
+}
+
+// FLAC: fixed predictors of order 0-4 with partitioned Rice residuals,
+// independent or left/side/mid stereo, whichever is smallest per frame.
+
+struct SBitWriter
+{
+	uint8	*buf;
+	int		pos;
+	uint64	acc;
+	int		bits;
+};
+
+enum
+{
+	SUBFRAME_CONSTANT,
+	SUBFRAME_VERBATIM,
+	SUBFRAME_FIXED
+};
+
+struct SSubframe
+{
+	int		type;
+	int		order;
+	int		partition_order;
+	int		params[1 << FLAC_MAX_PARTITION];
+	uint32	bits;
+};
+
+static inline void PutBits (SBitWriter *bw, uint32 value, int n)
+{
+	bw->acc = (bw->acc << n) | (n == 32 ? value : (value & ((1u << n) - 1)));
+	bw->bits += n;
+
+	while (bw->bits >= 8)
+	{
+		bw->bits -= 8;
+		bw->buf[bw->pos++] = (uint8) (bw->acc >> bw->bits);
+	}
+}
+
+static inline void PutRice (SBitWriter *bw, uint32 u, int k)
+{
+	uint32	q = u >> k;
+
+	while (q >= 32)
+	{
+		PutBits(bw, 0, 32);
+		q -= 32;
+	}
+
+	PutBits(bw, 1, q + 1);
+	if (k)
+		PutBits(bw, u, k);
+}
+
+static void PutUTF8 (SBitWriter *bw, uint32 v)
+{
+	if (v < 0x80)
+	{
+		PutBits(bw, v, 8);
+		return;
+	}
+
+	int	n = v < 0x800 ? 2 : v < 0x10000 ? 3 : v < 0x200000 ? 4 : v < 0x4000000 ? 5 : 6;
+
+	PutBits(bw, ((0xff00 >> n) & 0xff) | (v >> (6 * (n - 1))), 8);
+	for (int i = n - 2; i >= 0; i--)
+		PutBits(bw, 0x80 | ((v >> (6 * i)) & 0x3f), 8);
+}
+
+static uint8 CRC8 (const uint8 *p, int n)
+{
+	uint8	crc = 0;
+
+	for (int i = 0; i < n; i++)
+	{
+		crc ^= p[i];
+		for (int b = 0; b < 8; b++)
+			crc = (crc & 0x80) ? (uint8) ((crc << 1) ^ 0x07) : (uint8) (crc << 1);
+	}
+
+	return (crc);
+}
+
+static uint16 CRC16 (const uint8 *p, int n)
+{
+	uint16	crc = 0;
+
+	for (int i = 0; i < n; i++)
+	{
+		crc ^= (uint16) p[i] << 8;
+		for (int b = 0; b < 8; b++)
+			crc = (crc & 0x8000) ? (uint16) ((crc << 1) ^ 0x8005) : (uint16) (crc << 1);
+	}
+
+	return (crc);
+}
+
+// Zigzagged residuals of the fixed predictor, from u[order] on
+static void FixedResidual (const int32 *x, int n, int order, uint32 *u)
+{
+	for (int i = order; i < n; i++)
+	{
+		int32	r;
+
+		switch (order)
+		{
+			case 0:  r = x[i];                                                      break;
+			case 1:  r = x[i] - x[i - 1];                                           break;
+			case 2:  r = x[i] - 2 * x[i - 1] + x[i - 2];                            break;
+			case 3:  r = x[i] - 3 * x[i - 1] + 3 * x[i - 2] - x[i - 3];             break;
+			default: r = x[i] - 4 * x[i - 1] + 6 * x[i - 2] - 4 * x[i - 3] + x[i - 4]; break;
+		}
+
+		u[i] = ((uint32) r << 1) ^ (uint32) (r >> 31);
+	}
+}
+
+static uint32 RiceBits (const uint32 *u, int n, int *param)
+{
+	uint64	sum = 0;
+	int		k = 0;
+
+	for (int i = 0; i < n; i++)
+		sum += u[i];
+
+	while (k < 14 && ((uint64) n << (k + 1)) < sum)
+		k++;
+
+	uint32	best = 0xffffffff;
+
+	for (int t = (k > 0 ? k - 1 : 0); t <= k + 1 && t <= 14; t++)
+	{
+		uint64	bits = (uint64) n * (t + 1);
+
+		for (int i = 0; i < n; i++)
+			bits += u[i] >> t;
+
+		if (bits < best)
+		{
+			best = (uint32) bits;
+			*param = t;
+		}
+	}
+
+	return (best);
+}
+
+static uint32 ResidualBits (const uint32 *u, int n, int order, SSubframe *sf)
+{
+	uint32	best = 0xffffffff;
+
+	for (int p = 0; p <= FLAC_MAX_PARTITION; p++)
+	{
+		int		parts = 1 << p, len = n >> p;
+		int		params[1 << FLAC_MAX_PARTITION];
+		uint32	bits = 2 + 4;
+
+		if ((n & (parts - 1)) || len <= order)
+			break;
+
+		for (int i = 0; i < parts; i++)
+		{
+			int	start = i ? i * len : order;
+			bits += 4 + RiceBits(u + start, (i + 1) * len - start, &params[i]);
+		}
+
+		if (bits < best)
+		{
+			best = bits;
+			sf->partition_order = p;
+			memcpy(sf->params, params, parts * sizeof(int));
+		}
+	}
+
+	return (best);
+}
+
+static void AnalyzeSubframe (const int32 *x, int n, int bps, uint32 *u, SSubframe *sf)
+{
+	int	i;
+
+	for (i = 1; i < n && x[i] == x[0]; i++) ;
+	if (i == n)
+	{
+		sf->type = SUBFRAME_CONSTANT;
+		sf->bits = 8 + bps;
+		return;
+	}
+
+	sf->type = SUBFRAME_VERBATIM;
+	sf->bits = 8 + n * bps;
+
+	for (int order = 0; order <= FLAC_MAX_ORDER && order < n; order++)
+	{
+		SSubframe	t;
+
+		FixedResidual(x, n, order, u);
+		t.bits = 8 + order * bps + ResidualBits(u, n, order, &t);
+
+		if (t.bits < sf->bits)
+		{
+			t.type = SUBFRAME_FIXED;
+			t.order = order;
+			*sf = t;
+		}
+	}
+}
+
+static void WriteSubframe (SBitWriter *bw, const int32 *x, int n, int bps, uint32 *u, const SSubframe *sf)
+{
+	switch (sf->type)
+	{
+		case SUBFRAME_CONSTANT:
+			PutBits(bw, 0x00, 8);
+			PutBits(bw, (uint32) x[0], bps);
+			break;
+
+		case SUBFRAME_VERBATIM:
+			PutBits(bw, 0x02, 8);
+			for (int i = 0; i < n; i++)
+				PutBits(bw, (uint32) x[i], bps);
+			break;
+
+		default:
+		{
+			int	parts = 1 << sf->partition_order, len = n >> sf->partition_order;
+
+			PutBits(bw, 0x10 | (sf->order << 1), 8);
+			for (int i = 0; i < sf->order; i++)
+				PutBits(bw, (uint32) x[i], bps);
+
+			FixedResidual(x, n, sf->order, u);
+
+			PutBits(bw, 0, 2);
+			PutBits(bw, sf->partition_order, 4);
+			for (int p = 0; p < parts; p++)
+			{
+				PutBits(bw, sf->params[p], 4);
+				for (int i = p ? p * len : sf->order; i < (p + 1) * len; i++)
+					PutRice(bw, u[i], sf->params[p]);
+			}
+
+			break;
+		}
+	}
+}
+
+static void WriteFLACHeader (SAudioCapture *c)
+{
+	uint8	h[42];
+	uint64	info = ((uint64) CAPTURE_RATE << 44) | ((uint64) (2 - 1) << 41) | ((uint64) (16 - 1) << 36) | (c->written & 0xfffffffffULL);
+
+	memcpy(h, "fLaC", 4);
+	h[4] = 0x80;						// last metadata block, STREAMINFO
+	PutBE24(h + 5, 34);
+	h[8]  = h[10] = FLAC_BLOCK_SIZE >> 8;
+	h[9]  = h[11] = FLAC_BLOCK_SIZE & 0xff;
+	PutBE24(h + 12, c->min_frame_size > c->max_frame_size ? 0 : c->min_frame_size);
+	PutBE24(h + 15, c->max_frame_size);
+	for (int i = 0; i < 8; i++)
+		h[18 + i] = (uint8) (info >> (56 - 8 * i));
+	memset(h + 26, 0, 16);				// MD5 left unset
+
+	fwrite(h, 1, sizeof(h), c->file);
+}
+
+static void WriteFLACFrame (SAudioCapture *c, int n)
+{
+	int32		*left = c->channels, *right = left + FLAC_BLOCK_SIZE;
+	int32		*mid = right + FLAC_BLOCK_SIZE, *side = mid + FLAC_BLOCK_SIZE;
+	SSubframe	sl, sr, sm, ss;
+
+	for (int i = 0; i < n; i++)
+	{
+		left[i]  = c->block[i * 2];
+		right[i] = c->block[i * 2 + 1];
+		mid[i]   = (left[i] + right[i]) >> 1;
+		side[i]  = left[i] - right[i];
+	}
+
+	AnalyzeSubframe(left,  n, 16, c->residual, &sl);
+	AnalyzeSubframe(right, n, 16, c->residual, &sr);
+	AnalyzeSubframe(mid,   n, 16, c->residual, &sm);
+	AnalyzeSubframe(side,  n, 17, c->residual, &ss);
+
+	// 1: left, right  8: left, side  9: side, right  10: mid, side
+	int		assignment = 1;
+	uint32	best = sl.bits + sr.bits;
+
+	if (sl.bits + ss.bits < best)
+	{
+		assignment = 8;
+		best = sl.bits + ss.bits;
+	}
+
+	if (ss.bits + sr.bits < best)
+	{
+		assignment = 9;
+		best = ss.bits + sr.bits;
+	}
+
+	if (sm.bits + ss.bits < best)
+		assignment = 10;
+
+	SBitWriter	bw = { c->frame_buf, 0, 0, 0 };
+
+	PutBits(&bw, 0xfff8, 16);			// sync, fixed block size
+	PutBits(&bw, n == FLAC_BLOCK_SIZE ? 0x0c : 0x07, 4);
+	PutBits(&bw, 0, 4);					// sample rate from STREAMINFO
+	PutBits(&bw, assignment, 4);
+	PutBits(&bw, 4 << 1, 4);			// 16 bits per sample
+	PutUTF8(&bw, c->flac_frame);
+	if (n != FLAC_BLOCK_SIZE)
+		PutBits(&bw, n - 1, 16);
+	PutBits(&bw, CRC8(bw.buf, bw.pos), 8);
+
+	switch (assignment)
+	{
+		case 1:
+			WriteSubframe(&bw, left,  n, 16, c->residual, &sl);
+			WriteSubframe(&bw, right, n, 16, c->residual, &sr);
+			break;
+
+		case 8:
+			WriteSubframe(&bw, left,  n, 16, c->residual, &sl);
+			WriteSubframe(&bw, side,  n, 17, c->residual, &ss);
+			break;
+
+		case 9:
+			WriteSubframe(&bw, side,  n, 17, c->residual, &ss);
+			WriteSubframe(&bw, right, n, 16, c->residual, &sr);
+			break;
+
+		default:
+			WriteSubframe(&bw, mid,   n, 16, c->residual, &sm);
+			WriteSubframe(&bw, side,  n, 17, c->residual, &ss);
+			break;
+	}
+
+	if (bw.bits)
+		PutBits(&bw, 0, 8 - bw.bits);
+	PutBits(&bw, CRC16(bw.buf, bw.pos), 16);
+
+	fwrite(bw.buf, 1, bw.pos, c->file);
+
+	if ((uint32) bw.pos < c->min_frame_size)
+		c->min_frame_size = bw.pos;
+	if ((uint32) bw.pos > c->max_frame_size)
+		c->max_frame_size = bw.pos;
+	c->flac_frame++;
+}
+
+// Writer side
+
+static void CaptureWrite (SAudioCapture *c, const int16 *samples, int count)
+{
+	if (!c->flac)
+	{
+		WriteWAVSamples(c, samples, count);
+		c->written += count;
+		return;
+	}
+
+	while (count)
+	{
+		int	n = MIN(count, FLAC_BLOCK_SIZE - c->block_fill);
+
+		memcpy(c->block + c->block_fill * 2, samples, n * 4);
+		c->block_fill += n;
+		c->written += n;
+		samples += n * 2;
+		count -= n;
+
+		if (c->block_fill == FLAC_BLOCK_SIZE)
+		{
+			WriteFLACFrame(c, FLAC_BLOCK_SIZE);
+			c->block_fill = 0;
+		}
+	}
+}
+
+static void CaptureRecord (SAudioCapture *c, const SCaptureRecord *rec, const int16 *samples)
+{
+	if (rec->type == CAPTURE_SAMPLES)
+		CaptureWrite(c, samples, rec->count);
+	else
+		fprintf(c->frames, "%u %llu\n", rec->count, (unsigned long long) rec->position);
+}
+
+#ifdef USE_THREADS
+static void * CaptureThread (void *arg)
+{
+	SAudioCapture	*c = (SAudioCapture *) arg;
+	SCaptureRecord	rec;
+
+	for (;;)
+	{
+		if (c->queue->space_filled() >= (int) sizeof(rec))
+		{
+			// Records are pushed whole, so the samples are already there.
+			c->queue->pull((unsigned char *) &rec, sizeof(rec));
+			if (rec.type == CAPTURE_SAMPLES)
+				c->queue->pull(c->record, rec.count * 4);
+
+			CaptureRecord(c, &rec, (int16 *) c->record);
+		}
+		else
+		if (RING_LOAD_ACQUIRE(&c->stop))
+		{
+			if (c->queue->space_filled() == 0)
+				break;
+		}
+		else
+			usleep(2000);
+	}
+
+	return (NULL);
+}
+#endif
+
+// Emulation side
+
+static void CaptureQueue (SAudioCapture *c, const SCaptureRecord *rec, const int16 *samples)
+{
+#ifdef USE_THREADS
+	int	size = sizeof(*rec);
+
+	memcpy(c->staging, rec, sizeof(*rec));
+	if (rec->type == CAPTURE_SAMPLES)
+	{
+		memcpy(c->staging + size, samples, rec->count * 4);
+		size += rec->count * 4;
+	}
+
+	// A full queue means the disk can't keep up; wait rather than drop audio.
+	while (!c->queue->push(c->staging, size))
+	{
+		c->stalls++;
+		usleep(1000);
+	}
+#else
+	CaptureRecord(c, rec, samples);
+#endif
+}
+
+static void FreeCapture (SAudioCapture *c)
+{
+	if (c->file)
+		fclose(c->file);
+	if (c->frames)
+		fclose(c->frames);
+
+	delete[] c->record;
+	delete[] c->block;
+	delete[] c->frame_buf;
+	delete[] c->channels;
+	delete[] c->residual;
+#ifdef USE_THREADS
+	delete c->queue;
+	delete[] c->staging;
+#endif
+	delete c;
+}
+
+bool8 S9xAudioCaptureStart (const char *filename)
+{
+	S9xAudioCaptureStop();
+
+	SAudioCapture	*c = new SAudioCapture;
+	const char		*ext = strrchr(filename, '.');
+	char			*name;
+
+	memset(c, 0, sizeof(*c));
+	c->flac = ext && !strcasecmp(ext, ".flac");
+
+	name = new char[strlen(filename) + 8];
+	sprintf(name, "%s.frames", filename);
+	c->file = fopen(filename, "wb");
+	c->frames = fopen(name, "w");
+	delete[] name;
+
+	if (!c->file || !c->frames)
+	{
+		FreeCapture(c);
+		return (FALSE);
+	}
+
+	c->record = new uint8[CAPTURE_MAX_RECORD * 4];
+
+	if (c->flac)
+	{
+		c->block = new int16[FLAC_BLOCK_SIZE * 2];
+		c->frame_buf = new uint8[FLAC_MAX_FRAME_SIZE];
+		c->channels = new int32[FLAC_BLOCK_SIZE * 4];
+		c->residual = new uint32[FLAC_BLOCK_SIZE];
+		c->min_frame_size = 0xffffffff;
+		WriteFLACHeader(c);
+	}
+	else
+		WriteWAVHeader(c);
+
+#ifdef USE_THREADS
+	c->queue = new ring_buffer(CAPTURE_QUEUE_SIZE);
+	c->staging = new uint8[sizeof(SCaptureRecord) + CAPTURE_MAX_RECORD * 4];
+
+	if (pthread_create(&c->thread, NULL, CaptureThread, c) != 0)
+	{
+		FreeCapture(c);
+		return (FALSE);
+	}
+#endif
+
+	// Skipped synthesis would leave nothing to capture.
+	if (Settings.SkipSound)
+	{
+		c->restore_skip = TRUE;
+		S9xSetSoundSkip(FALSE);
+	}
+
+	capture = c;
+
+	return (TRUE);
+}
+
+void S9xAudioCaptureStop (void)
+{
+	SAudioCapture	*c = capture;
+
+	if (!c)
+		return;
+
+	capture = NULL;
+
+#ifdef USE_THREADS
+	RING_STORE_RELEASE(&c->stop, 1);
+	pthread_join(c->thread, NULL);
+
+	if (c->stalls)
+		printf("Sound capture waited for the disk %u times.\n", c->stalls);
+#endif
+
+	if (c->flac && c->block_fill)
+		WriteFLACFrame(c, c->block_fill);
+
+	// Sizes and sample counts are only known now; unseekable outputs keep the placeholders.
+	fflush(c->file);
+	if (fseek(c->file, 0, SEEK_SET) == 0)
+	{
+		if (c->flac)
+			WriteFLACHeader(c);
+		else
+			WriteWAVHeader(c);
+	}
+
+	if (c->restore_skip)
+		S9xSetSoundSkip(TRUE);
+
+	FreeCapture(c);
+}
+
+void S9xAudioCaptureDetach (void)
+{
+	// A fork()ed child has no writer thread, and its FILE * buffers belong
+	// to the parent's file; drop the capture without touching either.
+	capture = NULL;
+}
+
+bool8 S9xAudioCaptureActive (void)
+{
+	return (capture != NULL);
+}
+
+void S9xAudioCaptureSamples (const int16 *samples, int sample_count)
+{
+	SAudioCapture	*c = capture;
+
+	if (!c)
+		return;
+
+	for (int frames = sample_count >> 1; frames > 0; )
+	{
+		SCaptureRecord	rec;
+
+		rec.type = CAPTURE_SAMPLES;
+		rec.count = MIN(frames, CAPTURE_MAX_RECORD);
+		rec.position = c->position;
+
+		CaptureQueue(c, &rec, samples);
+
+		samples += rec.count * 2;
+		frames -= rec.count;
+		c->position += rec.count;
+	}
+}
+
+void S9xAudioCaptureFrame (void)
+{
+	SAudioCapture	*c = capture;
+
+	if (!c)
+		return;
+
+	// Samples the DSP has made but not landed yet belong before the boundary.
+	SCaptureRecord	rec;
+
+	rec.type = CAPTURE_MARKER;
+	rec.count = c->frame++;
+	rec.position = c->position + (S9xGetPendingSampleCount() >> 1);
+
+	CaptureQueue(c, &rec, NULL);
+}
@@ -182,22 +182,22 @@
 
 #define	C4_PI	3.14159265
 
-int16	C4WFXVal;
-int16	C4WFYVal;
-int16	C4WFZVal;
-int16	C4WFX2Val;
-int16	C4WFY2Val;
-int16	C4WFDist;
-int16	C4WFScale;
-int16	C41FXVal;
-int16	C41FYVal;
-int16	C41FAngleRes;
-int16	C41FDist;
-int16	C41FDistVal;
-
-static double	tanval;
-static double	c4x, c4y, c4z;
-static double	c4x2, c4y2, c4z2;
+S9X_TLS int16	C4WFXVal;
+S9X_TLS int16	C4WFYVal;
+S9X_TLS int16	C4WFZVal;
+S9X_TLS int16	C4WFX2Val;
+S9X_TLS int16	C4WFY2Val;
+S9X_TLS int16	C4WFDist;
+S9X_TLS int16	C4WFScale;
+S9X_TLS int16	C41FXVal;
+S9X_TLS int16	C41FYVal;
+S9X_TLS int16	C41FAngleRes;
+S9X_TLS int16	C41FDist;
+S9X_TLS int16	C41FDistVal;
+
+static S9X_TLS double	tanval;
+static S9X_TLS double	c4x, c4y, c4z;
+static S9X_TLS double	c4x2, c4y2, c4z2;
 
 
 void C4TransfWireFrame (void)
@@ -278,10 +278,17 @@ void S9xComputeClipWindows (void)
 	int		n_regions = 1;
 	int		i, j;
 
+	bool8	window1 = PPU.Window1Left <= PPU.Window1Right;
+	bool8	window2 = PPU.Window2Left <= PPU.Window2Right;
+
+	// With windows in Settings.RenderMask, disable every window (no clipping),
+	// rather than treating them as empty ones that inverted windows would cover.
+	bool8	nowindows = (Settings.RenderMask & RENDER_MASK_WINDOWS) ? TRUE : FALSE;
+
 	// Calculate window regions. We have at most 5 regions, because we have 6 control points
 	// (screen edges, window 1 left & right, and window 2 left & right).
 
-	if (PPU.Window1Left <= PPU.Window1Right)
+	if (window1)
 	{
 		if (PPU.Window1Left > 0)
 		{
@@ -298,7 +305,7 @@ void S9xComputeClipWindows (void)
 		}
 	}
 
-	if (PPU.Window2Left <= PPU.Window2Right)
+	if (window2)
 	{
 		for (i = 0; i <= n_regions; i++)
 		{
@@ -337,7 +344,7 @@ void S9xComputeClipWindows (void)
 
 	uint8	W1, W2;
 
-	if (PPU.Window1Left <= PPU.Window1Right)
+	if (window1)
 	{
 		for (i = 0; windows[i] != PPU.Window1Left; i++) ;
 		for (j = i; windows[j] != PPU.Window1Right + 1; j++) ;
@@ -346,7 +353,7 @@ void S9xComputeClipWindows (void)
 	else
 		W1 = 0;
 
-	if (PPU.Window2Left <= PPU.Window2Right)
+	if (window2)
 	{
 		for (i = 0; windows[i] != PPU.Window2Left; i++) ;
 		for (j = i; windows[j] != PPU.Window2Right + 1; j++) ;
@@ -359,22 +366,35 @@ void S9xComputeClipWindows (void)
 	// Modes are: 3=Draw as normal, 2=clip color (math only), 1=no math (draw only), 0=nothing.
 
 	uint8	CW_color = 0, CW_math = 0;
-	uint8	CW = CalcWindowMask(5, W1, W2);
 
-	switch (Memory.FillRAM[0x2130] & 0xc0)
+	if (nowindows)
 	{
-		case 0x00:	CW_color = 0;		break;
-		case 0x40:	CW_color = ~CW;		break;
-		case 0x80:	CW_color = CW;		break;
-		case 0xc0:	CW_color = 0xff;	break;
+		// with the windows masked off only "always" clips, "outside" must not
+		// turn into the whole screen
+		if ((Memory.FillRAM[0x2130] & 0xc0) == 0xc0)
+			CW_color = 0xff;
+		if ((Memory.FillRAM[0x2130] & 0x30) == 0x30)
+			CW_math  = 0xff;
 	}
-
-	switch (Memory.FillRAM[0x2130] & 0x30)
+	else
 	{
-		case 0x00:	CW_math  = 0;		break;
-		case 0x10:	CW_math  = ~CW;		break;
-		case 0x20:	CW_math  = CW;		break;
-		case 0x30:	CW_math  = 0xff;	break;
+		uint8	CW = CalcWindowMask(5, W1, W2);
+
+		switch (Memory.FillRAM[0x2130] & 0xc0)
+		{
+			case 0x00:	CW_color = 0;		break;
+			case 0x40:	CW_color = ~CW;		break;
+			case 0x80:	CW_color = CW;		break;
+			case 0xc0:	CW_color = 0xff;	break;
+		}
+
+		switch (Memory.FillRAM[0x2130] & 0x30)
+		{
+			case 0x00:	CW_math  = 0;		break;
+			case 0x10:	CW_math  = ~CW;		break;
+			case 0x20:	CW_math  = CW;		break;
+			case 0x30:	CW_math  = 0xff;	break;
+		}
 	}
 
 	for (i = 0; i < n_regions; i++)
@@ -394,7 +414,7 @@ void S9xComputeClipWindows (void)
 
 	for (j = 0; j < 5; j++)
 	{
-		uint8	W = Settings.DisableGraphicWindows ? 0 : CalcWindowMask(j, W1, W2);
+		uint8	W = (Settings.DisableGraphicWindows || nowindows) ? 0 : CalcWindowMask(j, W1, W2);
 		for (int sub = 0; sub < 2; sub++)
 		{
 			if (Memory.FillRAM[sub + 0x212e] & (1 << j))
@@ -223,6 +223,7 @@ static void S9xSoftResetCPU (void)
 	CPU.MemSpeed = SLOW_ONE_CYCLE;
 	CPU.MemSpeedx2 = SLOW_ONE_CYCLE * 2;
 	CPU.FastROMSpeed = SLOW_ONE_CYCLE;
+	Memory.UpdateMemorySpeed();
 	CPU.InDMA = FALSE;
 	CPU.InHDMA = FALSE;
 	CPU.InDMAorHDMA = FALSE;
@@ -185,6 +185,7 @@
 #include "snapshot.h"
 #include "movie.h"
 #include "lua-engine.h"
+#include "audiocapture.h"
 #ifdef DEBUGGER
 #include "debug.h"
 #include "missing.h"
@@ -292,7 +293,7 @@ void S9xMainLoop (void)
 		{
 			uint8	*oldPCBase = CPU.PCBase;
 
-			CPU.PCBase = S9xGetBasePointer(ICPU.ShiftedPB + ((uint16) (Registers.PCw + 4)));
+			CPU.PCBase = S9xGetFetchBasePointer(ICPU.ShiftedPB + ((uint16) (Registers.PCw + 4)));
 			if (oldPCBase != CPU.PCBase || (Registers.PCw & ~MEMMAP_MASK) == (0xffff & ~MEMMAP_MASK))
 				Opcodes = S9xOpcodesSlow;
 		}
@@ -304,10 +305,11 @@ void S9xMainLoop (void)
 		Registers.PCw++;
 		(*Opcodes[Op].S9xOpcode)();
 
-		if (Settings.SA1)
+		if (Settings.SA1 && ++SA1.PendingSteps >= SA1.BatchSteps)
 			S9xSA1MainLoop();
 	}
 
+	S9xSA1Sync();
 	S9xPackStatus();
 
 	if (CPU.Flags & SCAN_KEYS_FLAG)
@@ -324,7 +326,7 @@ void S9xMainLoop (void)
 
 static inline void StartS9xMainLoop (void)
 {
-	extern bool8 pad_read, pad_read_last;
+	extern S9X_TLS bool8 pad_read, pad_read_last;
 	pad_read_last = pad_read;
 	pad_read      = FALSE;
 
@@ -339,7 +341,7 @@ static inline void StartS9xMainLoop (void)
 
 static inline void EndS9xMainLoop (void)
 {
-	extern bool8 pad_read;
+	extern S9X_TLS bool8 pad_read;
 	if(!pad_read)
 		IPPU.PadIgnoredFrames++;
 
@@ -407,6 +409,9 @@ void S9xDoHEventProcessing (void)
 			eventname[CPU.WhichEvent], CPU.NextEvent, CPU.Cycles);
 #endif
 
+	if (Settings.SA1)
+		S9xSA1Sync();
+
 	switch (CPU.WhichEvent)
 	{
 		case HC_HBLANK_START_EVENT:
@@ -471,6 +476,8 @@ void S9xDoHEventProcessing (void)
 				ICPU.Frame++;
 				PPU.HVBeamCounterLatched = 0;
 				CPU.Flags |= SCAN_KEYS_FLAG;
+
+				S9xAudioCaptureFrame();
 			}
 
 			// From byuu:
@@ -188,7 +188,7 @@
 #include "debug.h"
 #include "missing.h"
 
-extern SDMA	DMA[8];
+extern S9X_TLS SDMA	DMA[8];
 extern FILE	*apu_trace;
 FILE		*trace = NULL, *trace2 = NULL;
 
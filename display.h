@@ -202,6 +202,7 @@ void S9xUsage (void);
 char * S9xParseArgs (char **, int);
 void S9xLoadConfigFiles (char **, int);
 void S9xSetInfoString (const char *);
+bool8 S9xParseRenderMask (const char *, uint8 *);
 
 // Routines the port has to implement even if it doesn't use them
 
@@ -188,11 +188,11 @@
 
 #define ADD_CYCLES(n)	{ CPU.PrevCycles = CPU.Cycles; CPU.Cycles += (n); S9xCheckInterrupts(); }
 
-extern uint8	*HDMAMemPointers[8];
+extern S9X_TLS uint8	*HDMAMemPointers[8];
 extern int		HDMA_ModeByteCounts[8];
-extern SPC7110	s7emu;
+extern S9X_TLS SPC7110	s7emu;
 
-static uint8	sdd1_decode_buffer[0x10000];
+static S9X_TLS uint8	sdd1_decode_buffer[0x10000];
 
 static inline bool8 addCyclesInDMA (uint8);
 static inline bool8 HDMAReadLineCount (int);
@@ -223,6 +223,8 @@ static inline bool8 addCyclesInDMA (uint8 dma_channel)
 
 bool8 S9xDoDMA (uint8 Channel)
 {
+	S9xSA1Sync();
+
 	CPU.InDMA = TRUE;
     CPU.InDMAorHDMA = TRUE;
 	CPU.CurrentDMAorHDMAChannel = Channel;
@@ -182,8 +182,8 @@
 #include "missing.h"
 #endif
 
-uint8	(*GetDSP) (uint16)        = NULL;
-void	(*SetDSP) (uint8, uint16) = NULL;
+S9X_TLS uint8	(*GetDSP) (uint16)        = NULL;
+S9X_TLS void	(*SetDSP) (uint8, uint16) = NULL;
 
 
 void S9xResetDSP (void)
@@ -594,11 +594,11 @@ struct SDSP4
 	int16	OAM_Row[32];		// current number of tiles per row
 };
 
-extern struct SDSP0	DSP0;
-extern struct SDSP1	DSP1;
-extern struct SDSP2	DSP2;
-extern struct SDSP3	DSP3;
-extern struct SDSP4	DSP4;
+extern S9X_TLS struct SDSP0	DSP0;
+extern S9X_TLS struct SDSP1	DSP1;
+extern S9X_TLS struct SDSP2	DSP2;
+extern S9X_TLS struct SDSP3	DSP3;
+extern S9X_TLS struct SDSP4	DSP4;
 
 uint8 S9xGetDSP (uint16);
 void S9xSetDSP (uint8, uint16);
@@ -613,7 +613,7 @@ uint8 DSP4GetByte (uint16);
 void DSP4SetByte (uint8, uint16);
 void DSP3_Reset (void);
 
-extern uint8 (*GetDSP) (uint16);
-extern void (*SetDSP) (uint8, uint16);
+extern S9X_TLS uint8 (*GetDSP) (uint16);
+extern S9X_TLS void (*SetDSP) (uint8, uint16);
 
 #endif
@@ -176,10 +176,14 @@
  ***********************************************************************************/
 
 
+#ifdef USE_THREADS
+#include <pthread.h>
+#endif
 #include "snes9x.h"
 #include "blit.h"
 
 #define ALL_COLOR_MASK	(FIRST_COLOR_MASK | SECOND_COLOR_MASK | THIRD_COLOR_MASK)
+#define MAX_BLIT_THREADS	8
 
 #ifdef GFX_MULTI_FORMAT
 static uint16	lowPixelMask = 0, qlowPixelMask = 0, highBitsMask = 0;
@@ -194,6 +198,34 @@ static uint32	colorMask = 0;
 static snes_ntsc_t	*ntsc   = NULL;
 static uint8		*XDelta = NULL;
 
+struct SBlitBand
+{
+	void	(*filter) (uint8 *, uint32, uint8 *, uint32, int, int);
+	uint8	*src;
+	uint8	*dst;
+	uint32	srcPitch;
+	uint32	dstPitch;
+	int		width;
+	int		height;
+};
+
+static int			bandThreads = 1;
+
+#ifdef USE_THREADS
+// Worker i runs band i of every frame handed out; band 0 stays on the caller.
+static pthread_t		bandWorker[MAX_BLIT_THREADS - 1];
+static pthread_mutex_t	bandMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t	bandStart = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t	bandDone  = PTHREAD_COND_INITIALIZER;
+static SBlitBand		*bandJob   = NULL;
+static int				bandCount  = 0;		// bands in the current frame
+static int				bandBusy   = 0;		// workers still on it
+static uint32			bandSerial = 0;		// bumped for every frame
+static uint32			bandSeen[MAX_BLIT_THREADS];	// last frame each worker saw
+
+static void * BlitBandThread (void *);
+#endif
+
 
 bool8 S9xBlitFilterInit (void)
 {
@@ -220,6 +252,146 @@ void S9xBlitFilterDeinit (void)
 		delete[] XDelta;
 		XDelta = NULL;
 	}
+
+	S9xBlitSetThreads(1);
+}
+
+bool8 S9xBlitSetThreads (int n)
+{
+	bool8	clamped = n < 1 || n > MAX_BLIT_THREADS;
+
+	if (n < 1)
+		n = 1;
+	if (n > MAX_BLIT_THREADS)
+		n = MAX_BLIT_THREADS;
+
+#ifdef USE_THREADS
+	if (n < bandThreads)
+	{
+		int	old = bandThreads;
+
+		// workers at or past the new count see it and return
+		pthread_mutex_lock(&bandMutex);
+		bandThreads = n;
+		pthread_cond_broadcast(&bandStart);
+		pthread_mutex_unlock(&bandMutex);
+
+		for (int i = n; i < old; i++)
+			pthread_join(bandWorker[i - 1], NULL);
+	}
+
+	while (bandThreads < n)
+	{
+		pthread_mutex_lock(&bandMutex);
+		bandSeen[bandThreads] = bandSerial;
+		bandThreads++;
+		pthread_mutex_unlock(&bandMutex);
+
+		if (pthread_create(&bandWorker[bandThreads - 2], NULL, BlitBandThread, (void *) (pint) (bandThreads - 1)) != 0)
+		{
+			pthread_mutex_lock(&bandMutex);
+			bandThreads--;
+			pthread_mutex_unlock(&bandMutex);
+			return (FALSE);
+		}
+	}
+
+	return (!clamped);
+#else
+	return (!clamped && n == 1);
+#endif
+}
+
+int S9xBlitGetThreads (void)
+{
+	return (bandThreads);
+}
+
+static void BlitBandJob (struct SBlitBand *band)
+{
+	band->filter(band->src, band->srcPitch, band->dst, band->dstPitch, band->width, band->height);
+}
+
+#ifdef USE_THREADS
+static void * BlitBandThread (void *arg)
+{
+	int		i = (int) (pint) arg;
+	uint32	serial = bandSeen[i];
+
+	pthread_mutex_lock(&bandMutex);
+
+	while (i < bandThreads)
+	{
+		if (bandSerial == serial)
+		{
+			pthread_cond_wait(&bandStart, &bandMutex);
+			continue;
+		}
+
+		serial = bandSerial;
+		if (i >= bandCount)
+			continue;
+
+		pthread_mutex_unlock(&bandMutex);
+		BlitBandJob(&bandJob[i]);
+		pthread_mutex_lock(&bandMutex);
+
+		if (--bandBusy == 0)
+			pthread_cond_signal(&bandDone);
+	}
+
+	pthread_mutex_unlock(&bandMutex);
+
+	return (NULL);
+}
+#endif
+
+static void BlitBands (void (*filter) (uint8 *, uint32, uint8 *, uint32, int, int), int scale, uint8 *srcPtr, int srcRowBytes, uint8 *dstPtr, int dstRowBytes, int width, int height)
+{
+	// Bands still read the row above and below them from srcPtr, so the
+	// seams come out exactly as when the frame is done in one go.
+	struct SBlitBand	band[MAX_BLIT_THREADS];
+	int					n = bandThreads, rows;
+
+	if (n > height / 16)
+		n = height / 16 ? height / 16 : 1;
+	if (n == 1 || !S9xBlitHQ2xFilterPrepare())
+	{
+		filter(srcPtr, srcRowBytes, dstPtr, dstRowBytes, width, height);
+		return;
+	}
+
+	rows = height / n;
+
+	for (int i = 0; i < n; i++)
+	{
+		band[i].filter   = filter;
+		band[i].src      = srcPtr + i * rows * srcRowBytes;
+		band[i].dst      = dstPtr + i * rows * scale * dstRowBytes;
+		band[i].srcPitch = srcRowBytes;
+		band[i].dstPitch = dstRowBytes;
+		band[i].width    = width;
+		band[i].height   = (i == n - 1) ? height - i * rows : rows;
+	}
+
+#ifdef USE_THREADS
+	pthread_mutex_lock(&bandMutex);
+	bandJob   = band;
+	bandCount = n;
+	bandBusy  = n - 1;
+	bandSerial++;
+	pthread_cond_broadcast(&bandStart);
+	pthread_mutex_unlock(&bandMutex);
+#endif
+
+	BlitBandJob(&band[0]);
+
+#ifdef USE_THREADS
+	pthread_mutex_lock(&bandMutex);
+	while (bandBusy)
+		pthread_cond_wait(&bandDone, &bandMutex);
+	pthread_mutex_unlock(&bandMutex);
+#endif
 }
 
 void S9xBlitClearDelta (void)
@@ -689,17 +861,17 @@ void S9xBlitPixEPX16 (uint8 *srcPtr, int srcRowBytes, uint8 *dstPtr, int dstRowB
 
 void S9xBlitPixHQ2x16 (uint8 *srcPtr, int srcRowBytes, uint8 *dstPtr, int dstRowBytes, int width, int height)
 {
-	HQ2X_16(srcPtr, srcRowBytes, dstPtr, dstRowBytes, width, height);
+	BlitBands(HQ2X_16, 2, srcPtr, srcRowBytes, dstPtr, dstRowBytes, width, height);
 }
 
 void S9xBlitPixHQ3x16 (uint8 *srcPtr, int srcRowBytes, uint8 *dstPtr, int dstRowBytes, int width, int height)
 {
-	HQ3X_16(srcPtr, srcRowBytes, dstPtr, dstRowBytes, width, height);
+	BlitBands(HQ3X_16, 3, srcPtr, srcRowBytes, dstPtr, dstRowBytes, width, height);
 }
 
 void S9xBlitPixHQ4x16 (uint8 *srcPtr, int srcRowBytes, uint8 *dstPtr, int dstRowBytes, int width, int height)
 {
-	HQ4X_16(srcPtr, srcRowBytes, dstPtr, dstRowBytes, width, height);
+	BlitBands(HQ4X_16, 4, srcPtr, srcRowBytes, dstPtr, dstRowBytes, width, height);
 }
 
 void S9xBlitPixNTSC16 (uint8 *srcPtr, int srcRowBytes, uint8 *dstPtr, int dstRowBytes, int width, int height)
@@ -187,6 +187,10 @@
 bool8 S9xBlitFilterInit (void);
 void S9xBlitFilterDeinit (void);
 void S9xBlitClearDelta (void);
+// HQ filters run in this many horizontal bands at once, on worker threads
+// in builds with USE_THREADS. FALSE if that many can't be used.
+bool8 S9xBlitSetThreads (int);
+int S9xBlitGetThreads (void);
 bool8 S9xBlitNTSCFilterInit (void);
 void S9xBlitNTSCFilterDeinit (void);
 void S9xBlitNTSCFilterSet (const snes_ntsc_setup_t *);
@@ -180,6 +180,14 @@
 #include "gfx.h"
 #include "hq2x.h"
 
+#if !defined (HQ_SSE2) && (defined (__SSE2__) || defined (_M_X64))
+#define HQ_SSE2 1
+#endif
+
+#if HQ_SSE2
+#include <emmintrin.h>
+#endif
+
 #define	Ymask	0xFF0000
 #define	Umask	0x00FF00
 #define	Vmask	0x0000FF
@@ -507,22 +515,20 @@ static int	*RGBtoYUV = NULL;
 
 static void InitLUTs (void);
 static inline bool Diff (int, int);
+static inline uint32 Pattern (int, int, int, int, int, int, int, int, int);
 
 
 bool8 S9xBlitHQ2xFilterInit (void)
 {
-	uint32	n = 1 << ((FIRST_COLOR_MASK & 0x8000) ? 16 : 15);
-	RGBtoYUV = new int[n];
-	if (!RGBtoYUV)
-		return (FALSE);
+	// The table is left to S9xBlitHQ2xFilterPrepare(), so it only costs
+	// anything once an HQ filter is used, and is rebuilt for a new format.
+	S9xBlitHQ2xFilterDeinit();
 
 #ifdef GFX_MULTI_FORMAT
 	Mask_2 = SECOND_COLOR_MASK;
 	Mask13 = FIRST_THIRD_COLOR_MASK;
 #endif
 
-	InitLUTs();
-
 	return (TRUE);
 }
 
@@ -535,6 +541,21 @@ void S9xBlitHQ2xFilterDeinit (void)
 	}
 }
 
+bool8 S9xBlitHQ2xFilterPrepare (void)
+{
+	if (RGBtoYUV)
+		return (TRUE);
+
+	uint32	n = 1 << ((FIRST_COLOR_MASK & 0x8000) ? 16 : 15);
+	RGBtoYUV = new int[n];
+	if (!RGBtoYUV)
+		return (FALSE);
+
+	InitLUTs();
+
+	return (TRUE);
+}
+
 static void InitLUTs (void)
 {
 	uint32	r, g, b;
@@ -573,6 +594,39 @@ static inline bool Diff (int c1, int c2)
 	return (false);
 }
 
+static inline uint32 Pattern (int w1, int w2, int w3, int w4, int w5, int w6, int w7, int w8, int w9)
+{
+	// One bit for each of w1-w4 and w6-w9 that Diff() tells apart from w5.
+	// Y, U and V are a byte each, so SSE2 does all eight with byte maths.
+#if HQ_SSE2
+	__m128i	c = _mm_set1_epi32(RGBtoYUV[w5]);
+	__m128i	t = _mm_set1_epi32(trY | trU | trV);
+	__m128i	a = _mm_set_epi32(RGBtoYUV[w4], RGBtoYUV[w3], RGBtoYUV[w2], RGBtoYUV[w1]);
+	__m128i	b = _mm_set_epi32(RGBtoYUV[w9], RGBtoYUV[w8], RGBtoYUV[w7], RGBtoYUV[w6]);
+
+	a = _mm_subs_epu8(_mm_or_si128(_mm_subs_epu8(a, c), _mm_subs_epu8(c, a)), t);
+	b = _mm_subs_epu8(_mm_or_si128(_mm_subs_epu8(b, c), _mm_subs_epu8(c, b)), t);
+	a = _mm_cmpeq_epi32(a, _mm_setzero_si128());
+	b = _mm_cmpeq_epi32(b, _mm_setzero_si128());
+
+	return (~(_mm_movemask_ps(_mm_castsi128_ps(a)) | (_mm_movemask_ps(_mm_castsi128_ps(b)) << 4)) & 0xff);
+#else
+	int		y = RGBtoYUV[w5];
+	uint32	pattern = 0;
+
+	if ((w1 != w5) && (Diff(y, RGBtoYUV[w1]))) pattern |= (1 << 0);
+	if ((w2 != w5) && (Diff(y, RGBtoYUV[w2]))) pattern |= (1 << 1);
+	if ((w3 != w5) && (Diff(y, RGBtoYUV[w3]))) pattern |= (1 << 2);
+	if ((w4 != w5) && (Diff(y, RGBtoYUV[w4]))) pattern |= (1 << 3);
+	if ((w6 != w5) && (Diff(y, RGBtoYUV[w6]))) pattern |= (1 << 4);
+	if ((w7 != w5) && (Diff(y, RGBtoYUV[w7]))) pattern |= (1 << 5);
+	if ((w8 != w5) && (Diff(y, RGBtoYUV[w8]))) pattern |= (1 << 6);
+	if ((w9 != w5) && (Diff(y, RGBtoYUV[w9]))) pattern |= (1 << 7);
+
+	return (pattern);
+#endif
+}
+
 void HQ2X_16 (uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, int width, int height)
 {
 	register int	w1, w2, w3, w4, w5, w6, w7, w8, w9;
@@ -582,7 +636,10 @@ void HQ2X_16 (uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, in
 	register uint16	*dp = (uint16 *) dstPtr;
 
 	uint32  pattern;
-	int		l, y;
+	int		l;
+
+	if (!S9xBlitHQ2xFilterPrepare())
+		return;
 
 	while (height--)
 	{
@@ -606,17 +663,7 @@ void HQ2X_16 (uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, in
 			w6 = *(sp);
 			w9 = *(sp + src1line);
 
-			y = RGBtoYUV[w5];
-			pattern = 0;
-
-			if ((w1 != w5) && (Diff(y, RGBtoYUV[w1]))) pattern |= (1 << 0);
-			if ((w2 != w5) && (Diff(y, RGBtoYUV[w2]))) pattern |= (1 << 1);
-			if ((w3 != w5) && (Diff(y, RGBtoYUV[w3]))) pattern |= (1 << 2);
-			if ((w4 != w5) && (Diff(y, RGBtoYUV[w4]))) pattern |= (1 << 3);
-			if ((w6 != w5) && (Diff(y, RGBtoYUV[w6]))) pattern |= (1 << 4);
-			if ((w7 != w5) && (Diff(y, RGBtoYUV[w7]))) pattern |= (1 << 5);
-			if ((w8 != w5) && (Diff(y, RGBtoYUV[w8]))) pattern |= (1 << 6);
-			if ((w9 != w5) && (Diff(y, RGBtoYUV[w9]))) pattern |= (1 << 7);
+			pattern = Pattern(w1, w2, w3, w4, w5, w6, w7, w8, w9);
 
 			switch (pattern)
 			{
@@ -3281,7 +3328,10 @@ void HQ3X_16 (uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, in
 	register uint16	*dp = (uint16 *) dstPtr;
 
 	uint32  pattern;
-	int		l, y;
+	int		l;
+
+	if (!S9xBlitHQ2xFilterPrepare())
+		return;
 
 	while (height--)
 	{
@@ -3305,17 +3355,7 @@ void HQ3X_16 (uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, in
 			w6 = *(sp);
 			w9 = *(sp + src1line);
 
-			y = RGBtoYUV[w5];
-			pattern = 0;
-
-			if ((w1 != w5) && (Diff(y, RGBtoYUV[w1]))) pattern |= (1 << 0);
-			if ((w2 != w5) && (Diff(y, RGBtoYUV[w2]))) pattern |= (1 << 1);
-			if ((w3 != w5) && (Diff(y, RGBtoYUV[w3]))) pattern |= (1 << 2);
-			if ((w4 != w5) && (Diff(y, RGBtoYUV[w4]))) pattern |= (1 << 3);
-			if ((w6 != w5) && (Diff(y, RGBtoYUV[w6]))) pattern |= (1 << 4);
-			if ((w7 != w5) && (Diff(y, RGBtoYUV[w7]))) pattern |= (1 << 5);
-			if ((w8 != w5) && (Diff(y, RGBtoYUV[w8]))) pattern |= (1 << 6);
-			if ((w9 != w5) && (Diff(y, RGBtoYUV[w9]))) pattern |= (1 << 7);
+			pattern = Pattern(w1, w2, w3, w4, w5, w6, w7, w8, w9);
 
 			switch (pattern)
 			{
@@ -6953,7 +6993,10 @@ void HQ4X_16 (uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, in
 	register uint16	*dp = (uint16 *) dstPtr;
 
 	uint32  pattern;
-	int		l, y;
+	int		l;
+
+	if (!S9xBlitHQ2xFilterPrepare())
+		return;
 
 	while (height--)
 	{
@@ -6977,17 +7020,7 @@ void HQ4X_16 (uint8 *srcPtr, uint32 srcPitch, uint8 *dstPtr, uint32 dstPitch, in
 			w6 = *(sp);
 			w9 = *(sp + src1line);
 
-			y = RGBtoYUV[w5];
-			pattern = 0;
-
-			if ((w1 != w5) && (Diff(y, RGBtoYUV[w1]))) pattern |= (1 << 0);
-			if ((w2 != w5) && (Diff(y, RGBtoYUV[w2]))) pattern |= (1 << 1);
-			if ((w3 != w5) && (Diff(y, RGBtoYUV[w3]))) pattern |= (1 << 2);
-			if ((w4 != w5) && (Diff(y, RGBtoYUV[w4]))) pattern |= (1 << 3);
-			if ((w6 != w5) && (Diff(y, RGBtoYUV[w6]))) pattern |= (1 << 4);
-			if ((w7 != w5) && (Diff(y, RGBtoYUV[w7]))) pattern |= (1 << 5);
-			if ((w8 != w5) && (Diff(y, RGBtoYUV[w8]))) pattern |= (1 << 6);
-			if ((w9 != w5) && (Diff(y, RGBtoYUV[w9]))) pattern |= (1 << 7);
+			pattern = Pattern(w1, w2, w3, w4, w5, w6, w7, w8, w9);
 
 			switch (pattern)
 			{
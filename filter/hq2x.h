@@ -181,6 +181,9 @@
 
 bool8 S9xBlitHQ2xFilterInit (void);
 void S9xBlitHQ2xFilterDeinit (void);
+// builds the YUV table on first use, which HQ*X_16 do themselves;
+// call it first when they are to run on several threads at once
+bool8 S9xBlitHQ2xFilterPrepare (void);
 void HQ2X_16 (uint8 *, uint32, uint8 *, uint32, int, int);
 void HQ3X_16 (uint8 *, uint32, uint8 *, uint32, int, int);
 void HQ4X_16 (uint8 *, uint32, uint8 *, uint32, int, int);
@@ -384,6 +384,8 @@ static void FxReset (struct FxInfo_s *psFxInfo)
 	// Set pointer to GSU cache
 	GSU.pvCache = &GSU.pvRegisters[0x100];
 
+	fx_invalidateDecodeCache();
+
 	fx_readRegisterSpace();
 }
 
@@ -587,6 +589,8 @@ static uint32 FxEmulate (uint32 nInstructions)
 
 void fx_computeScreenPointers (void)
 {
+	FX_FLUSH_PIXELS;
+
 	if (GSU.vMode != GSU.vPrevMode || GSU.vPrevScreenHeight != GSU.vScreenHeight || GSU.vSCBRDirty)
 	{
 		GSU.vSCBRDirty = FALSE;
@@ -757,6 +761,7 @@ static void FxFlushCache (void)
 	GSU.vCacheFlags = 0;
 	GSU.vCacheBaseReg = 0;
 	GSU.bCacheActive = FALSE;
+	fx_invalidateDecodeCache();
 	//GSU.vPipe = 0x1;
 }
 
@@ -195,7 +195,7 @@ struct FxInfo_s
 	bool8	oneLineDone;
 };
 
-extern struct FxInfo_s	SuperFX;
+extern S9X_TLS struct FxInfo_s	SuperFX;
 
 void S9xInitSuperFX (void);
 void S9xResetSuperFX (void);
@@ -203,6 +203,8 @@ void S9xSuperFXExec (void);
 void S9xSetSuperFX (uint8, uint16);
 uint8 S9xGetSuperFX (uint16);
 void fx_flushCache (void);
+void fx_invalidateDecodeCache (void);
+void fx_flushPixelCache (void);
 void fx_computeScreenPointers (void);
 uint32 fx_run (uint32);
 
@@ -566,6 +566,7 @@ static void fx_with_r15 (void)
 // 30-3b - stw (rn) - store word
 #define FX_STW(reg) \
 	GSU.vLastRamAdr = GSU.avReg[reg]; \
+	FX_FLUSH_PIXELS; \
 	RAM(GSU.avReg[reg]) = (uint8) SREG; \
 	RAM(GSU.avReg[reg] ^ 1) = (uint8) (SREG >> 8); \
 	CLRFLAGS; \
@@ -634,6 +635,7 @@ static void fx_stw_r11 (void)
 // 30-3b (ALT1) - stb (rn) - store byte
 #define FX_STB(reg) \
 	GSU.vLastRamAdr = GSU.avReg[reg]; \
+	FX_FLUSH_PIXELS; \
 	RAM(GSU.avReg[reg]) = (uint8) SREG; \
 	CLRFLAGS; \
 	R15++
@@ -738,6 +740,7 @@ static void fx_alt3 (void)
 #define FX_LDW(reg) \
 	uint32	v; \
 	GSU.vLastRamAdr = GSU.avReg[reg]; \
+	FX_FLUSH_PIXELS; \
 	v = (uint32) RAM(GSU.avReg[reg]); \
 	v |= ((uint32) RAM(GSU.avReg[reg] ^ 1)) << 8; \
 	R15++; \
@@ -809,6 +812,7 @@ static void fx_ldw_r11 (void)
 #define FX_LDB(reg) \
 	uint32	v; \
 	GSU.vLastRamAdr = GSU.avReg[reg]; \
+	FX_FLUSH_PIXELS; \
 	v = (uint32) RAM(GSU.avReg[reg]); \
 	R15++; \
 	DREG = v; \
@@ -875,13 +879,54 @@ static void fx_ldb_r11 (void)
 	FX_LDB(11);
 }
 
+// Pixel cache
+// Plots land in an 8 pixel row buffer, like the GSU's own pixel cache, and are written to the
+// screen a whole bitplane byte at a time when a plot moves to another row, or before anything
+// else touches GSU RAM.
+
+static const uint8	fx_PlaneOffset[8] = { 0x00, 0x01, 0x10, 0x11, 0x20, 0x21, 0x30, 0x31 };
+
+void fx_flushPixelCache (void)
+{
+	uint8	*a = GSU.pvPixelCache;
+	uint8	m = (uint8) GSU.vPixelCacheMask;
+
+	for (uint32 i = 0; i < GSU.vPixelCachePlanes; i++)
+		a[fx_PlaneOffset[i]] = (a[fx_PlaneOffset[i]] & ~m) | (GSU.avPixelCacheBits[i] & m);
+
+	GSU.vPixelCacheMask = 0;
+}
+
+static inline void fx_cachePixel (uint32 x, uint32 y, uint8 c, const uint32 nPlanes)
+{
+	uint32	vKey = (y << 8) | (x & 0xf8);
+	uint8	v = 128 >> (x & 7);
+
+	if (vKey != GSU.vPixelCacheKey || !GSU.vPixelCacheMask)
+	{
+		FX_FLUSH_PIXELS;
+		GSU.pvPixelCache = GSU.apvScreen[y >> 3] + GSU.x[x >> 3] + ((y & 7) << 1);
+		GSU.vPixelCacheKey = vKey;
+		GSU.vPixelCachePlanes = nPlanes;
+	}
+
+	GSU.vPixelCacheMask |= v;
+
+	for (uint32 i = 0; i < nPlanes; i++)
+	{
+		if (c & (1 << i))
+			GSU.avPixelCacheBits[i] |=  v;
+		else
+			GSU.avPixelCacheBits[i] &= ~v;
+	}
+}
+
 // 4c - plot - plot pixel with R1, R2 as x, y and the color register as the color
 static void fx_plot_2bit (void)
 {
 	uint32	x = USEX8(R1);
 	uint32	y = USEX8(R2);
-	uint8	*a;
-	uint8	v, c;
+	uint8	c;
 
 	R15++;
 	CLRFLAGS;
@@ -900,18 +945,7 @@ static void fx_plot_2bit (void)
 	if (!(GSU.vPlotOptionReg & 0x01) && !(c & 0xf))
 		return;
 
-	a = GSU.apvScreen[y >> 3] + GSU.x[x >> 3] + ((y & 7) << 1);
-	v = 128 >> (x & 7);
-
-	if (c & 0x01)
-		a[0] |=  v;
-	else
-		a[0] &= ~v;
-
-	if (c & 0x02)
-		a[1] |=  v;
-	else
-		a[1] &= ~v;
+	fx_cachePixel(x, y, c, 2);
 }
 
 // 4c (ALT1) - rpix - read color of the pixel with R1, R2 as x, y
@@ -930,6 +964,8 @@ static void fx_rpix_2bit (void)
 		return;
 #endif
 
+	FX_FLUSH_PIXELS;
+
 	a = GSU.apvScreen[y >> 3] + GSU.x[x >> 3] + ((y & 7) << 1);
 	v = 128 >> (x & 7);
 
@@ -944,8 +980,7 @@ static void fx_plot_4bit (void)
 {
 	uint32	x = USEX8(R1);
 	uint32	y = USEX8(R2);
-	uint8	*a;
-	uint8	v, c;
+	uint8	c;
 
 	R15++;
 	CLRFLAGS;
@@ -964,28 +999,7 @@ static void fx_plot_4bit (void)
 	if (!(GSU.vPlotOptionReg & 0x01) && !(c & 0xf))
 		return;
 
-	a = GSU.apvScreen[y >> 3] + GSU.x[x >> 3] + ((y & 7) << 1);
-	v = 128 >> (x & 7);
-
-	if (c & 0x01)
-		a[0x00] |=  v;
-	else
-		a[0x00] &= ~v;
-
-	if (c & 0x02)
-		a[0x01] |=  v;
-	else
-		a[0x01] &= ~v;
-
-	if (c & 0x04)
-		a[0x10] |=  v;
-	else
-		a[0x10] &= ~v;
-
-	if (c & 0x08)
-		a[0x11] |=  v;
-	else
-		a[0x11] &= ~v;
+	fx_cachePixel(x, y, c, 4);
 }
 
 // 4c (ALT1) - rpix - read color of the pixel with R1, R2 as x, y
@@ -1004,6 +1018,8 @@ static void fx_rpix_4bit (void)
 		return;
 #endif
 
+	FX_FLUSH_PIXELS;
+
 	a = GSU.apvScreen[y >> 3] + GSU.x[x >> 3] + ((y & 7) << 1);
 	v = 128 >> (x & 7);
 
@@ -1020,8 +1036,7 @@ static void fx_plot_8bit (void)
 {
 	uint32	x = USEX8(R1);
 	uint32	y = USEX8(R2);
-	uint8	*a;
-	uint8	v, c;
+	uint8	c;
 
 	R15++;
 	CLRFLAGS;
@@ -1042,48 +1057,7 @@ static void fx_plot_8bit (void)
 	if (!(GSU.vPlotOptionReg & 0x01) && !c)
 		return;
 
-	a = GSU.apvScreen[y >> 3] + GSU.x[x >> 3] + ((y & 7) << 1);
-	v = 128 >> (x & 7);
-
-	if (c & 0x01)
-		a[0x00] |=  v;
-	else
-		a[0x00] &= ~v;
-
-	if (c & 0x02)
-		a[0x01] |=  v;
-	else
-		a[0x01] &= ~v;
-
-	if (c & 0x04)
-		a[0x10] |=  v;
-	else
-		a[0x10] &= ~v;
-
-	if (c & 0x08)
-		a[0x11] |=  v;
-	else
-		a[0x11] &= ~v;
-
-	if (c & 0x10)
-		a[0x20] |=  v;
-	else
-		a[0x20] &= ~v;
-
-	if (c & 0x20)
-		a[0x21] |=  v;
-	else
-		a[0x21] &= ~v;
-
-	if (c & 0x40)
-		a[0x30] |=  v;
-	else
-		a[0x30] &= ~v;
-
-	if (c & 0x80)
-		a[0x31] |=  v;
-	else
-		a[0x31] &= ~v;
+	fx_cachePixel(x, y, c, 8);
 }
 
 // 4c (ALT1) - rpix - read color of the pixel with R1, R2 as x, y
@@ -1102,6 +1076,8 @@ static void fx_rpix_8bit (void)
 		return;
 #endif
 
+	FX_FLUSH_PIXELS;
+
 	a = GSU.apvScreen[y >> 3] + GSU.x[x >> 3] + ((y & 7) << 1);
 	v = 128 >> (x & 7);
 
@@ -2645,6 +2621,7 @@ static void fx_umult_i15 (void)
 // 90 - sbk - store word to last accessed RAM address
 static void fx_sbk (void)
 {
+	FX_FLUSH_PIXELS;
 	RAM(GSU.vLastRamAdr) = (uint8) SREG;
 	RAM(GSU.vLastRamAdr ^ 1) = (uint8) (SREG >> 8);
 	CLRFLAGS;
@@ -2948,6 +2925,7 @@ static void fx_ibt_r15 (void)
 	R15++; \
 	FETCHPIPE; \
 	R15++; \
+	FX_FLUSH_PIXELS; \
 	GSU.avReg[reg] = (uint32) RAM(GSU.vLastRamAdr); \
 	GSU.avReg[reg] |= ((uint32) RAM(GSU.vLastRamAdr + 1)) << 8; \
 	CLRFLAGS
@@ -3040,6 +3018,7 @@ static void fx_lms_r15 (void)
 	GSU.vLastRamAdr = ((uint32) PIPE) << 1; \
 	R15++; \
 	FETCHPIPE; \
+	FX_FLUSH_PIXELS; \
 	RAM(GSU.vLastRamAdr) = (uint8) v; \
 	RAM(GSU.vLastRamAdr + 1) = (uint8) (v >> 8); \
 	CLRFLAGS; \
@@ -3953,6 +3932,7 @@ static void fx_iwt_r15 (void)
 	GSU.vLastRamAdr |= USEX8(PIPE) << 8; \
 	FETCHPIPE; \
 	R15++; \
+	FX_FLUSH_PIXELS; \
 	GSU.avReg[reg] = RAM(GSU.vLastRamAdr); \
 	GSU.avReg[reg] |= USEX8(RAM(GSU.vLastRamAdr ^ 1)) << 8; \
 	CLRFLAGS
@@ -4048,6 +4028,7 @@ static void fx_lm_r15 (void)
 	R15++; \
 	GSU.vLastRamAdr |= USEX8(PIPE) << 8; \
 	FETCHPIPE; \
+	FX_FLUSH_PIXELS; \
 	RAM(GSU.vLastRamAdr) = (uint8) v; \
 	RAM(GSU.vLastRamAdr ^ 1) = (uint8) (v >> 8); \
 	CLRFLAGS; \
@@ -4133,6 +4114,107 @@ static void fx_sm_r15 (void)
 	FX_SM(15);
 }
 
+// Predecoded prefix cache
+// alt1/alt2/alt3/with/to/from only change the decoding state of the next opcode, and GSU code
+// runs them in front of almost every instruction. A run of prefixes starting from the clean state
+// is decoded once into the resulting SFR bits and Sreg/Dreg indices, then folded in a single step.
+// Entries are keyed on the program bank and R15, so only ROM banks are cached; code in the
+// GSU RAM banks can be rewritten and always goes through the plain interpreter.
+
+#define FX_DECODE_CACHE_SIZE	8192
+#define FX_DECODE_MAX_PREFIX	4
+
+struct FxDecodedOp_s
+{
+	uint32	vTag;		// (generation << 24) | (program bank << 16) | R15
+	uint8	vFirst;		// prefix opcode in the pipe
+	uint8	nPrefix;	// number of folded prefixes
+	uint8	vSreg;
+	uint8	vDreg;
+	uint32	vFlags;		// resulting ALT1/ALT2/B bits
+};
+
+static S9X_TLS struct FxDecodedOp_s	fx_DecodeCache[FX_DECODE_CACHE_SIZE];
+static S9X_TLS uint32				fx_DecodeGeneration = 1;
+
+void fx_invalidateDecodeCache (void)
+{
+	fx_DecodeGeneration = (fx_DecodeGeneration + 1) & 0xff;
+
+	if (fx_DecodeGeneration == 0)
+	{
+		// tags of old generations would alias after wrapping, so start over
+		memset(fx_DecodeCache, 0, sizeof(fx_DecodeCache));
+		fx_DecodeGeneration = 1;
+	}
+}
+
+static inline bool8 fx_isPrefix (uint8 op)
+{
+	return ((op >= 0x10 && op <= 0x2f) || (op >= 0x3d && op <= 0x3f) || (op & 0xf0) == 0xb0);
+}
+
+static void fx_decodePrefixes (struct FxDecodedOp_s *d, uint32 vTag)
+{
+	uint32	vFlags = 0, vSreg = 0, vDreg = 0, n = 0;
+	uint8	op = PIPE;
+
+	// Same state machine as the prefix handlers, starting from CLRFLAGS.
+	// The byte following the n-th prefix is at R15 + n - 1.
+	while (n < FX_DECODE_MAX_PREFIX)
+	{
+		if (op >= 0x3d && op <= 0x3f)
+		{
+			vFlags &= ~FLG_B;
+			vFlags |= (op - 0x3c) << 8;
+		}
+		else
+		if (op >= 0x20 && op <= 0x2f)
+		{
+			vFlags |= FLG_B;
+			vSreg = vDreg = op & 0xf;
+		}
+		else
+		if (op >= 0x10 && op <= 0x1f && !(vFlags & FLG_B))
+			vDreg = op & 0xf;
+		else
+		if ((op & 0xf0) == 0xb0 && !(vFlags & FLG_B))
+			vSreg = op & 0xf;
+		else
+			break;
+
+		op = PRGBANK(R15 + n);
+		n++;
+	}
+
+	d->vTag    = vTag;
+	d->vFirst  = PIPE;
+	d->nPrefix = n;
+	d->vSreg   = vSreg;
+	d->vDreg   = vDreg;
+	d->vFlags  = vFlags;
+}
+
+static inline void fx_runPrefixes (void)
+{
+	uint32					vTag = (fx_DecodeGeneration << 24) | (USEX8(PBR) << 16) | USEX16(R15);
+	struct FxDecodedOp_s	*d = &fx_DecodeCache[(R15 ^ (PBR << 7)) & (FX_DECODE_CACHE_SIZE - 1)];
+
+	if (d->vTag != vTag || d->vFirst != PIPE)
+		fx_decodePrefixes(d, vTag);
+
+	// The prefixes still count against the instruction budget
+	if (GSU.vCounter < d->nPrefix)
+		return;
+
+	GSU.vCounter -= d->nPrefix;
+	GSU.vStatusReg |= d->vFlags;
+	GSU.pvSreg = &GSU.avReg[d->vSreg];
+	GSU.pvDreg = &GSU.avReg[d->vDreg];
+	R15 += d->nPrefix;
+	PIPE = PRGBANK(R15 - 1);
+}
+
 // GSU executions functions
 
 uint32 fx_run (uint32 nInstructions)
@@ -4140,7 +4222,15 @@ uint32 fx_run (uint32 nInstructions)
 	GSU.vCounter = nInstructions;
 	READR14;
 	while (TF(G) && (GSU.vCounter-- > 0))
+	{
+		if (fx_isPrefix(PIPE) && !(GSU.vStatusReg & (FLG_ALT1 | FLG_ALT2 | FLG_B)) &&
+			GSU.pvSreg == &R0 && GSU.pvDreg == &R0 && (PBR & 0x7c) != 0x70 && !Settings.DisableGSUPrefixCache)
+			fx_runPrefixes();
+
 		FX_STEP;
+	}
+
+	FX_FLUSH_PIXELS;
 #if 0
 #ifndef FX_ADDRESS_CHECK
 	GSU.vPipeAdr = USEX16(R15 - 1) | (USEX8(GSU.vPrgBankReg) << 16);
@@ -4217,7 +4307,7 @@ void (*fx_PlotTable[]) (void) =
 
 // Opcode table
 
-void (*fx_OpcodeTable[]) (void) =
+S9X_TLS void (*fx_OpcodeTable[]) (void) =
 {
 	// ALT0 Table
 
@@ -357,6 +357,12 @@ struct FxRegs_s
 	void	(*pfPlot) (void);
 	void	(*pfRpix) (void);
 
+	uint8	*pvPixelCache;				// Screen row the pixel cache belongs to
+	uint32	vPixelCacheKey;				// (y << 8) | (x & 0xf8) of the cached row
+	uint32	vPixelCacheMask;			// Pixels plotted into the cached row
+	uint32	vPixelCachePlanes;			// Number of bitplanes to write back
+	uint8	avPixelCacheBits[8];		// Bitplane bytes of the plotted pixels
+
 	uint8	*pvRamBank;					// Pointer to current RAM-bank
 	uint8	*pvRomBank;					// Pointer to current ROM-bank
 	uint8	*pvPrgBank;					// Pointer to current program ROM-bank
@@ -374,7 +380,7 @@ struct FxRegs_s
 	uint8	*avRegAddr;					// To reference avReg in snapshot.cpp
 };
 
-extern struct FxRegs_s	GSU;
+extern S9X_TLS struct FxRegs_s	GSU;
 
 // GSU registers
 #define GSU_R0			0x000
@@ -534,8 +540,13 @@ extern struct FxRegs_s	GSU;
 	(*fx_OpcodeTable[(GSU.vStatusReg & 0x300) | vOpcode])(); \
 }
 
+// Write pending plots to the screen before anything else looks at GSU RAM
+#define FX_FLUSH_PIXELS \
+	if (GSU.vPixelCacheMask) \
+		fx_flushPixelCache()
+
 extern void (*fx_PlotTable[]) (void);
-extern void (*fx_OpcodeTable[]) (void);
+extern S9X_TLS void (*fx_OpcodeTable[]) (void);
 
 // Set this define if branches are relative to the instruction in the delay slot (I think they are)
 #define BRANCH_DELAY_RELATIVE
@@ -212,7 +212,7 @@
 			S9xDoHEventProcessing(); \
 	}
 
-extern uint8	OpenBus;
+extern S9X_TLS uint8	OpenBus;
 
 static inline int32 memory_speed (uint32 address)
 {
@@ -237,7 +237,7 @@ inline uint8 S9xGetByteQuiet (uint32 Address)
 {
 	int		block = (Address & 0xffffff) >> MEMMAP_SHIFT;
 	uint8	*GetAddress = Memory.Map[block];
-	int32	speed = memory_speed(Address);
+	int32	speed = Memory.MemorySpeed[block];
 	uint8	byte;
 
 	if (GetAddress >= (uint8 *) CMemory::MAP_LAST)
@@ -250,6 +250,7 @@ inline uint8 S9xGetByteQuiet (uint32 Address)
 	switch ((pint) GetAddress)
 	{
 		case CMemory::MAP_CPU:
+			speed = memory_speed(Address);
 			byte = S9xGetCPU(Address & 0xffff);
 			addCyclesInMemoryAccess;
 			return (byte);
@@ -284,10 +285,23 @@ inline uint8 S9xGetByteQuiet (uint32 Address)
 			return (byte);
 
 		case CMemory::MAP_BWRAM:
+			S9xSA1Sync();
 			byte = *(Memory.BWRAM + ((Address & 0x7fff) - 0x6000));
 			addCyclesInMemoryAccess;
 			return (byte);
 
+		case CMemory::MAP_BWRAM_LINEAR:
+			S9xSA1Sync();
+			byte = *(Memory.SRAM + ((Address & 0x10000) | (Address & 0xffff)));
+			addCyclesInMemoryAccess;
+			return (byte);
+
+		case CMemory::MAP_IRAM:
+			S9xSA1Sync();
+			byte = Memory.FillRAM[Address & 0xffff];
+			addCyclesInMemoryAccess;
+			return (byte);
+
 		case CMemory::MAP_DSP:
 			byte = S9xGetDSP(Address & 0xffff);
 			addCyclesInMemoryAccess;
@@ -365,7 +379,7 @@ inline uint16 S9xGetWordQuiet (uint32 Address, enum s9xwrap_t w = WRAP_NONE)
 
 	int		block = (Address & 0xffffff) >> MEMMAP_SHIFT;
 	uint8	*GetAddress = Memory.Map[block];
-	int32	speed = memory_speed(Address);
+	int32	speed = Memory.MemorySpeed[block];
 	uint16	word;
 
 	if (GetAddress >= (uint8 *) CMemory::MAP_LAST)
@@ -378,6 +392,7 @@ inline uint16 S9xGetWordQuiet (uint32 Address, enum s9xwrap_t w = WRAP_NONE)
 	switch ((pint) GetAddress)
 	{
 		case CMemory::MAP_CPU:
+			speed = memory_speed(Address);
 			word  = S9xGetCPU(Address & 0xffff);
 			addCyclesInMemoryAccess;
 			word |= S9xGetCPU((Address + 1) & 0xffff) << 8;
@@ -427,10 +442,23 @@ inline uint16 S9xGetWordQuiet (uint32 Address, enum s9xwrap_t w = WRAP_NONE)
 			return (word);
 
 		case CMemory::MAP_BWRAM:
+			S9xSA1Sync();
 			word = READ_WORD(Memory.BWRAM + ((Address & 0x7fff) - 0x6000));
 			addCyclesInMemoryAccess_x2;
 			return (word);
 
+		case CMemory::MAP_BWRAM_LINEAR:
+			S9xSA1Sync();
+			word = READ_WORD(Memory.SRAM + ((Address & 0x10000) | (Address & 0xffff)));
+			addCyclesInMemoryAccess_x2;
+			return (word);
+
+		case CMemory::MAP_IRAM:
+			S9xSA1Sync();
+			word = READ_WORD(Memory.FillRAM + (Address & 0xffff));
+			addCyclesInMemoryAccess_x2;
+			return (word);
+
 		case CMemory::MAP_DSP:
 			word  = S9xGetDSP(Address & 0xffff);
 			addCyclesInMemoryAccess;
@@ -499,7 +527,7 @@ inline void S9xSetByteQuiet (uint8 Byte, uint32 Address)
 {
 	int		block = (Address & 0xffffff) >> MEMMAP_SHIFT;
 	uint8	*SetAddress = Memory.WriteMap[block];
-	int32	speed = memory_speed(Address);
+	int32	speed = Memory.MemorySpeed[block];
 
 	if (SetAddress >= (uint8 *) CMemory::MAP_LAST)
 	{
@@ -511,6 +539,7 @@ inline void S9xSetByteQuiet (uint8 Byte, uint32 Address)
 	switch ((pint) SetAddress)
 	{
 		case CMemory::MAP_CPU:
+			speed = memory_speed(Address);
 			S9xSetCPU(Byte, Address & 0xffff);
 			addCyclesInMemoryAccess;
 			return;
@@ -554,11 +583,25 @@ inline void S9xSetByteQuiet (uint8 Byte, uint32 Address)
 			return;
 
 		case CMemory::MAP_BWRAM:
+			S9xSA1Sync();
 			*(Memory.BWRAM + ((Address & 0x7fff) - 0x6000)) = Byte;
 			CPU.SRAMModified = TRUE;
 			addCyclesInMemoryAccess;
 			return;
 
+		case CMemory::MAP_BWRAM_LINEAR:
+			S9xSA1Sync();
+			*(Memory.SRAM + ((Address & 0x10000) | (Address & 0xffff))) = Byte;
+			CPU.SRAMModified = TRUE;
+			addCyclesInMemoryAccess;
+			return;
+
+		case CMemory::MAP_IRAM:
+			S9xSA1Sync();
+			Memory.FillRAM[Address & 0xffff] = Byte;
+			addCyclesInMemoryAccess;
+			return;
+
 		case CMemory::MAP_SA1RAM:
 			*(Memory.SRAM + (Address & 0xffff)) = Byte;
 			addCyclesInMemoryAccess;
@@ -639,7 +682,7 @@ inline void S9xSetWordQuiet (uint16 Word, uint32 Address, enum s9xwrap_t w = WRA
 
 	int		block = (Address & 0xffffff) >> MEMMAP_SHIFT;
 	uint8	*SetAddress = Memory.WriteMap[block];
-	int32	speed = memory_speed(Address);
+	int32	speed = Memory.MemorySpeed[block];
 
 	if (SetAddress >= (uint8 *) CMemory::MAP_LAST)
 	{
@@ -651,6 +694,7 @@ inline void S9xSetWordQuiet (uint16 Word, uint32 Address, enum s9xwrap_t w = WRA
 	switch ((pint) SetAddress)
 	{
 		case CMemory::MAP_CPU:
+			speed = memory_speed(Address);
 			if (o)
 			{
 				S9xSetCPU(Word >> 8, (Address + 1) & 0xffff);
@@ -747,11 +791,25 @@ inline void S9xSetWordQuiet (uint16 Word, uint32 Address, enum s9xwrap_t w = WRA
 			return;
 
 		case CMemory::MAP_BWRAM:
+			S9xSA1Sync();
 			WRITE_WORD(Memory.BWRAM + ((Address & 0x7fff) - 0x6000), Word);
 			CPU.SRAMModified = TRUE;
 			addCyclesInMemoryAccess_x2;
 			return;
 
+		case CMemory::MAP_BWRAM_LINEAR:
+			S9xSA1Sync();
+			WRITE_WORD(Memory.SRAM + ((Address & 0x10000) | (Address & 0xffff)), Word);
+			CPU.SRAMModified = TRUE;
+			addCyclesInMemoryAccess_x2;
+			return;
+
+		case CMemory::MAP_IRAM:
+			S9xSA1Sync();
+			WRITE_WORD(Memory.FillRAM + (Address & 0xffff), Word);
+			addCyclesInMemoryAccess_x2;
+			return;
+
 		case CMemory::MAP_SA1RAM:
 			WRITE_WORD(Memory.SRAM + (Address & 0xffff), Word);
 			addCyclesInMemoryAccess_x2;
@@ -947,7 +1005,10 @@ inline void S9xSetPCBase (uint32 Address)
 			return;
 
 		case CMemory::MAP_BWRAM:
-			CPU.PCBase = Memory.BWRAM - 0x6000 - (Address & 0x8000);
+		case CMemory::MAP_BWRAM_LINEAR:
+		case CMemory::MAP_IRAM:
+			// fetch through S9xGetByte() so that the SA-1 is caught up first
+			CPU.PCBase = NULL;
 			return;
 
 		case CMemory::MAP_SA1RAM:
@@ -1002,8 +1063,17 @@ inline uint8 * S9xGetBasePointer (uint32 Address)
 			return (Memory.SRAM + (((Address & 0x7fff) - 0x6000 + ((Address & 0xf0000) >> 3)) & Memory.SRAMMask) - (Address & 0xffff));
 
 		case CMemory::MAP_BWRAM:
+			S9xSA1Sync();
 			return (Memory.BWRAM - 0x6000 - (Address & 0x8000));
 
+		case CMemory::MAP_BWRAM_LINEAR:
+			S9xSA1Sync();
+			return (Memory.SRAM + (Address & 0x10000));
+
+		case CMemory::MAP_IRAM:
+			S9xSA1Sync();
+			return (Memory.FillRAM);
+
 		case CMemory::MAP_SA1RAM:
 			return (Memory.SRAM);
 
@@ -1022,6 +1092,23 @@ inline uint8 * S9xGetBasePointer (uint32 Address)
 	}
 }
 
+// Like S9xGetBasePointer(), but the memory the SA-1 shares with the S-CPU has
+// no base, as in S9xSetPCBase(), so opcodes there are fetched through
+// S9xGetByte() which catches the SA-1 up first.
+inline uint8 * S9xGetFetchBasePointer (uint32 Address)
+{
+	switch ((pint) Memory.Map[(Address & 0xffffff) >> MEMMAP_SHIFT])
+	{
+		case CMemory::MAP_BWRAM:
+		case CMemory::MAP_BWRAM_LINEAR:
+		case CMemory::MAP_IRAM:
+			return (NULL);
+
+		default:
+			return (S9xGetBasePointer(Address));
+	}
+}
+
 inline uint8 * S9xGetMemPointer (uint32 Address)
 {
 	uint8	*GetAddress = Memory.Map[(Address & 0xffffff) >> MEMMAP_SHIFT];
@@ -1047,8 +1134,17 @@ inline uint8 * S9xGetMemPointer (uint32 Address)
 			return (Memory.SRAM + (((Address & 0x7fff) - 0x6000 + ((Address & 0xf0000) >> 3)) & Memory.SRAMMask));
 
 		case CMemory::MAP_BWRAM:
+			S9xSA1Sync();
 			return (Memory.BWRAM - 0x6000 + (Address & 0x7fff));
 
+		case CMemory::MAP_BWRAM_LINEAR:
+			S9xSA1Sync();
+			return (Memory.SRAM + ((Address & 0x10000) | (Address & 0xffff)));
+
+		case CMemory::MAP_IRAM:
+			S9xSA1Sync();
+			return (Memory.FillRAM + (Address & 0xffff));
+
 		case CMemory::MAP_SA1RAM:
 			return (Memory.SRAM + (Address & 0xffff));
 
@@ -186,14 +186,17 @@
 #include "screenshot.h"
 #include "font.h"
 #include "display.h"
+#ifdef S9X_MULTI_INSTANCE
+#include "context.h"
+#endif
 
 #ifdef HAVE_LUA
 #include "lua-engine.h"
 #endif
 
-extern struct SCheatData		Cheat;
-extern struct SLineData			LineData[240];
-extern struct SLineMatrixData	LineMatrixData[240];
+extern S9X_TLS struct SCheatData		Cheat;
+extern S9X_TLS struct SLineData			LineData[240];
+extern S9X_TLS struct SLineMatrixData	LineMatrixData[240];
 
 void S9xComputeClipWindows (void);
 
@@ -212,7 +215,23 @@ static void DrawBackgroundOffsetMosaic (int, uint8, uint8, int);
 static inline void DrawBackgroundMode7 (int, void (*DrawMath) (uint32, uint32, int), void (*DrawNomath) (uint32, uint32, int), int);
 static inline void DrawBackdrop (void);
 static inline void RenderScreen (bool8);
+static void UpdateHiresLayout (bool8);
+static void DrawLines (void);
+static void DrawScreenLines (void);
+static void FinishObservation (void);
+static bool8 AllocScreenBuffers (void);
+static void FreeScreenBuffers (void);
+static void FreeObservation (void);
+static void PresentFrame (void);
+static void HashFrameLines (int, int);
+static void BuildScreen32 (int, int);
 static uint16 get_crosshair_color (uint8);
+#ifdef S9X_MULTI_INSTANCE
+static void SetRenderThread (bool8);
+static void BeginRenderFrame (void);
+static void RecordRenderSegment (bool8);
+static void SubmitRenderFrame (bool8);
+#endif
 
 #define TILE_PLUS(t, x)	(((t) & 0xfc00) | ((t + x) & 0x3ff))
 
@@ -232,18 +251,18 @@ bool8 S9xGraphicsInit (void)
 	GFX.RealPPL = GFX.Pitch >> 1;
 	IPPU.OBJChanged = TRUE;
 	IPPU.DirectColourMapsNeedRebuild = TRUE;
+	GFX.OBJSetupKey = -1;
+	S9xInvalidateFrameHash();
 	Settings.BG_Forced = 0;
 	S9xFixColourBrightness();
 
 	GFX.X2   = (uint16 *) malloc(sizeof(uint16) * 0x10000);
 	GFX.ZERO = (uint16 *) malloc(sizeof(uint16) * 0x10000);
+	GFX.XRGB = (uint32 *) malloc(sizeof(uint32) * 0x10000);
 
 	GFX.ScreenSize = GFX.Pitch / 2 * SNES_HEIGHT_EXTENDED * (Settings.SupportHiRes ? 2 : 1);
-	GFX.SubScreen  = (uint16 *) malloc(GFX.ScreenSize * sizeof(uint16));
-	GFX.ZBuffer    = (uint8 *)  malloc(GFX.ScreenSize);
-	GFX.SubZBuffer = (uint8 *)  malloc(GFX.ScreenSize);
 
-	if (!GFX.X2 || !GFX.ZERO || !GFX.SubScreen || !GFX.ZBuffer || !GFX.SubZBuffer)
+	if (!GFX.X2 || !GFX.ZERO || !GFX.XRGB || !AllocScreenBuffers())
 	{
 		S9xGraphicsDeinit();
 		return (FALSE);
@@ -307,16 +326,35 @@ bool8 S9xGraphicsInit (void)
 		}
 	}
 
+	// Lookup table for XRGB8888 output, the 5-bit components are widened
+	// the same way as in screenshots
+	for (uint32 p = 0; p < 0x10000; p++)
+	{
+		uint32	r, g, b;
+
+		DECOMPOSE_PIXEL(p, r, g, b);
+		r &= 0x1f;
+		g &= 0x1f;
+		b &= 0x1f;
+
+		GFX.XRGB[p] = (((r << 3) | (r >> 2)) << 16) | (((g << 3) | (g >> 2)) << 8) | ((b << 3) | (b >> 2));
+	}
+
 	return (TRUE);
 }
 
 void S9xGraphicsDeinit (void)
 {
+#ifdef S9X_MULTI_INSTANCE
+	SetRenderThread(FALSE);
+#endif
+
 	if (GFX.X2)         { free(GFX.X2);         GFX.X2         = NULL; }
 	if (GFX.ZERO)       { free(GFX.ZERO);       GFX.ZERO       = NULL; }
-	if (GFX.SubScreen)  { free(GFX.SubScreen);  GFX.SubScreen  = NULL; }
-	if (GFX.ZBuffer)    { free(GFX.ZBuffer);    GFX.ZBuffer    = NULL; }
-	if (GFX.SubZBuffer) { free(GFX.SubZBuffer); GFX.SubZBuffer = NULL; }
+	if (GFX.XRGB)       { free(GFX.XRGB);       GFX.XRGB       = NULL; }
+
+	FreeObservation();
+	FreeScreenBuffers();
 }
 
 void S9xBuildDirectColourMaps (void)
@@ -332,6 +370,13 @@ void S9xBuildDirectColourMaps (void)
 
 void S9xStartScreenRefresh (void)
 {
+#ifdef S9X_MULTI_INSTANCE
+	SetRenderThread(Settings.ThreadedRender);
+#endif
+
+	if (Settings.SkipRendering)
+		IPPU.RenderThisFrame = FALSE;
+
 	if (IPPU.RenderThisFrame)
 	{
 		GFX.InterlaceFrame = !GFX.InterlaceFrame;
@@ -391,8 +436,15 @@ void S9xStartScreenRefresh (void)
 		PPU.RecomputeClipWindows = TRUE;
 		IPPU.PreviousLine = IPPU.CurrentLine = 0;
 
-		memset(GFX.ZBuffer, 0, GFX.ScreenSize);
-		memset(GFX.SubZBuffer, 0, GFX.ScreenSize);
+		if (!GFX.Observation)
+		{
+			memset(GFX.ZBuffer, 0, GFX.ScreenSize);
+			memset(GFX.SubZBuffer, 0, GFX.ScreenSize);
+		}
+
+	#ifdef S9X_MULTI_INSTANCE
+		BeginRenderFrame();
+	#endif
 	}
 
 	if (++IPPU.FrameCount % Memory.ROMFramesPerSecond == 0)
@@ -414,39 +466,33 @@ void S9xEndScreenRefresh (void)
 	{
 		FLUSH_REDRAW();
 
-		if (GFX.DoInterlace && GFX.InterlaceFrame == 0)
+		bool8	field = GFX.DoInterlace && GFX.InterlaceFrame == 0;
+
+		if (!field && IPPU.ColorsChanged)
 		{
-			S9xControlEOF();
-			S9xContinueUpdate(IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight);
+			uint32 saved = PPU.CGDATA[0];
+			IPPU.ColorsChanged = FALSE;
+			S9xSetPalette();
+			PPU.CGDATA[0] = saved;
 		}
-		else
-		{
-			if (IPPU.ColorsChanged)
-			{
-				uint32 saved = PPU.CGDATA[0];
-				IPPU.ColorsChanged = FALSE;
-				S9xSetPalette();
-				PPU.CGDATA[0] = saved;
-			}
-
-			S9xControlEOF();
-
-			if (Settings.TakeScreenshot)
-				S9xDoScreenshot(IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight);
 
-			if (Settings.AutoDisplayMessages)
-				S9xDisplayMessages(GFX.Screen, GFX.RealPPL, IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight, 1);
-
-#ifdef HAVE_LUA
-			if (Settings.AutoDisplayMessages)
-				DrawLuaGuiToScreen(GFX.Screen, IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight, 16, GFX.Pitch, false);
-#endif
+		S9xControlEOF();
 
-			S9xDeinitUpdate(IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight);
-		}
+	#ifdef S9X_MULTI_INSTANCE
+		if (S9xCurrentRenderThread())
+			SubmitRenderFrame(field);
+		else
+	#endif
+		if (field)
+			S9xContinueUpdate(IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight);
+		else
+			PresentFrame();
 	}
 	else
+	{
 		S9xControlEOF();
+		S9xFinishRendering();
+	}
 
 	S9xApplyCheats(FALSE);
 
@@ -485,6 +531,96 @@ void S9xEndScreenRefresh (void)
 	}
 }
 
+static void PresentFrame (void)
+{
+	if (GFX.Observation)
+	{
+		FinishObservation();
+		S9xInvalidateFrameHash();
+	}
+
+	if (Settings.TakeScreenshot)
+		S9xDoScreenshot(IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight);
+
+	if (Settings.AutoDisplayMessages)
+		S9xDisplayMessages(GFX.Screen, GFX.RealPPL, IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight, 1);
+
+#ifdef HAVE_LUA
+	if (Settings.AutoDisplayMessages)
+		DrawLuaGuiToScreen(GFX.Screen, IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight, 16, GFX.Pitch, false);
+#endif
+
+	if (!GFX.Observation)
+		HashFrameLines(IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight);
+
+	if (GFX.Screen32)
+		BuildScreen32(IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight);
+
+	S9xDeinitUpdate(IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight);
+}
+
+void S9xInvalidateFrameHash (void)
+{
+	GFX.HashedWidth = GFX.HashedHeight = 0;
+	GFX.FrameChanged = TRUE;
+	memset(GFX.LineChanged, 1, sizeof(GFX.LineChanged));
+}
+
+static void HashFrameLines (int width, int height)
+{
+	// Multiply-xor over four pixels at a time. Overlays are already drawn,
+	// and hires lines may have been widened after they were rendered, so
+	// only the finished frame is hashed.
+	bool8	same = (width == GFX.HashedWidth && height == GFX.HashedHeight);
+	uint16	*s = GFX.Screen;
+
+	GFX.FrameChanged = !same;
+
+	for (int y = 0; y < height; y++, s += GFX.RealPPL)
+	{
+		uint64	h = (uint64) width;
+		int		x = 0;
+
+		for (; x + 4 <= width; x += 4)
+			h = (h ^ ((uint64) s[x] | ((uint64) s[x + 1] << 16) | ((uint64) s[x + 2] << 32) | ((uint64) s[x + 3] << 48))) * 0x9e3779b97f4a7c15ULL;
+		for (; x < width; x++)
+			h = (h ^ s[x]) * 0x9e3779b97f4a7c15ULL;
+
+		GFX.LineChanged[y] = !same || h != GFX.LineHash[y];
+		GFX.LineHash[y] = h;
+		GFX.FrameChanged |= GFX.LineChanged[y];
+	}
+
+	GFX.HashedWidth  = width;
+	GFX.HashedHeight = height;
+}
+
+static void BuildScreen32 (int width, int height)
+{
+	const uint32	*xrgb = GFX.XRGB;
+	uint16			*s = GFX.Screen;
+	uint32			*d = GFX.Screen32;
+
+	for (int y = 0; y < height; y++, s += GFX.RealPPL, d += GFX.Pitch32 >> 2)
+	{
+		int	x = 0;
+
+		if (!GFX.LineChanged[y])
+			continue;
+
+		for (; x + 4 <= width; x += 4)
+		{
+			d[x + 0] = xrgb[s[x + 0]];
+			d[x + 1] = xrgb[s[x + 1]];
+			d[x + 2] = xrgb[s[x + 2]];
+			d[x + 3] = xrgb[s[x + 3]];
+		}
+
+		for (; x < width; x++)
+			d[x] = xrgb[s[x]];
+	}
+}
+
 void RenderLine (uint8 C)
 {
 	if (IPPU.RenderThisFrame)
@@ -531,6 +667,10 @@ static inline void RenderScreen (bool8 sub)
 	uint8	BGActive;
 	int		D;
 
+	// Settings.RenderMask only drops draw calls. OBJ setup and the RTO flags
+	// are done by the caller whatever it says, so emulation is unaffected.
+	uint8	math = (Settings.RenderMask & RENDER_MASK_COLOR_MATH) ? 0 : Memory.FillRAM[0x2131];
+
 	if (!sub)
 	{
 		GFX.S = GFX.Screen;
@@ -538,7 +678,7 @@ static inline void RenderScreen (bool8 sub)
 			GFX.S += GFX.RealPPL;
 		GFX.DB = GFX.ZBuffer;
 		GFX.Clip = IPPU.Clip[0];
-		BGActive = Memory.FillRAM[0x212c] & ~Settings.BG_Forced;
+		BGActive = Memory.FillRAM[0x212c] & ~(Settings.BG_Forced | Settings.RenderMask);
 		D = 32;
 	}
 	else
@@ -546,7 +686,7 @@ static inline void RenderScreen (bool8 sub)
 		GFX.S = GFX.SubScreen;
 		GFX.DB = GFX.SubZBuffer;
 		GFX.Clip = IPPU.Clip[1];
-		BGActive = Memory.FillRAM[0x212d] & ~Settings.BG_Forced;
+		BGActive = Memory.FillRAM[0x212d] & ~(Settings.BG_Forced | Settings.RenderMask);
 		D = (Memory.FillRAM[0x2130] & 2) << 4; // 'do math' depth flag
 	}
 
@@ -554,7 +694,7 @@ static inline void RenderScreen (bool8 sub)
 	{
 		BG.TileAddress = PPU.OBJNameBase;
 		BG.NameSelect = PPU.OBJNameSelect;
-		BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & 0x10);
+		BG.EnableMath = !sub && (math & 0x10);
 		BG.StartPalette = 128;
 		S9xSelectTileConverter(4, FALSE, sub, FALSE);
 		S9xSelectTileRenderers(PPU.BGMode, sub, TRUE);
@@ -568,7 +708,7 @@ static inline void RenderScreen (bool8 sub)
 		if (BGActive & (1 << n)) \
 		{ \
 			BG.StartPalette = pal; \
-			BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & (1 << n)); \
+			BG.EnableMath = !sub && (math & (1 << n)); \
 			BG.TileSizeH = (!hires && PPU.BG[n].BGSize) ? 16 : 8; \
 			BG.TileSizeV = (PPU.BG[n].BGSize) ? 16 : 8; \
 			S9xSelectTileConverter(depth, hires, sub, PPU.BGMosaic[n]); \
@@ -634,13 +774,13 @@ static inline void RenderScreen (bool8 sub)
 		case 7:
 			if (BGActive & 0x01)
 			{
-				BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & 1);
+				BG.EnableMath = !sub && (math & 1);
 				DrawBackgroundMode7(0, GFX.DrawMode7BG1Math, GFX.DrawMode7BG1Nomath, D);
 			}
 
 			if ((Memory.FillRAM[0x2133] & 0x40) && (BGActive & 0x02))
 			{
-				BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & 2);
+				BG.EnableMath = !sub && (math & 2);
 				DrawBackgroundMode7(1, GFX.DrawMode7BG2Math, GFX.DrawMode7BG2Nomath, D);
 			}
 
@@ -649,14 +789,16 @@ static inline void RenderScreen (bool8 sub)
 
 	#undef DO_BG
 
-	BG.EnableMath = !sub && (Memory.FillRAM[0x2131] & 0x20);
+	BG.EnableMath = !sub && (math & 0x20);
 
 	DrawBackdrop();
 }
 
 void S9xUpdateScreen (void)
 {
-	if (IPPU.OBJChanged || IPPU.InterlaceOBJ)
+	bool8	objchanged = IPPU.OBJChanged || IPPU.InterlaceOBJ;
+
+	if (objchanged)
 		SetupOBJ();
 
 	// XXX: Check ForceBlank? Or anything else?
@@ -676,70 +818,312 @@ void S9xUpdateScreen (void)
 			S9xComputeClipWindows();
 			PPU.RecomputeClipWindows = FALSE;
 		}
+	}
 
-		if (Settings.SupportHiRes)
-		{
-			if (!IPPU.DoubleWidthPixels && (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.PseudoHires))
-			{
-			#ifdef USE_OPENGL
-				if (Settings.OpenGLEnable && GFX.RealPPL == 256)
-				{
-					// Have to back out of the speed up hack where the low res.
-					// SNES image was rendered into a 256x239 sized buffer,
-					// ignoring the true, larger size of the buffer.
-					GFX.RealPPL = GFX.Pitch >> 1;
+#ifdef S9X_MULTI_INSTANCE
+	if (S9xCurrentRenderThread())
+	{
+		// Record the layout as it was, the render thread redoes the change
+		// and moves the lines it has drawn.
+		RecordRenderSegment(objchanged);
 
-					for (register int32 y = (int32) GFX.StartY - 1; y >= 0; y--)
-					{
-						register uint16	*p = GFX.Screen + y * GFX.PPL     + 255;
-						register uint16	*q = GFX.Screen + y * GFX.RealPPL + 510;
+		if (!PPU.ForcedBlanking)
+			UpdateHiresLayout(FALSE);
+	}
+	else
+#endif
+	{
+		if (!PPU.ForcedBlanking)
+			UpdateHiresLayout(!GFX.Observation);
 
-						for (register int x = 255; x >= 0; x--, p--, q -= 2)
-							*q = *(q + 1) = *p;
-					}
+		DrawLines();
+	}
 
-					GFX.PPL = GFX.RealPPL; // = GFX.Pitch >> 1 above
-				}
-				else
-			#endif
+	IPPU.PreviousLine = IPPU.CurrentLine;
+}
+
+static void UpdateHiresLayout (bool8 move)
+{
+	if (Settings.SupportHiRes)
+	{
+		if (!IPPU.DoubleWidthPixels && (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.PseudoHires))
+		{
+		#ifdef USE_OPENGL
+			if (Settings.OpenGLEnable && GFX.RealPPL == 256)
+			{
+				// Have to back out of the speed up hack where the low res.
+				// SNES image was rendered into a 256x239 sized buffer,
+				// ignoring the true, larger size of the buffer.
+				GFX.RealPPL = GFX.Pitch >> 1;
+
+				for (register int32 y = (int32) GFX.StartY - 1; move && y >= 0; y--)
 				{
-					// Have to back out of the regular speed hack
-					for (register uint32 y = 0; y < GFX.StartY; y++)
-					{
-						register uint16	*p = GFX.Screen + y * GFX.PPL + 255;
-						register uint16	*q = GFX.Screen + y * GFX.PPL + 510;
+					register uint16	*p = GFX.Screen + y * GFX.PPL     + 255;
+					register uint16	*q = GFX.Screen + y * GFX.RealPPL + 510;
 
-						for (register int x = 255; x >= 0; x--, p--, q -= 2)
-							*q = *(q + 1) = *p;
-					}
+					for (register int x = 255; x >= 0; x--, p--, q -= 2)
+						*q = *(q + 1) = *p;
 				}
 
-				IPPU.DoubleWidthPixels = TRUE;
-				IPPU.RenderedScreenWidth = 512;
+				GFX.PPL = GFX.RealPPL; // = GFX.Pitch >> 1 above
 			}
-
-			if (!IPPU.DoubleHeightPixels && IPPU.Interlace && (PPU.BGMode == 5 || PPU.BGMode == 6))
+			else
+		#endif
 			{
-				IPPU.DoubleHeightPixels = TRUE;
-				IPPU.RenderedScreenHeight = PPU.ScreenHeight << 1;
-				GFX.PPL = GFX.RealPPL << 1;
-				GFX.DoInterlace = 2;
+				// Have to back out of the regular speed hack
+				for (register uint32 y = 0; move && y < GFX.StartY; y++)
+				{
+					register uint16	*p = GFX.Screen + y * GFX.PPL + 255;
+					register uint16	*q = GFX.Screen + y * GFX.PPL + 510;
 
-				for (register int32 y = (int32) GFX.StartY - 1; y >= 0; y--)
-					memmove(GFX.Screen + y * GFX.PPL, GFX.Screen + y * GFX.RealPPL, IPPU.RenderedScreenWidth * sizeof(uint16));
+					for (register int x = 255; x >= 0; x--, p--, q -= 2)
+						*q = *(q + 1) = *p;
+				}
 			}
+
+			IPPU.DoubleWidthPixels = TRUE;
+			IPPU.RenderedScreenWidth = 512;
 		}
 
-		if ((Memory.FillRAM[0x2130] & 0x30) != 0x30 && (Memory.FillRAM[0x2131] & 0x3f))
+		if (!IPPU.DoubleHeightPixels && IPPU.Interlace && (PPU.BGMode == 5 || PPU.BGMode == 6))
+		{
+			IPPU.DoubleHeightPixels = TRUE;
+			IPPU.RenderedScreenHeight = PPU.ScreenHeight << 1;
+			GFX.PPL = GFX.RealPPL << 1;
+			GFX.DoInterlace = 2;
+
+			for (register int32 y = (int32) GFX.StartY - 1; move && y >= 0; y--)
+				memmove(GFX.Screen + y * GFX.PPL, GFX.Screen + y * GFX.RealPPL, IPPU.RenderedScreenWidth * sizeof(uint16));
+		}
+	}
+}
+
+static void InvalidateDirtyTiles (void)
+{
+	// VRAM writes only mark their 16 byte chunk, every tile format that
+	// decodes from a marked chunk is dropped here and redone on its next use.
+	for (uint32 w = 0; w < (MAX_2BIT_TILES >> 5); w++)
+	{
+		uint32	bits = IPPU.TileDirty[w];
+
+		if (!bits)
+			continue;
+
+		IPPU.TileDirty[w] = 0;
+
+		for (uint32 t = w << 5; bits; bits >>= 1, t++)
+		{
+			if (!(bits & 1))
+				continue;
+
+			IPPU.TileCached[TILE_2BIT][t] = FALSE;
+			IPPU.TileCached[TILE_4BIT][t >> 1] = FALSE;
+			IPPU.TileCached[TILE_8BIT][t >> 2] = FALSE;
+			IPPU.TileCached[TILE_2BIT_EVEN][t] = FALSE;
+			IPPU.TileCached[TILE_2BIT_EVEN][(t - 1) & (MAX_2BIT_TILES - 1)] = FALSE;
+			IPPU.TileCached[TILE_2BIT_ODD] [t] = FALSE;
+			IPPU.TileCached[TILE_2BIT_ODD] [(t - 1) & (MAX_2BIT_TILES - 1)] = FALSE;
+			IPPU.TileCached[TILE_4BIT_EVEN][t >> 1] = FALSE;
+			IPPU.TileCached[TILE_4BIT_EVEN][((t >> 1) - 1) & (MAX_4BIT_TILES - 1)] = FALSE;
+			IPPU.TileCached[TILE_4BIT_ODD] [t >> 1] = FALSE;
+			IPPU.TileCached[TILE_4BIT_ODD] [((t >> 1) - 1) & (MAX_4BIT_TILES - 1)] = FALSE;
+		}
+	}
+}
+
+#define OBSERVATION_BAND	16
+
+static bool8 AllocScreenBuffers (void)
+{
+	GFX.SubScreen  = (uint16 *) malloc(GFX.ScreenSize * sizeof(uint16));
+	GFX.ZBuffer    = (uint8 *)  malloc(GFX.ScreenSize);
+	GFX.SubZBuffer = (uint8 *)  malloc(GFX.ScreenSize);
+	GFX.MathBuffer = (uint8 *)  malloc(GFX.ScreenSize);
+
+	return (GFX.SubScreen && GFX.ZBuffer && GFX.SubZBuffer && GFX.MathBuffer);
+}
+
+static void FreeScreenBuffers (void)
+{
+	if (GFX.SubScreen)  { free(GFX.SubScreen);  GFX.SubScreen  = NULL; }
+	if (GFX.ZBuffer)    { free(GFX.ZBuffer);    GFX.ZBuffer    = NULL; }
+	if (GFX.SubZBuffer) { free(GFX.SubZBuffer); GFX.SubZBuffer = NULL; }
+	if (GFX.MathBuffer) { free(GFX.MathBuffer); GFX.MathBuffer = NULL; }
+}
+
+static void FreeObservation (void)
+{
+	free(GFX.ObservationSum);
+	free(GFX.ObservationBand);
+	GFX.ObservationSum = NULL;
+	GFX.ObservationBand = NULL;
+	GFX.Observation = NULL;
+}
+
+bool8 S9xSetObservation (uint8 *buffer, int width, int height)
+{
+	S9xFinishRendering();
+
+	FreeObservation();
+
+	if (!buffer)
+	{
+		// Back to full frames, which need the frame sized buffers again.
+		if (!GFX.SubScreen && !AllocScreenBuffers())
+		{
+			FreeScreenBuffers();
+			return (FALSE);
+		}
+
+		return (TRUE);
+	}
+
+	// Every observation pixel has to get at least one screen pixel, so it
+	// can't be finer than the screen itself.
+	if (width <= 0 || height <= 0 || width > SNES_WIDTH || height > SNES_HEIGHT)
+		return (FALSE);
+
+	// A band line holds an interlaced line pair, Pitch pixels, plus one line
+	// for the hires plotter reading one pixel past the end of the last line.
+	uint32	n = (OBSERVATION_BAND + 1) * GFX.Pitch;
+
+	GFX.ObservationSum  = (uint32 *) calloc(width * height * 2, sizeof(uint32));
+	GFX.ObservationBand = (uint8 *) calloc(n, sizeof(uint16) * 2 + 3);
+
+	if (!GFX.ObservationSum || !GFX.ObservationBand)
+	{
+		S9xSetObservation(NULL, 0, 0);
+		return (FALSE);
+	}
+
+	// Only the band buffers are drawn into from now on.
+	FreeScreenBuffers();
+
+	memset(buffer, 0, width * height);
+	GFX.Observation = buffer;
+	GFX.ObservationWidth = width;
+	GFX.ObservationHeight = height;
+
+	return (TRUE);
+}
+
+static void FoldObservationLines (const uint16 *band)
+{
+	uint32	width = IPPU.DoubleWidthPixels ? SNES_WIDTH << 1 : SNES_WIDTH;
+	int		shift = IPPU.DoubleWidthPixels ? 9 : 8;
+	uint32	ow = GFX.ObservationWidth;
+	uint32	*sum = GFX.ObservationSum, *count = sum + ow * GFX.ObservationHeight;
+
+	if (GFX.DoInterlace && GFX.InterlaceFrame)
+		band += GFX.RealPPL;
+
+	for (uint32 y = GFX.StartY; y <= GFX.EndY && y < PPU.ScreenHeight; y++, band += GFX.PPL)
+	{
+		uint32	row = (y * GFX.ObservationHeight / PPU.ScreenHeight) * ow;
+
+		for (uint32 x = 0; x < width; x++)
+		{
+			uint32	c = GFX.XRGB[band[x]];
+			uint32	o = row + ((x * ow) >> shift);
+
+			sum[o] += (((c >> 16) & 0xff) * 77 + ((c >> 8) & 0xff) * 150 + (c & 0xff) * 29) >> 8;
+			count[o]++;
+		}
+	}
+}
+
+static void FinishObservation (void)
+{
+	uint32	size = GFX.ObservationWidth * GFX.ObservationHeight;
+	uint32	*sum = GFX.ObservationSum, *count = sum + size;
+
+	for (uint32 i = 0; i < size; i++)
+		GFX.Observation[i] = count[i] ? sum[i] / count[i] : 0;
+
+	memset(sum, 0, size * 2 * sizeof(uint32));
+}
+
+static void DrawLines (void)
+{
+	if (!GFX.Observation)
+	{
+		DrawScreenLines();
+		return;
+	}
+
+	// Observation: draw into a band sized screen that stands in for lines
+	// StartY... of the real one, then fold the band into the observation.
+	// Every line is drawn once a frame, so the band Z buffers are cleared
+	// just as the frame sized ones would be.
+	uint16	*screen = GFX.Screen, *subscreen = GFX.SubScreen;
+	uint8	*zbuffer = GFX.ZBuffer, *subzbuffer = GFX.SubZBuffer, *mathbuffer = GFX.MathBuffer;
+	uint32	starty = GFX.StartY, endy = GFX.EndY;
+	uint32	n = (OBSERVATION_BAND + 1) * GFX.Pitch;
+	uint16	*band = (uint16 *) GFX.ObservationBand;
+	uint8	*bandz = (uint8 *) (band + n * 2);
+
+	for (uint32 y = starty; y <= endy; y += OBSERVATION_BAND)
+	{
+		GFX.StartY = y;
+		GFX.EndY = (y + OBSERVATION_BAND - 1 < endy) ? y + OBSERVATION_BAND - 1 : endy;
+
+		memset(bandz, 0, n * 2);
+		GFX.Screen     = band      - y * GFX.PPL;
+		GFX.SubScreen  = band  + n - y * GFX.PPL;
+		GFX.ZBuffer    = bandz     - y * GFX.PPL;
+		GFX.SubZBuffer = bandz + n - y * GFX.PPL;
+		GFX.MathBuffer = bandz + n * 2 - y * GFX.PPL;
+
+		DrawScreenLines();
+		FoldObservationLines(band);
+	}
+
+	GFX.Screen     = screen;
+	GFX.SubScreen  = subscreen;
+	GFX.ZBuffer    = zbuffer;
+	GFX.SubZBuffer = subzbuffer;
+	GFX.MathBuffer = mathbuffer;
+	GFX.StartY = starty;
+	GFX.EndY   = endy;
+}
+
+static void DrawScreenLines (void)
+{
+	if (!PPU.ForcedBlanking)
+	{
+		InvalidateDirtyTiles();
+
+		uint8	math = (Settings.RenderMask & RENDER_MASK_COLOR_MATH) ? 0 : Memory.FillRAM[0x2131];
+
+		if ((Memory.FillRAM[0x2130] & 0x30) != 0x30 && (math & 0x3f))
 			GFX.FixedColour = BUILD_PIXEL(IPPU.XB[PPU.FixedColourRed], IPPU.XB[PPU.FixedColourGreen], IPPU.XB[PPU.FixedColourBlue]);
 
+		// Colour math is left until both screens are drawn, see S9xApplyColourMath().
+		GFX.ColourMath = 0;
+		if (Settings.Transparency && (math & 0x3f))
+		{
+			GFX.ColourMath = (Memory.FillRAM[0x2131] & 0x80) ? 4 : 1;
+			if (Memory.FillRAM[0x2131] & 0x40)
+			{
+				GFX.ColourMath++;
+				if (Memory.FillRAM[0x2130] & 2)
+					GFX.ColourMath++;
+			}
+		}
+
 		if (PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.PseudoHires ||
-			((Memory.FillRAM[0x2130] & 0x30) != 0x30 && (Memory.FillRAM[0x2130] & 2) && (Memory.FillRAM[0x2131] & 0x3f) && (Memory.FillRAM[0x212d] & 0x1f)))
+			(!(Settings.RenderMask & RENDER_MASK_SUBSCREEN) &&
+			 (Memory.FillRAM[0x2130] & 0x30) != 0x30 && (Memory.FillRAM[0x2130] & 2) && (math & 0x3f) && (Memory.FillRAM[0x212d] & 0x1f)))
 			// If hires (Mode 5/6 or pseudo-hires) or math is to be done
 			// involving the subscreen, then we need to render the subscreen...
+			// Hires needs it for every other pixel, so the render mask can't
+			// drop it there; without it math is done against the fixed colour.
 			RenderScreen(TRUE);
 
 		RenderScreen(FALSE);
+
+		if (GFX.ColourMath)
+			S9xApplyColourMath();
 	}
 	else
 	{
@@ -753,8 +1137,512 @@ void S9xUpdateScreen (void)
 			for (int x = 0; x < IPPU.RenderedScreenWidth; x++)
 				GFX.S[x] = black;
 	}
+}
 
-	IPPU.PreviousLine = IPPU.CurrentLine;
+// Threaded rendering. Every S9xUpdateScreen() on the emulation thread records
+// a segment: the PPU state it would have drawn the lines with, the latched
+// line data and the VRAM that changed since the previous segment. At the end
+// of the frame the segments go to a worker context, which replays them on its
+// own copy of the PPU, VRAM and tile caches while the next frame is emulated.
+// The worker draws exactly the line ranges the synchronous renderer would,
+// from the same state, so the picture is the same; it is shown one frame late.
+// The worker's state is thread-local, so this needs S9X_MULTI_INSTANCE.
+
+#ifdef S9X_MULTI_INSTANCE
+
+#define VRAM_CHUNK	16	// bytes of VRAM behind one TILE_2BIT cache flag
+
+struct SRenderVRAM
+{
+	uint16	Index;
+	uint8	Data[VRAM_CHUNK];
+};
+
+struct SRenderSegment
+{
+	uint32	Size;
+	uint32	StartY;
+	uint32	EndY;
+	uint32	VRAMChunks;
+	bool8	OBJChanged;
+	struct SPPU			PPU;
+	struct InternalPPU	IPPU;
+	uint8	FillRAM[0x100];		// $2100-$21ff
+	// followed by the LineData and LineMatrixData of StartY-EndY, and then the VRAM chunks
+};
+
+struct SRenderFrame
+{
+	uint8	*Data;
+	uint32	Size;
+	uint32	Used;
+
+	// S9xEndScreenRefresh() can follow an earlier one without a new
+	// S9xStartScreenRefresh(), the segments then continue the last frame
+	bool8	Started;
+	struct SGFX			GFX;
+	struct SSettings	Settings;
+
+	// how the emulation thread left the frame, for showing it
+	bool8	Field;
+	uint16	*Screen;
+	uint32	RealPPL;
+	uint32	PPL;
+	int		Width;
+	int		Height;
+	const char	*InfoString;
+};
+
+struct SRenderThread
+{
+	SContext		*Worker;
+	struct SRenderFrame	Frame[2];
+	int				Recording;
+	bool8			Pending;
+};
+
+static S9X_TLS struct SRenderThread	render;
+
+// worker side
+static S9X_TLS uint32	render_screen_size = 0;
+
+static void RenderWorkerInit (void *)
+{
+	Memory.VRAM    = (uint8 *) calloc(0x10000, 1);
+	Memory.FillRAM = (uint8 *) calloc(0x8000, 1);
+
+	IPPU.TileCache[TILE_2BIT]       = (uint8 *) malloc(MAX_2BIT_TILES * 64);
+	IPPU.TileCache[TILE_4BIT]       = (uint8 *) malloc(MAX_4BIT_TILES * 64);
+	IPPU.TileCache[TILE_8BIT]       = (uint8 *) malloc(MAX_8BIT_TILES * 64);
+	IPPU.TileCache[TILE_2BIT_EVEN]  = (uint8 *) malloc(MAX_2BIT_TILES * 64);
+	IPPU.TileCache[TILE_2BIT_ODD]   = (uint8 *) malloc(MAX_2BIT_TILES * 64);
+	IPPU.TileCache[TILE_4BIT_EVEN]  = (uint8 *) malloc(MAX_4BIT_TILES * 64);
+	IPPU.TileCache[TILE_4BIT_ODD]   = (uint8 *) malloc(MAX_4BIT_TILES * 64);
+
+	IPPU.TileCached[TILE_2BIT]      = (uint8 *) calloc(MAX_2BIT_TILES, 1);
+	IPPU.TileCached[TILE_4BIT]      = (uint8 *) calloc(MAX_4BIT_TILES, 1);
+	IPPU.TileCached[TILE_8BIT]      = (uint8 *) calloc(MAX_8BIT_TILES, 1);
+	IPPU.TileCached[TILE_2BIT_EVEN] = (uint8 *) calloc(MAX_2BIT_TILES, 1);
+	IPPU.TileCached[TILE_2BIT_ODD]  = (uint8 *) calloc(MAX_2BIT_TILES, 1);
+	IPPU.TileCached[TILE_4BIT_EVEN] = (uint8 *) calloc(MAX_4BIT_TILES, 1);
+	IPPU.TileCached[TILE_4BIT_ODD]  = (uint8 *) calloc(MAX_4BIT_TILES, 1);
+
+	IPPU.DirectColourMapsNeedRebuild = TRUE;
+
+	GFX.SubScreen  = NULL;
+	GFX.ZBuffer    = NULL;
+	GFX.SubZBuffer = NULL;
+	GFX.MathBuffer = NULL;
+	render_screen_size = 0;
+}
+
+static void RenderWorkerDeinit (void *)
+{
+	free(Memory.VRAM);
+	free(Memory.FillRAM);
+	Memory.VRAM = Memory.FillRAM = NULL;
+
+	for (int t = 0; t < 7; t++)
+	{
+		free(IPPU.TileCache[t]);
+		free(IPPU.TileCached[t]);
+		IPPU.TileCache[t] = IPPU.TileCached[t] = NULL;
+	}
+
+	free(GFX.SubScreen);
+	free(GFX.ZBuffer);
+	free(GFX.SubZBuffer);
+	free(GFX.MathBuffer);
+	GFX.SubScreen = NULL;
+	GFX.ZBuffer = GFX.SubZBuffer = GFX.MathBuffer = NULL;
+	render_screen_size = 0;
+}
+
+static void ApplyRenderSegment (const struct SRenderSegment *seg)
+{
+	uint8	*cache[7], *cached[7];
+	uint32	dirty[MAX_2BIT_TILES >> 5];
+	bool8	rebuild = IPPU.DirectColourMapsNeedRebuild;
+
+	memcpy(cache, IPPU.TileCache, sizeof(cache));
+	memcpy(cached, IPPU.TileCached, sizeof(cached));
+	memcpy(dirty, IPPU.TileDirty, sizeof(dirty));
+
+	PPU  = seg->PPU;
+	IPPU = seg->IPPU;
+
+	memcpy(IPPU.TileCache, cache, sizeof(cache));
+	memcpy(IPPU.TileCached, cached, sizeof(cached));
+	memcpy(IPPU.TileDirty, dirty, sizeof(dirty));
+	IPPU.DirectColourMapsNeedRebuild |= rebuild;
+
+	memcpy(Memory.FillRAM + 0x2100, seg->FillRAM, 0x100);
+
+	const uint8	*p = (const uint8 *) (seg + 1);
+
+	if (seg->EndY >= seg->StartY)
+	{
+		uint32	rows = seg->EndY - seg->StartY + 1;
+
+		memcpy(&LineData[seg->StartY], p, rows * sizeof(struct SLineData));
+		p += rows * sizeof(struct SLineData);
+		memcpy(&LineMatrixData[seg->StartY], p, rows * sizeof(struct SLineMatrixData));
+		p += rows * sizeof(struct SLineMatrixData);
+	}
+
+	const struct SRenderVRAM	*v = (const struct SRenderVRAM *) p;
+
+	for (uint32 i = 0; i < seg->VRAMChunks; i++, v++)
+	{
+		uint32	t = v->Index;
+
+		memcpy(Memory.VRAM + t * VRAM_CHUNK, v->Data, VRAM_CHUNK);
+
+		// same as REGISTER_2118/2119, DrawLines() drops the tiles
+		IPPU.TileDirty[t >> 5] |= 1 << (t & 31);
+	}
+
+	GFX.StartY = seg->StartY;
+	GFX.EndY   = seg->EndY;
+}
+
+static void RenderFrameJob (void *arg)
+{
+	struct SRenderFrame	*frame = (struct SRenderFrame *) arg;
+	uint16	*sub = GFX.SubScreen;
+	uint8	*zbuf = GFX.ZBuffer, *subzbuf = GFX.SubZBuffer, *mathbuf = GFX.MathBuffer;
+
+	if (frame->Started)
+	{
+		// observation frames are drawn into the band buffers only
+		uint32	size = frame->GFX.Observation ? 0 : frame->GFX.ScreenSize;
+
+		if (render_screen_size != size)
+		{
+			free(sub);
+			free(zbuf);
+			free(subzbuf);
+			free(mathbuf);
+			sub = NULL;
+			zbuf = subzbuf = mathbuf = NULL;
+			render_screen_size = size;
+			if (size)
+			{
+				sub     = (uint16 *) malloc(size * sizeof(uint16));
+				zbuf    = (uint8 *)  malloc(size);
+				subzbuf = (uint8 *)  malloc(size);
+				mathbuf = (uint8 *)  malloc(size);
+			}
+		}
+
+		GFX = frame->GFX;
+		Settings = frame->Settings;
+		if (!GFX.Observation)
+		{
+			memset(zbuf, 0, GFX.ScreenSize);
+			memset(subzbuf, 0, GFX.ScreenSize);
+		}
+	}
+
+	GFX.SubScreen  = sub;
+	GFX.ZBuffer    = zbuf;
+	GFX.SubZBuffer = subzbuf;
+	GFX.MathBuffer = mathbuf;
+
+	for (uint32 offset = 0; offset < frame->Used; )
+	{
+		const struct SRenderSegment	*seg = (const struct SRenderSegment *) (frame->Data + offset);
+
+		ApplyRenderSegment(seg);
+
+		if (seg->OBJChanged)
+			SetupOBJ();
+
+		if (!PPU.ForcedBlanking)
+			UpdateHiresLayout(!GFX.Observation);
+
+		DrawLines();
+
+		offset += seg->Size;
+	}
+}
+
+static void SetRenderThread (bool8 enable)
+{
+	if (enable == (render.Worker != NULL))
+		return;
+
+	if (enable)
+	{
+		if (!(render.Worker = S9xCreateContext()))
+		{
+			Settings.ThreadedRender = FALSE;
+			return;
+		}
+
+		S9xRunInContext(render.Worker, RenderWorkerInit, NULL);
+		S9xWaitContext(render.Worker);
+
+		render.Recording = 0;
+		render.Pending = FALSE;
+		BeginRenderFrame();
+
+		// TileDirty now marks the VRAM the worker has yet to see.
+		memset(IPPU.TileDirty, 0xff, sizeof(IPPU.TileDirty));
+	}
+	else
+	{
+		S9xFinishRendering();
+
+		S9xRunInContext(render.Worker, RenderWorkerDeinit, NULL);
+		S9xDeleteContext(render.Worker);
+		render.Worker = NULL;
+
+		for (int f = 0; f < 2; f++)
+		{
+			free(render.Frame[f].Data);
+			render.Frame[f].Data = NULL;
+			render.Frame[f].Size = render.Frame[f].Used = 0;
+		}
+
+		// Nothing was cached on this thread meanwhile.
+		memset(IPPU.TileCached[TILE_2BIT], 0, MAX_2BIT_TILES);
+		memset(IPPU.TileCached[TILE_4BIT], 0, MAX_4BIT_TILES);
+		memset(IPPU.TileCached[TILE_8BIT], 0, MAX_8BIT_TILES);
+		memset(IPPU.TileCached[TILE_2BIT_EVEN], 0, MAX_2BIT_TILES);
+		memset(IPPU.TileCached[TILE_2BIT_ODD], 0,  MAX_2BIT_TILES);
+		memset(IPPU.TileCached[TILE_4BIT_EVEN], 0, MAX_4BIT_TILES);
+		memset(IPPU.TileCached[TILE_4BIT_ODD], 0,  MAX_4BIT_TILES);
+		IPPU.DirectColourMapsNeedRebuild = TRUE;
+	}
+}
+
+static void BeginRenderFrame (void)
+{
+	if (!render.Worker)
+		return;
+
+	struct SRenderFrame	*frame = &render.Frame[render.Recording];
+
+	frame->Used = 0;
+	frame->Started = TRUE;
+	frame->GFX = GFX;
+	frame->Settings = Settings;
+}
+
+static void RecordRenderSegment (bool8 objchanged)
+{
+	struct SRenderFrame	*frame = &render.Frame[render.Recording];
+	uint32	rows = (GFX.EndY >= GFX.StartY) ? GFX.EndY - GFX.StartY + 1 : 0;
+	uint32	need = sizeof(struct SRenderSegment) + rows * (sizeof(struct SLineData) + sizeof(struct SLineMatrixData)) +
+				   MAX_2BIT_TILES * sizeof(struct SRenderVRAM) + 8;
+
+	if (frame->Used + need > frame->Size)
+	{
+		frame->Size = (frame->Used + need) * 2;
+		frame->Data = (uint8 *) realloc(frame->Data, frame->Size);
+	}
+
+	struct SRenderSegment	*seg = (struct SRenderSegment *) (frame->Data + frame->Used);
+
+	seg->StartY = GFX.StartY;
+	seg->EndY = GFX.EndY;
+	seg->OBJChanged = objchanged;
+	seg->PPU = PPU;
+	seg->IPPU = IPPU;
+	memcpy(seg->FillRAM, Memory.FillRAM + 0x2100, 0x100);
+
+	// The worker builds the direct colour maps from now on.
+	IPPU.DirectColourMapsNeedRebuild = FALSE;
+
+	uint8	*p = (uint8 *) (seg + 1);
+
+	if (rows)
+	{
+		memcpy(p, &LineData[GFX.StartY], rows * sizeof(struct SLineData));
+		p += rows * sizeof(struct SLineData);
+		memcpy(p, &LineMatrixData[GFX.StartY], rows * sizeof(struct SLineMatrixData));
+		p += rows * sizeof(struct SLineMatrixData);
+	}
+
+	// Nothing draws on this thread while the worker renders, so TileDirty
+	// logs the VRAM written since the last segment.
+	struct SRenderVRAM	*v = (struct SRenderVRAM *) p;
+
+	seg->VRAMChunks = 0;
+
+	for (uint32 w = 0; w < (MAX_2BIT_TILES >> 5); w++)
+	{
+		uint32	bits = IPPU.TileDirty[w];
+
+		IPPU.TileDirty[w] = 0;
+
+		for (uint32 t = w << 5; bits; bits >>= 1, t++)
+		{
+			if (!(bits & 1))
+				continue;
+
+			v->Index = t;
+			memcpy(v->Data, Memory.VRAM + t * VRAM_CHUNK, VRAM_CHUNK);
+			v++;
+			seg->VRAMChunks++;
+		}
+	}
+
+	seg->Size = (((uint8 *) v - (uint8 *) seg) + 7) & ~7;
+	frame->Used += seg->Size;
+}
+
+static void SubmitRenderFrame (bool8 field)
+{
+	S9xFinishRendering();
+
+	struct SRenderFrame	*frame = &render.Frame[render.Recording];
+
+	frame->Field   = field;
+	frame->Screen  = GFX.Screen;
+	frame->RealPPL = GFX.RealPPL;
+	frame->PPL     = GFX.PPL;
+	frame->Width   = IPPU.RenderedScreenWidth;
+	frame->Height  = IPPU.RenderedScreenHeight;
+	frame->InfoString = GFX.InfoString;
+
+	S9xRunInContext(render.Worker, RenderFrameJob, frame);
+
+	render.Pending = TRUE;
+	render.Recording ^= 1;
+	render.Frame[render.Recording].Used = 0;
+	render.Frame[render.Recording].Started = FALSE;
+}
+
+void S9xFinishRendering (void)
+{
+	if (!render.Pending)
+		return;
+
+	S9xWaitContext(render.Worker);
+	render.Pending = FALSE;
+
+	// Show it as the frame it was, not the one being emulated now.
+	struct SRenderFrame	*frame = &render.Frame[render.Recording ^ 1];
+	uint16	*screen = GFX.Screen;
+	uint32	realppl = GFX.RealPPL, ppl = GFX.PPL;
+	int		width = IPPU.RenderedScreenWidth, height = IPPU.RenderedScreenHeight;
+	const char	*info = GFX.InfoString;
+
+	GFX.Screen  = frame->Screen;
+	GFX.RealPPL = frame->RealPPL;
+	GFX.PPL     = frame->PPL;
+	IPPU.RenderedScreenWidth  = frame->Width;
+	IPPU.RenderedScreenHeight = frame->Height;
+	GFX.InfoString = frame->InfoString;
+
+	if (frame->Field)
+		S9xContinueUpdate(IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight);
+	else
+		PresentFrame();
+
+	GFX.Screen  = screen;
+	GFX.RealPPL = realppl;
+	GFX.PPL     = ppl;
+	IPPU.RenderedScreenWidth  = width;
+	IPPU.RenderedScreenHeight = height;
+	if (GFX.InfoString == frame->InfoString)
+		GFX.InfoString = info;
+}
+
+bool8 S9xCurrentRenderThread (void)
+{
+	return (render.Worker != NULL);
+}
+
+void S9xDetachRenderThread (void)
+{
+	// The worker thread did not survive fork(), so neither wait for it nor
+	// stop it; the child draws on its own thread from now on.
+	render.Worker = NULL;
+	render.Pending = FALSE;
+	Settings.ThreadedRender = FALSE;
+}
+
+#else
+
+void S9xFinishRendering (void)
+{
+	return;
+}
+
+bool8 S9xCurrentRenderThread (void)
+{
+	return (FALSE);
+}
+
+void S9xDetachRenderThread (void)
+{
+	return;
+}
+
+#endif
+
+static inline int LowestBit (uint32 bits)
+{
+	// de Bruijn multiply, bits must not be 0
+	static const uint8	table[32] =
+	{
+		 0,  1, 28,  2, 29, 14, 24,  3, 30, 22, 20, 15, 25, 17,  4,  8,
+		31, 27, 13, 23, 21, 19, 16,  7, 26, 12, 18,  6, 11,  5, 10,  9
+	};
+
+	return (table[((bits & (~bits + 1)) * 0x077CB531U) >> 27]);
+}
+
+static void SetupOBJLine (int Y, uint8 FirstSprite, int startline, int inc)
+{
+	// Pull out the OBJ on this line that are actually visible, starting
+	// from FirstSprite: 32 sprites and 34 tiles at most.
+
+	GFX.OBJLines[Y].Tiles = 34;
+	GFX.OBJLineFlags[Y] = 0;
+
+	int	j = 0;
+
+	for (int w = 0; w <= 4; w++)
+	{
+		int		word = ((FirstSprite >> 5) + w) & 3;
+		uint32	bits = GFX.OBJLineMask[Y][word];
+
+		if (w == 0)
+			bits &= ~0U << (FirstSprite & 31);
+		else
+		if (w == 4)
+			bits &= ~(~0U << (FirstSprite & 31));
+
+		for (; bits; bits &= bits - 1)
+		{
+			int	S = (word << 5) | LowestBit(bits);
+
+			if (j >= 32)
+			{
+				GFX.OBJLineFlags[Y] |= 0x40;
+				return;
+			}
+
+			uint8	line = startline + (uint8) (Y - GFX.OBJSetup[S].VPos) * inc;
+			if (GFX.OBJSetup[S].VFlip)
+				// Yes, Width not Height. It so happens that the
+				// sprites with H=2*W flip as two WxW sprites.
+				line ^= GFX.OBJWidths[S] - 1;
+
+			GFX.OBJLines[Y].Tiles -= GFX.OBJVisibleTiles[S];
+			if (GFX.OBJLines[Y].Tiles < 0)
+				GFX.OBJLineFlags[Y] |= 0x80;
+			GFX.OBJLines[Y].OBJ[j].Sprite = S;
+			GFX.OBJLines[Y].OBJ[j++].Line = line;
+		}
+	}
+
+	if (j < 32)
+		GFX.OBJLines[Y].OBJ[j].Sprite = -1;
 }
 
 static void SetupOBJ (void)
@@ -810,170 +1698,185 @@ static void SetupOBJ (void)
 	int startline = (IPPU.InterlaceOBJ && GFX.InterlaceFrame) ? 1 : 0;
 
 	// OK, we have three cases here. Either there's no priority, priority is
-	// normal FirstSprite, or priority is FirstSprite+Y. The first two are
-	// easy, the last is somewhat more ... interesting. So we split them up.
+	// normal FirstSprite, or priority is FirstSprite+Y. The first two only
+	// differ in where each line starts looking, but FirstSprite+Y also
+	// clips HPos a little differently.
 
-	int		Height;
-	uint8	S;
+	bool8	rotate = PPU.OAMPriorityRotation && (PPU.OAMFlip & PPU.OAMAddr & 1);
+	int		key = PPU.OBJSizeSelect | (inc << 3) | (startline << 5) | (rotate << 6);
+	bool8	full = (key != GFX.OBJSetupKey);
+	uint8	Moved[128], OldVPos[128], OldLines[128];
+	int		moved = 0;
 
-	if (!PPU.OAMPriorityRotation || !(PPU.OAMFlip & PPU.OAMAddr & 1)) // normal case
+	// The lines are kept from one call to the next along with the OAM
+	// fields they were built from, so first find the sprites that moved.
+
+	GFX.OBJSetupKey = key;
+
+	for (int S = 0; S < 128; S++)
 	{
-		uint8	LineOBJ[SNES_HEIGHT_EXTENDED];
-		memset(LineOBJ, 0, sizeof(LineOBJ));
+		struct SOBJ	*pObj = &PPU.OBJ[S];
+		uint8		VPos = (uint8) (pObj->VPos & 0xff);
+
+		if (!full && GFX.OBJSetup[S].HPos == pObj->HPos && GFX.OBJSetup[S].VPos == VPos &&
+			GFX.OBJSetup[S].VFlip == pObj->VFlip && GFX.OBJSetup[S].Size == pObj->Size)
+			continue;
+
+		int	Width, Height, Lines = 0, Tiles = 0;
 
-		for (int i = 0; i < SNES_HEIGHT_EXTENDED; i++)
+		if (pObj->Size)
 		{
-			GFX.OBJLines[i].RTOFlags = 0;
-			GFX.OBJLines[i].Tiles = 34;
-			for (int j = 0; j < 32; j++)
-				GFX.OBJLines[i].OBJ[j].Sprite = -1;
+			Width = LargeWidth;
+			Height = LargeHeight;
+		}
+		else
+		{
+			Width = SmallWidth;
+			Height = SmallHeight;
 		}
 
-		uint8	FirstSprite = PPU.FirstSprite;
-		S = FirstSprite;
+		int	HPos = pObj->HPos;
+		if (HPos == -256)
+			HPos = rotate ? 256 : 0;
 
-		do
+		if (HPos > -Width && HPos <= 256)
 		{
-			if (PPU.OBJ[S].Size)
-			{
-				GFX.OBJWidths[S] = LargeWidth;
-				Height = LargeHeight;
-			}
+			int	right = rotate ? 257 : 256;
+
+			if (HPos < 0)
+				Tiles = (Width + HPos + 7) >> 3;
 			else
-			{
-				GFX.OBJWidths[S] = SmallWidth;
-				Height = SmallHeight;
-			}
+			if (HPos + Width >= right)
+				Tiles = (right - HPos + 7) >> 3;
+			else
+				Tiles = Width >> 3;
 
-			int	HPos = PPU.OBJ[S].HPos;
-			if (HPos == -256)
-				HPos = 0;
+			Lines = (Height - startline + inc - 1) / inc;
+		}
 
-			if (HPos > -GFX.OBJWidths[S] && HPos <= 256)
-			{
-				if (HPos < 0)
-					GFX.OBJVisibleTiles[S] = (GFX.OBJWidths[S] + HPos + 7) >> 3;
-				else
-				if (HPos + GFX.OBJWidths[S] > 255)
-					GFX.OBJVisibleTiles[S] = (256 - HPos + 7) >> 3;
-				else
-					GFX.OBJVisibleTiles[S] = GFX.OBJWidths[S] >> 3;
+		GFX.OBJSetup[S].HPos = pObj->HPos;
 
-				for (uint8 line = startline, Y = (uint8) (PPU.OBJ[S].VPos & 0xff); line < Height; Y++, line += inc)
-				{
-					if (Y >= SNES_HEIGHT_EXTENDED)
-						continue;
+		// Moving sideways mostly leaves the lines as they were.
+		if (!full && GFX.OBJSetup[S].VPos == VPos && GFX.OBJSetup[S].VFlip == pObj->VFlip && GFX.OBJSetup[S].Size == pObj->Size &&
+			GFX.OBJSetup[S].Lines == Lines && (!Lines || GFX.OBJVisibleTiles[S] == Tiles))
+			continue;
 
-					if (LineOBJ[Y] >= 32)
-					{
-						GFX.OBJLines[Y].RTOFlags |= 0x40;
-						continue;
-					}
+		OldVPos[moved]  = GFX.OBJSetup[S].VPos;
+		OldLines[moved] = full ? 0 : GFX.OBJSetup[S].Lines;
+		Moved[moved++]  = S;
 
-					GFX.OBJLines[Y].Tiles -= GFX.OBJVisibleTiles[S];
-					if (GFX.OBJLines[Y].Tiles < 0)
-						GFX.OBJLines[Y].RTOFlags |= 0x80;
+		GFX.OBJWidths[S] = Width;
+		GFX.OBJVisibleTiles[S] = Tiles;
+		GFX.OBJSetup[S].VPos  = VPos;
+		GFX.OBJSetup[S].VFlip = pObj->VFlip;
+		GFX.OBJSetup[S].Size  = pObj->Size;
+		GFX.OBJSetup[S].Lines = Lines;
+	}
 
-					GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Sprite = S;
-					if (PPU.OBJ[S].VFlip)
-						// Yes, Width not Height. It so happens that the
-						// sprites with H=2*W flip as two WxW sprites.
-						GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Line = line ^ (GFX.OBJWidths[S] - 1);
-					else
-						GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Line = line;
+	if (moved > 8 && !rotate)
+	{
+		// Most lines have changed, so it's quicker to redo them all in
+		// sprite order, as the line order is the same for every line.
 
-					LineOBJ[Y]++;
+		uint8	LineOBJ[SNES_HEIGHT_EXTENDED];
+		memset(LineOBJ, 0, sizeof(LineOBJ));
+		memset(GFX.OBJLineFlags, 0, sizeof(GFX.OBJLineFlags));
+		memset(GFX.OBJLineMask, 0, sizeof(GFX.OBJLineMask));
+
+		for (int Y = 0; Y < SNES_HEIGHT_EXTENDED; Y++)
+			GFX.OBJLines[Y].Tiles = 34;
+
+		uint8	S = PPU.FirstSprite;
+
+		do
+		{
+			uint8	Y = GFX.OBJSetup[S].VPos;
+
+			for (int n = 0; n < GFX.OBJSetup[S].Lines; n++, Y++)
+			{
+				if (Y >= SNES_HEIGHT_EXTENDED)
+					continue;
+
+				GFX.OBJLineMask[Y][S >> 5] |= 1 << (S & 31);
+
+				if (LineOBJ[Y] >= 32)
+				{
+					GFX.OBJLineFlags[Y] |= 0x40;
+					continue;
 				}
+
+				uint8	line = startline + n * inc;
+				if (GFX.OBJSetup[S].VFlip)
+					line ^= GFX.OBJWidths[S] - 1;
+
+				GFX.OBJLines[Y].Tiles -= GFX.OBJVisibleTiles[S];
+				if (GFX.OBJLines[Y].Tiles < 0)
+					GFX.OBJLineFlags[Y] |= 0x80;
+				GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Sprite = S;
+				GFX.OBJLines[Y].OBJ[LineOBJ[Y]++].Line = line;
 			}
 
 			S = (S + 1) & 0x7f;
-		} while (S != FirstSprite);
+		} while (S != PPU.FirstSprite);
 
-		for (int Y = 1; Y < SNES_HEIGHT_EXTENDED; Y++)
-			GFX.OBJLines[Y].RTOFlags |= GFX.OBJLines[Y - 1].RTOFlags;
+		for (int Y = 0; Y < SNES_HEIGHT_EXTENDED; Y++)
+		{
+			if (LineOBJ[Y] < 32)
+				GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Sprite = -1;
+		}
 	}
-	else // evil FirstSprite+Y case
+	else
 	{
-		// First, find out which sprites are on which lines
-		uint8	OBJOnLine[SNES_HEIGHT_EXTENDED][128];
-		memset(OBJOnLine, 0, sizeof(OBJOnLine));
+		// Otherwise only the lines a sprite left or entered are redone,
+		// unless the sprite order itself changed.
 
-		for (S = 0; S < 128; S++)
+		uint32	LineDirty[(SNES_HEIGHT_EXTENDED + 31) >> 5];
+		memset(LineDirty, (full || PPU.FirstSprite != GFX.OBJSetupFirst) ? 0xff : 0, sizeof(LineDirty));
+
+		if (full)
+			memset(GFX.OBJLineMask, 0, sizeof(GFX.OBJLineMask));
+
+		for (int i = 0; i < moved; i++)
 		{
-			if (PPU.OBJ[S].Size)
-			{
-				GFX.OBJWidths[S] = LargeWidth;
-				Height = LargeHeight;
-			}
-			else
+			int		S = Moved[i];
+			uint8	Y = OldVPos[i];
+
+			for (int n = OldLines[i]; n > 0; n--, Y++)
 			{
-				GFX.OBJWidths[S] = SmallWidth;
-				Height = SmallHeight;
+				if (Y >= SNES_HEIGHT_EXTENDED)
+					continue;
+
+				GFX.OBJLineMask[Y][S >> 5] &= ~(1 << (S & 31));
+				LineDirty[Y >> 5] |= 1 << (Y & 31);
 			}
 
-			int	HPos = PPU.OBJ[S].HPos;
-			if (HPos == -256)
-				HPos = 256;
+			Y = GFX.OBJSetup[S].VPos;
 
-			if (HPos > -GFX.OBJWidths[S] && HPos <= 256)
+			for (int n = GFX.OBJSetup[S].Lines; n > 0; n--, Y++)
 			{
-				if (HPos < 0)
-					GFX.OBJVisibleTiles[S] = (GFX.OBJWidths[S] + HPos + 7) >> 3;
-				else
-				if (HPos + GFX.OBJWidths[S] >= 257)
-					GFX.OBJVisibleTiles[S] = (257 - HPos + 7) >> 3;
-				else
-					GFX.OBJVisibleTiles[S] = GFX.OBJWidths[S] >> 3;
-
-				for (uint8 line = startline, Y = (uint8) (PPU.OBJ[S].VPos & 0xff); line < Height; Y++, line += inc)
-				{
-					if (Y >= SNES_HEIGHT_EXTENDED)
-						continue;
+				if (Y >= SNES_HEIGHT_EXTENDED)
+					continue;
 
-					if (PPU.OBJ[S].VFlip)
-						// Yes, Width not Height. It so happens that the
-						// sprites with H=2*W flip as two WxW sprites.
-						OBJOnLine[Y][S] = (line ^ (GFX.OBJWidths[S] - 1)) | 0x80;
-					else
-						OBJOnLine[Y][S] = line | 0x80;
-				}
+				GFX.OBJLineMask[Y][S >> 5] |= 1 << (S & 31);
+				LineDirty[Y >> 5] |= 1 << (Y & 31);
 			}
 		}
 
-		// Now go through and pull out those OBJ that are actually visible.
-		int	j;
 		for (int Y = 0; Y < SNES_HEIGHT_EXTENDED; Y++)
 		{
-			GFX.OBJLines[Y].RTOFlags = Y ? GFX.OBJLines[Y - 1].RTOFlags : 0;
-			GFX.OBJLines[Y].Tiles = 34;
-
-			uint8	FirstSprite = (PPU.FirstSprite + Y) & 0x7f;
-			S = FirstSprite;
-			j = 0;
-
-			do
-			{
-				if (OBJOnLine[Y][S])
-				{
-					if (j >= 32)
-					{
-						GFX.OBJLines[Y].RTOFlags |= 0x40;
-						break;
-					}
+			if (LineDirty[Y >> 5] & (1 << (Y & 31)))
+				SetupOBJLine(Y, rotate ? (PPU.FirstSprite + Y) & 0x7f : PPU.FirstSprite, startline, inc);
+		}
+	}
 
-					GFX.OBJLines[Y].Tiles -= GFX.OBJVisibleTiles[S];
-					if (GFX.OBJLines[Y].Tiles < 0)
-						GFX.OBJLines[Y].RTOFlags |= 0x80;
-					GFX.OBJLines[Y].OBJ[j].Sprite = S;
-					GFX.OBJLines[Y].OBJ[j++].Line = OBJOnLine[Y][S] & ~0x80;
-				}
+	GFX.OBJSetupFirst = PPU.FirstSprite;
 
-				S = (S + 1) & 0x7f;
-			} while (S != FirstSprite);
+	uint8	RTOFlags = 0;
 
-			if (j < 32)
-				GFX.OBJLines[Y].OBJ[j].Sprite = -1;
-		}
+	for (int Y = 0; Y < SNES_HEIGHT_EXTENDED; Y++)
+	{
+		RTOFlags |= GFX.OBJLineFlags[Y];
+		GFX.OBJLines[Y].RTOFlags = RTOFlags;
 	}
 
 	IPPU.OBJChanged = FALSE;
@@ -1950,7 +2853,10 @@ void S9xReRefresh (void)
 	// Be careful when calling this function from the thread other than the emulation one...
 	// Here it's assumed no drawing occurs from the emulation thread when Settings.Paused is TRUE.
 	if (Settings.Paused)
+	{
+		S9xInvalidateFrameHash();
 		S9xDeinitUpdate(IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight);
+	}
 }
 
 void S9xSetInfoString (const char *string)
@@ -2021,8 +2927,8 @@ static void DisplayStringFromBottom (const char *string, int linesFromBottom, in
 static void DisplayFrameRate (void)
 {
 	char	string[10];
-	static uint32 lastFrameCount = 0, calcFps = 0;
-	static time_t lastTime = time(NULL);
+	static S9X_TLS uint32 lastFrameCount = 0, calcFps = 0;
+	static S9X_TLS time_t lastTime = time(NULL);
 
 	time_t currTime = time(NULL);
 	if (lastTime != currTime) {
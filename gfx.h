@@ -185,12 +185,26 @@ struct SGFX
 	uint16	*SubScreen;
 	uint8	*ZBuffer;
 	uint8	*SubZBuffer;
+	uint8	*MathBuffer;		// per main screen pixel, what S9xApplyColourMath is to do with it
 	uint32	Pitch;
 	uint32	ScreenSize;
 	uint16	*S;
 	uint8	*DB;
 	uint16	*X2;
 	uint16	*ZERO;
+	uint32	*XRGB;				// Screen pixel to XRGB8888
+	uint32	*Screen32;			// if set by the port, an XRGB8888 copy of each presented frame
+	uint32	Pitch32;			// bytes per line of Screen32
+	bool8	FrameChanged;		// the presented frame differs from the one presented before it
+	uint8	LineChanged[SNES_HEIGHT_EXTENDED * 2];	// the same, for each row
+	uint64	LineHash[SNES_HEIGHT_EXTENDED * 2];
+	int		HashedWidth;
+	int		HashedHeight;
+	uint8	*Observation;		// see S9xSetObservation()
+	uint32	ObservationWidth;
+	uint32	ObservationHeight;
+	uint32	*ObservationSum;	// luma sums, then pixel counts, of the frame being drawn
+	uint8	*ObservationBand;	// screen, sub screen, both Z buffers and math buffer for a band of lines
 	uint32	RealPPL;			// true PPL of Screen buffer
 	uint32	PPL;				// number of pixels on each of Screen buffer
 	uint32	LinesPerTile;		// number of lines in 1 tile (4 or 8 due to interlace)
@@ -199,6 +213,7 @@ struct SGFX
 	uint8	Z1;					// depth for comparison
 	uint8	Z2;					// depth to save
 	uint32	FixedColour;
+	uint8	ColourMath;			// math op left to S9xApplyColourMath, 0 for none
 	uint8	DoInterlace;
 	uint8	InterlaceFrame;
 	uint32	StartY;
@@ -206,6 +221,10 @@ struct SGFX
 	bool8	ClipColors;
 	uint8	OBJWidths[128];
 	uint8	OBJVisibleTiles[128];
+	int		OBJSetupKey;		// size select, interlace and rotation the OBJ lines were built for
+	uint8	OBJSetupFirst;
+	uint32	OBJLineMask[SNES_HEIGHT_EXTENDED][4];	// sprites on each line
+	uint8	OBJLineFlags[SNES_HEIGHT_EXTENDED];		// RTO flags of each line alone
 
 	struct ClipData	*Clip;
 
@@ -221,6 +240,15 @@ struct SGFX
 		}	OBJ[32];
 	}	OBJLines[SNES_HEIGHT_EXTENDED];
 
+	struct
+	{
+		int16	HPos;
+		uint8	VPos;
+		uint8	VFlip;
+		uint8	Size;
+		uint8	Lines;
+	}	OBJSetup[128];		// OAM fields each sprite's lines were built from
+
 #ifdef GFX_MULTI_FORMAT
 	uint32	PixelFormat;
 	uint32	(*BuildPixel) (uint32, uint32, uint32);
@@ -297,8 +325,8 @@ struct SLineMatrixData
 extern uint16		BlackColourMap[256];
 extern uint16		DirectColourMaps[8][256];
 extern uint8		mul_brightness[16][32];
-extern struct SBG	BG;
-extern struct SGFX	GFX;
+extern S9X_TLS struct SBG	BG;
+extern S9X_TLS struct SGFX	GFX;
 
 #define H_FLIP		0x4000
 #define V_FLIP		0x8000
@@ -347,6 +375,20 @@ void S9xComputeClipWindows (void);
 void S9xDisplayChar (uint16 *, uint8);
 // called automatically unless Settings.AutoDisplayMessages is false
 void S9xDisplayMessages (uint16 *, int, int, int, int);
+// with Settings.ThreadedRender a frame is drawn by a worker while the next one
+// is emulated, and shown one frame late; call before reading GFX.Screen
+void S9xFinishRendering (void);
+bool8 S9xCurrentRenderThread (void);
+// for a fork()ed child: forget the render worker and draw on the calling thread
+void S9xDetachRenderThread (void);
+// draw frames a band of lines at a time and box filter them into a
+// width x height 8-bit luma buffer as each band is done, leaving GFX.Screen
+// untouched and without the frame sized work buffers; at most
+// SNES_WIDTH x SNES_HEIGHT; NULL goes back to drawing GFX.Screen
+bool8 S9xSetObservation (uint8 *, int, int);
+// report every row of the frame as changed until the next one is presented,
+// for ports that dropped their copy of the last one
+void S9xInvalidateFrameHash (void);
 #ifdef GFX_MULTI_FORMAT
 bool8 S9xSetRenderPixelFormat (int);
 #endif
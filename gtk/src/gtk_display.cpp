@@ -221,6 +221,8 @@ internal_convert_16_yuv (void *src_buffer,
     return;
 }
 
+/* 24 and 32-bit targets take the 8-bit components from GFX.XRGB, so they
+ * get the same colours as screenshots */
 static void
 internal_convert_mask (void         *src_buffer,
                        void         *dst_buffer,
@@ -282,10 +284,10 @@ internal_convert_mask (void         *src_buffer,
 
                         for (register int x = 0; x < width; x++)
                         {
-                            uint32 pixel = *snes++;
-                            *data++ = ((pixel & 0x001f) << 3);
-                            *data++ = ((pixel & 0x03e0) >> 2);
-                            *data++ = ((pixel & 0x7c00) >> 7);
+                            uint32 pixel = GFX.XRGB[*snes++];
+                            *data++ = (pixel & 0xff);
+                            *data++ = ((pixel >> 8) & 0xff);
+                            *data++ = ((pixel >> 16) & 0xff);
                         }
                     }
                 }
@@ -302,10 +304,10 @@ internal_convert_mask (void         *src_buffer,
 
                         for (register int x = 0; x < width; x++)
                         {
-                            uint32 pixel = *snes++;
-                            *data++ = ((pixel & 0x7c00) >> 7);
-                            *data++ = ((pixel & 0x03e0) >> 2);
-                            *data++ = ((pixel & 0x001f) << 3);
+                            uint32 pixel = GFX.XRGB[*snes++];
+                            *data++ = ((pixel >> 16) & 0xff);
+                            *data++ = ((pixel >> 8) & 0xff);
+                            *data++ = (pixel & 0xff);
                         }
                     }
                 }
@@ -324,11 +326,11 @@ internal_convert_mask (void         *src_buffer,
 
                     for (register int x = 0; x < width; x++)
                     {
-                        uint32 pixel = *snes++;
+                        uint32 pixel = GFX.XRGB[*snes++];
 
-                        *data++ = ((uint32) (pixel & 0x7c00) << 17) >> inv_rshift
-                                | ((uint32) (pixel & 0x03e0) << 22) >> inv_gshift
-                                | ((uint32) (pixel & 0x001f) << 27) >> inv_bshift;
+                        *data++ = ((pixel & 0xff0000) << 8) >> inv_rshift
+                                | ((pixel & 0x00ff00) << 16) >> inv_gshift
+                                | ((pixel & 0x0000ff) << 24) >> inv_bshift;
                     }
                 }
 
@@ -385,10 +387,10 @@ internal_convert_mask (void         *src_buffer,
 
                             for (register int x = 0; x < width; x++)
                             {
-                                uint32 pixel = *snes++;
-                                *data++ = ((pixel & 0x7c00) >> 7);
-                                *data++ = ((pixel & 0x03e0) >> 2);
-                                *data++ = ((pixel & 0x001f) << 3);
+                                uint32 pixel = GFX.XRGB[*snes++];
+                                *data++ = ((pixel >> 16) & 0xff);
+                                *data++ = ((pixel >> 8) & 0xff);
+                                *data++ = (pixel & 0xff);
                             }
                         }
                     }
@@ -405,10 +407,10 @@ internal_convert_mask (void         *src_buffer,
 
                             for (register int x = 0; x < width; x++)
                             {
-                                uint32 pixel = *snes++;
-                                *data++ = ((pixel & 0x001f) << 3);
-                                *data++ = ((pixel & 0x03e0) >> 2);
-                                *data++ = ((pixel & 0x7c00) >> 7);
+                                uint32 pixel = GFX.XRGB[*snes++];
+                                *data++ = (pixel & 0xff);
+                                *data++ = ((pixel >> 8) & 0xff);
+                                *data++ = ((pixel >> 16) & 0xff);
                             }
                         }
                     }
@@ -427,12 +429,12 @@ internal_convert_mask (void         *src_buffer,
 
                     for (register int x = 0; x < width; x++)
                     {
-                        uint32 pixel = *snes++;
+                        uint32 pixel = GFX.XRGB[*snes++];
                         register uint32 value;
 
-                        value   = ((uint32) (pixel & 0x7c00) << 17) >> inv_rshift
-                                | ((uint32) (pixel & 0x03e0) << 22) >> inv_gshift
-                                | ((uint32) (pixel & 0x001f) << 27) >> inv_bshift;
+                        value   = ((pixel & 0xff0000) << 8) >> inv_rshift
+                                | ((pixel & 0x00ff00) << 16) >> inv_gshift
+                                | ((pixel & 0x0000ff) << 24) >> inv_bshift;
 
                         *data++ = ((value & 0x000000ff) << 24)
                                 | ((value & 0x0000ff00) << 8)
@@ -517,11 +519,11 @@ internal_convert (void *src_buffer,
 
                 for (register int x = 0; x < width; x++)
                 {
-                    uint32 pixel = *snes++;
+                    uint32 pixel = GFX.XRGB[*snes++];
 
-                    *data++ = (pixel & 0x7c00) >> 7; /* Red */
-                    *data++ = (pixel & 0x03e0) >> 2; /* Green */
-                    *data++ = (pixel & 0x001f) << 3; /* Blue */
+                    *data++ = (pixel >> 16) & 0xff; /* Red */
+                    *data++ = (pixel >> 8) & 0xff; /* Green */
+                    *data++ = pixel & 0xff; /* Blue */
                 }
             }
         }
@@ -539,12 +541,12 @@ internal_convert (void *src_buffer,
 
                 for (register int x = 0; x < width; x++)
                 {
-                    uint32 pixel = *snes++;
+                    uint32 pixel = GFX.XRGB[*snes++];
 
                     *data++ = 0xff; /* Null */
-                    *data++ = (pixel & 0x7c00) >> 7; /* Red */
-                    *data++ = (pixel & 0x03e0) >> 2; /* Green */
-                    *data++ = (pixel & 0x001f) << 3; /* Blue */
+                    *data++ = (pixel >> 16) & 0xff; /* Red */
+                    *data++ = (pixel >> 8) & 0xff; /* Green */
+                    *data++ = pixel & 0xff; /* Blue */
                 }
             }
         }
@@ -611,11 +613,11 @@ internal_convert (void *src_buffer,
 
                 for (register int x = 0; x < width; x++)
                 {
-                    uint32 pixel = *snes++;
+                    uint32 pixel = GFX.XRGB[*snes++];
 
-                    *data++ = (pixel & 0x001f) << 3; /* Blue */
-                    *data++ = (pixel & 0x03e0) >> 2; /* Green */
-                    *data++ = (pixel & 0x7c00) >> 7; /* Red */
+                    *data++ = pixel & 0xff; /* Blue */
+                    *data++ = (pixel >> 8) & 0xff; /* Green */
+                    *data++ = (pixel >> 16) & 0xff; /* Red */
                 }
             }
         }
@@ -633,11 +635,11 @@ internal_convert (void *src_buffer,
 
                 for (register int x = 0; x < width; x++)
                 {
-                    uint32 pixel = *snes++;
+                    uint32 pixel = GFX.XRGB[*snes++];
 
-                    *data++ = (pixel & 0x001f) << 3; /* Blue */
-                    *data++ = (pixel & 0x03e0) >> 2; /* Green */
-                    *data++ = (pixel & 0x7c00) >> 7; /* Red */
+                    *data++ = pixel & 0xff; /* Blue */
+                    *data++ = (pixel >> 8) & 0xff; /* Green */
+                    *data++ = (pixel >> 16) & 0xff; /* Red */
                     *data++ = 0xff; /* Null */
                 }
             }
@@ -1433,6 +1435,14 @@ internal_threaded_filter (uint8 *src_buffer,
     /* If the threadpool doesn't exist, create it */
     create_thread_pool ();
 
+#ifdef USE_HQ2X
+    /* Build the HQ tables here rather than racing to do it in every job */
+    if (gui_config->scale_method == FILTER_HQ2X ||
+        gui_config->scale_method == FILTER_HQ3X ||
+        gui_config->scale_method == FILTER_HQ4X)
+        S9xBlitHQ2xFilterPrepare ();
+#endif /* USE_HQ2X */
+
     for (i = 0; i < gui_config->num_threads - 1; i++)
     {
         job[i].operation_type = JOB_FILTER;
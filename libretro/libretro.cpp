@@ -72,6 +72,7 @@ void retro_set_input_state(retro_input_state_t cb)
 
 static retro_environment_t environ_cb;
 static bool use_overscan = false;
+static bool can_dupe = false;
 static bool rom_loaded = false;
 void retro_set_environment(retro_environment_t cb)
 {
@@ -186,16 +187,32 @@ void retro_get_system_info(struct retro_system_info *info)
 void retro_get_system_av_info(struct retro_system_av_info *info)
 {
     int pixel_format = RGB555;
+    bool xrgb8888 = false;
     if(environ_cb) {
         pixel_format = RGB565;
-        enum retro_pixel_format fmt = RETRO_PIXEL_FORMAT_RGB565;
-        if (!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &fmt))
-            pixel_format = RGB555;
+        enum retro_pixel_format fmt = RETRO_PIXEL_FORMAT_XRGB8888;
+        if (environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &fmt))
+            xrgb8888 = true;
+        else
+        {
+            fmt = RETRO_PIXEL_FORMAT_RGB565;
+            if (!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &fmt))
+                pixel_format = RGB555;
+        }
     }
     S9xGraphicsDeinit();
     S9xSetRenderPixelFormat(pixel_format);
     S9xGraphicsInit();
 
+    // The core fills GFX.Screen32 as each frame is presented.
+    free(GFX.Screen32);
+    GFX.Screen32 = NULL;
+    if (xrgb8888)
+    {
+        GFX.Pitch32 = MAX_SNES_WIDTH * sizeof(uint32);
+        GFX.Screen32 = (uint32*) calloc(1, GFX.Pitch32 * MAX_SNES_HEIGHT);
+    }
+
     memset(info,0,sizeof(retro_system_av_info));
 
     info->geometry.base_width = SNES_WIDTH;
@@ -364,6 +381,8 @@ void retro_init()
    {
       if (!environ_cb(RETRO_ENVIRONMENT_GET_OVERSCAN, &use_overscan))
          use_overscan = false;
+      if (!environ_cb(RETRO_ENVIRONMENT_GET_CAN_DUPE, &can_dupe))
+         can_dupe = false;
    }
 
    if (environ_cb(RETRO_ENVIRONMENT_GET_LOG_INTERFACE, &log))
@@ -629,6 +648,8 @@ void retro_deinit()
    S9xUnmapAllControls();
    
    free(GFX.Screen);
+   free(GFX.Screen32);
+   GFX.Screen32 = NULL;
 }
 
 
@@ -735,18 +756,32 @@ bool8 S9xDeinitUpdate(int width, int height)
       if (height > SNES_HEIGHT_EXTENDED)
       {
          if (height < SNES_HEIGHT_EXTENDED << 1)
+         {
              memset(GFX.Screen + (GFX.Pitch >> 1) * height,0,GFX.Pitch * ((SNES_HEIGHT_EXTENDED << 1) - height));
+             if (GFX.Screen32)
+                 memset(GFX.Screen32 + (GFX.Pitch32 >> 2) * height,0,GFX.Pitch32 * ((SNES_HEIGHT_EXTENDED << 1) - height));
+         }
          height = SNES_HEIGHT_EXTENDED << 1;
       }
       else
       {
          if (height < SNES_HEIGHT_EXTENDED)
+         {
             memset(GFX.Screen + (GFX.Pitch >> 1) * height,0,GFX.Pitch * (SNES_HEIGHT_EXTENDED - height));
+            if (GFX.Screen32)
+               memset(GFX.Screen32 + (GFX.Pitch32 >> 2) * height,0,GFX.Pitch32 * (SNES_HEIGHT_EXTENDED - height));
+         }
          height = SNES_HEIGHT_EXTENDED;
       }
    }
 
-   s9x_video_cb(GFX.Screen, width, height, GFX.Pitch);
+   // Unchanged frames are duped by the frontend instead of being sent again
+   if (can_dupe && !GFX.FrameChanged)
+      s9x_video_cb(NULL, width, height, GFX.Screen32 ? GFX.Pitch32 : GFX.Pitch);
+   else if (GFX.Screen32)
+      s9x_video_cb(GFX.Screen32, width, height, GFX.Pitch32);
+   else
+      s9x_video_cb(GFX.Screen, width, height, GFX.Pitch);
    return TRUE;
 }
 
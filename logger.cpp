@@ -180,10 +180,10 @@
 #include "movie.h"
 #include "logger.h"
 
-static int	resetno = 0;
-static int	framecounter = 0;
-static FILE	*video = NULL;
-static FILE	*audio = NULL;
+static S9X_TLS int	resetno = 0;
+static S9X_TLS int	framecounter = 0;
+static S9X_TLS FILE	*video = NULL;
+static S9X_TLS FILE	*audio = NULL;
 
 
 void S9xResetLogger (void)
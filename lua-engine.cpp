@@ -11,12 +11,16 @@
 #include "screenshot.h"
 #include "controls.h"
 #include "lua-engine.h"
+#include "audiocapture.h"
 #include <assert.h>
 #include <vector>
 #include <map>
 #include <string>
 #include <algorithm>
 #include "zlib.h"
+#ifndef __WIN32__
+#include "rollout.h"
+#endif
 
 #ifdef __WIN32__
 #define NOMINMAX
@@ -1708,6 +1712,9 @@ DEFINE_LUA_FUNCTION(emu_frameadvance, "")
 	}
 	*/
 	S9xMainLoop();
+#ifndef __WIN32__
+	if (!S9xInRollout()) // a forked child must not touch the parent's display
+#endif
 	S9xProcessEvents(FALSE);
 
 	return 0;
@@ -2860,7 +2867,7 @@ DEFINE_LUA_FUNCTION(joy_peekup, "[controller=1]")
 static const struct ColorMapping
 {
 	const char* name;
-	int value;
+	uint32 value;
 }
 s_colorMapping [] =
 {
@@ -3541,6 +3548,7 @@ static FORCEINLINE void RGB555ToRGB888(uint32& r, uint32& g, uint32& b, bool rot
 DEFINE_LUA_FUNCTION(gui_getpixel, "x,y")
 {
 	prepare_reading();
+	S9xFinishRendering();
 
 	int x = luaL_checkinteger(L,1);
 	int y = luaL_checkinteger(L,2);
@@ -3631,6 +3639,8 @@ DEFINE_LUA_FUNCTION(gui_settransparency, "transparency_4_to_0")
 // example: gd.createFromGdStr(gui.gdscreenshot()):png("outputimage.png")
 DEFINE_LUA_FUNCTION(gui_gdscreenshot, "")
 {
+	S9xFinishRendering();
+
 	int width = IPPU.RenderedScreenWidth;
 	int height = IPPU.RenderedScreenHeight;
 
@@ -3676,10 +3686,8 @@ DEFINE_LUA_FUNCTION(gui_gdscreenshot, "")
 	{
 		for (int x = 0; x < width; x++)
 		{
-			uint32	r, g, b;
-
-			DECOMPOSE_PIXEL(screen[x], r, g, b);
-			RGB555ToRGB888(r, g, b);
+			uint32	pixel = GFX.XRGB[screen[x]];
+			uint8	r = pixel >> 16, g = pixel >> 8, b = pixel;
 
 			*(ptr++) = 0;
 			*(ptr++) = r;
@@ -4071,7 +4079,7 @@ DEFINE_LUA_FUNCTION(emu_getlagcount, "")
 }
 DEFINE_LUA_FUNCTION(emu_lagged, "")
 {
-	extern bool8 pad_read;
+	extern S9X_TLS bool8 pad_read;
 	lua_pushboolean(L, !pad_read);
 	return 1;
 }
@@ -4085,6 +4093,141 @@ DEFINE_LUA_FUNCTION(emu_atframeboundary, "")
 	lua_pushboolean(L, !IPPU.InMainLoop);
 	return 1;
 }
+// makes the next frame get rendered even when the frontend is skipping rendering
+// (e.g. unix -headless -norender). only has an effect at a frame boundary.
+DEFINE_LUA_FUNCTION(emu_requestframe, "")
+{
+	if (!IPPU.InMainLoop)
+		IPPU.RenderThisFrame = TRUE;
+	lua_pushboolean(L, !IPPU.InMainLoop);
+	return 1;
+}
+// emu.setrendermask(mask)
+// stops drawing parts of the picture, to save time when a script only looks at some of them.
+// mask is a number or a list like "bg2,bg3,bg4,sub,math,windows" (see -rendermask); "none" draws everything.
+// emulation is not affected, only what ends up on the screen.
+DEFINE_LUA_FUNCTION(emu_setrendermask, "mask")
+{
+	uint8 mask = 0;
+	if (lua_type(L,1) == LUA_TNUMBER)
+	{
+		lua_Integer n = luaL_checkinteger(L,1);
+		if (n < 0 || n > 0xff)
+			luaL_error(L, "render mask %d out of range", (int)n);
+		mask = (uint8)n;
+	}
+	else if (!S9xParseRenderMask(luaL_checkstring(L,1), &mask))
+		luaL_error(L, "invalid render mask \"%s\"", lua_tostring(L,1));
+
+	Settings.RenderMask = mask;
+	PPU.RecomputeClipWindows = TRUE;
+	return 0;
+}
+DEFINE_LUA_FUNCTION(emu_getrendermask, "")
+{
+	lua_pushinteger(L, Settings.RenderMask);
+	return 1;
+}
+#ifndef __WIN32__
+unsigned char* LuaStackToBinary(lua_State* L, unsigned int& size);
+void BinaryToLuaStack(lua_State* L, const unsigned char* data, unsigned int size, unsigned int itemsToLoad);
+
+struct LuaRollout
+{
+	lua_State* L;
+	int func;
+};
+
+// runs in the forked child: calls func(index) and packs (ok, result) for the parent
+static uint32 LuaRolloutFunc(int index, void* data, uint8** result)
+{
+	LuaRollout* rollout = (LuaRollout*)data;
+	lua_State* L = rollout->L;
+
+	lua_pushvalue(L, rollout->func);
+	lua_pushinteger(L, index + 1);
+	bool ok = lua_pcall(L, 1, 1, 0) == 0;
+
+	// serialize from a fresh stack, since LuaStackToBinary packs everything on it
+	lua_State* T = lua_newthread(L);
+	lua_pushboolean(T, ok);
+	lua_pushvalue(L, -2);
+	lua_xmove(L, T, 1);
+
+	unsigned int size = 0;
+	unsigned char* bin = LuaStackToBinary(T, size);
+	*result = (uint8*)malloc(size);
+	if(*result)
+		memcpy(*result, bin, size);
+	delete[] bin;
+	return *result ? size : 0;
+}
+
+// emu.fork(n, func [, keepstate])
+// forks n copies of the emulator, each starting from the current state and sharing unmodified memory
+// with this one, and runs func(i) in copy i with rendering and throttling turned off.
+// returns a table with one entry per copy: {ok=, result=, hash=, status=, state=}
+// where result is func's return value (or the error message if ok is false),
+// hash is a hash of WRAM/VRAM/SRAM/OAM/CGRAM at the end of the rollout,
+// and state is a savestate object holding the final state if keepstate is true.
+DEFINE_LUA_FUNCTION(emu_fork, "n,func[,keepstate]")
+{
+	int n = luaL_checkinteger(L,1);
+	luaL_checktype(L, 2, LUA_TFUNCTION);
+	bool8 keepState = lua_toboolean(L,3);
+	luaL_argcheck(L, n > 0, 1, "must be positive");
+
+	LuaRollout rollout = { L, 2 };
+	std::vector<SRollout> rollouts(n);
+	S9xForkRollouts(n, LuaRolloutFunc, &rollout, keepState, &rollouts[0]);
+
+	lua_createtable(L, n, 0);
+	for(int i = 0; i < n; i++)
+	{
+		SRollout& r = rollouts[i];
+
+		lua_createtable(L, 0, 5);
+		lua_pushinteger(L, r.status);
+		lua_setfield(L, -2, "status");
+		lua_pushnumber(L, r.hash);
+		lua_setfield(L, -2, "hash");
+
+		if(r.status == 0 && r.result_size)
+		{
+			int top = lua_gettop(L);
+			BinaryToLuaStack(L, r.result, r.result_size, 2);
+			if(lua_gettop(L) == top + 2)
+			{
+				lua_setfield(L, top, "result");
+				lua_setfield(L, top, "ok");
+			}
+			lua_settop(L, top);
+		}
+		else
+		{
+			lua_pushboolean(L, false);
+			lua_setfield(L, -2, "ok");
+		}
+
+		if(r.snapshot)
+		{
+			StateData** ppStateData = (StateData**)lua_newuserdata(L, sizeof(StateData*));
+			*ppStateData = new StateData();
+			(*ppStateData)->buffer = r.snapshot;
+			(*ppStateData)->size = r.snapshot_size;
+			r.snapshot = NULL;
+			luaL_getmetatable(L, "StateData*");
+			lua_setmetatable(L, -2);
+			lua_setfield(L, -2, "state");
+		}
+
+		lua_rawseti(L, -2, i + 1);
+	}
+
+	S9xFreeRollouts(n, &rollouts[0]);
+	return 1;
+}
+#endif
 DEFINE_LUA_FUNCTION(movie_getlength, "")
 {
 	lua_pushinteger(L, S9xMovieGetLength());
@@ -4185,7 +4328,7 @@ DEFINE_LUA_FUNCTION(movie_play, "[filename]")
 	int err = S9xMovieOpen (filename, readonly);
 	if(err != SUCCESS)
 	{
-		char* errorMsg = "Could not open movie file.";
+		const char* errorMsg = "Could not open movie file.";
 		switch(err)
 		{
 		case FILE_NOT_FOUND:
@@ -4198,7 +4341,7 @@ DEFINE_LUA_FUNCTION(movie_play, "[filename]")
 			errorMsg = "Unsupported movie version.";
 			break;
 		}
-		luaL_error(L, errorMsg);
+		luaL_error(L, "%s", errorMsg);
 		return false;
 	}
     return 0;
@@ -4217,6 +4360,23 @@ DEFINE_LUA_FUNCTION(movie_close, "")
 	return 0;
 }
 
+DEFINE_LUA_FUNCTION(sound_startcapture, "filename")
+{
+	const char *filename = luaL_checkstring(L, 1);
+	lua_pushboolean(L, S9xAudioCaptureStart(filename));
+	return 1;
+}
+DEFINE_LUA_FUNCTION(sound_stopcapture, "")
+{
+	S9xAudioCaptureStop();
+	return 0;
+}
+DEFINE_LUA_FUNCTION(sound_capturing, "")
+{
+	lua_pushboolean(L, S9xAudioCaptureActive());
+	return 1;
+}
+
 #ifdef __WIN32__
 const char* s_keyToName[256] =
 {
@@ -4418,9 +4578,9 @@ DEFINE_LUA_FUNCTION(input_getup, "")
 
 #include "../apu/bapu/snes/snes.hpp"
 #if defined(DEBUGGER)
-	extern SNES::SMPDebugger SNES::smp;
+	extern S9X_TLS SNES::SMPDebugger SNES::smp;
 #else
-	extern SNES::SMP SNES::smp;
+	extern S9X_TLS SNES::SMP SNES::smp;
 #endif
 #define APURAM  SNES::smp.apuram
 
@@ -4597,6 +4757,12 @@ static const struct luaL_reg emulib [] =
 	{"lagged", emu_lagged},
 	{"emulating", emu_emulating},
 	{"atframeboundary", emu_atframeboundary},
+	{"requestframe", emu_requestframe},
+	{"setrendermask", emu_setrendermask},
+	{"getrendermask", emu_getrendermask},
+#ifndef __WIN32__
+	{"fork", emu_fork},
+#endif
 	{"registerbefore", emu_registerbefore},
 	{"registerafter", emu_registerafter},
 	{"registerstart", emu_registerstart},
@@ -4748,6 +4914,14 @@ static const struct luaL_reg inputlib [] =
 	{"readup", input_getup},
 	{NULL, NULL}
 };
+static const struct luaL_reg soundlib [] =
+{
+	{"startcapture", sound_startcapture},
+	{"stopcapture", sound_stopcapture},
+	{"capturing", sound_capturing},
+
+	{NULL, NULL}
+};
 static const struct luaL_reg movielib [] =
 {
 	{"active", movie_isactive},
@@ -4935,6 +5109,7 @@ void registerLibs(lua_State* L)
 	luaL_register(L, "joypad", joylib); // for game input
 	luaL_register(L, "input", inputlib); // for user input
 	luaL_register(L, "movie", movielib);
+	luaL_register(L, "sound", soundlib);
 	luaL_register(L, "bit", bit_funcs); // LuaBitOp library
 
 	lua_settop(L, 0); // clean the stack, because each call to luaL_register leaves a table on top
@@ -190,6 +190,13 @@
 
 #include <ctype.h>
 
+#ifndef __WIN32__
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "snes9x.h"
 #include "memmap.h"
 #include "apu/apu.h"
@@ -213,8 +220,10 @@
 #define min(a, b) (((a) < (b)) ? (a) : (b))
 #endif
 
-static bool8	stopMovie = TRUE;
-static char		LastRomFilename[PATH_MAX + 1] = "";
+#define ROM_BUFFER_SIZE	(CMemory::MAX_ROM_SIZE + 0x200 + 0x8000)
+
+static S9X_TLS bool8	stopMovie = TRUE;
+static S9X_TLS char		LastRomFilename[PATH_MAX + 1] = "";
 
 // from NSRT
 static const char	*nintendo_licensees[] =
@@ -1059,20 +1068,66 @@ static void S9xDeinterleaveGD24 (int size, uint8 *base)
 
 // allocation and deallocation
 
+// The big buffers start on their own pages, so a fork()ed rollout (see rollout.h)
+// only copies the pages it writes and keeps sharing the ROM with its parent.
+static uint8 * AllocPages (size_t size)
+{
+#ifdef __WIN32__
+	return ((uint8 *) malloc(size));
+#else
+	void	*p;
+
+	return (posix_memalign(&p, 4096, size) ? NULL : (uint8 *) p);
+#endif
+}
+
+// The ROM buffer is a mapping of its own, so a shared ROM image can be mapped over
+// it and untouched space is never committed.
+static uint8 * AllocROM (void)
+{
+#ifdef __WIN32__
+	return ((uint8 *) calloc(ROM_BUFFER_SIZE, 1));
+#else
+	void	*p = mmap(NULL, ROM_BUFFER_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	return ((p == MAP_FAILED) ? NULL : (uint8 *) p);
+#endif
+}
+
+static void FreeROM (uint8 *p)
+{
+#ifdef __WIN32__
+	free(p);
+#else
+	munmap(p, ROM_BUFFER_SIZE);
+#endif
+}
+
+// Empties the ROM area (not FillRAM) before loading a new image.
+static void ClearROM (uint8 *rom)
+{
+#ifndef __WIN32__
+	// fresh zero pages also drop a previously mapped shared image
+	if (mmap(rom, CMemory::MAX_ROM_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED)
+		return;
+#endif
+	memset(rom, 0, CMemory::MAX_ROM_SIZE);
+}
+
 bool8 CMemory::Init (void)
 {
-    RAM	 = (uint8 *) malloc(0x20000);
-    SRAM = (uint8 *) malloc(0x20000);
-    VRAM = (uint8 *) malloc(0x10000);
-    ROM  = (uint8 *) malloc(MAX_ROM_SIZE + 0x200 + 0x8000);
-
-	IPPU.TileCache[TILE_2BIT]       = (uint8 *) malloc(MAX_2BIT_TILES * 64);
-	IPPU.TileCache[TILE_4BIT]       = (uint8 *) malloc(MAX_4BIT_TILES * 64);
-	IPPU.TileCache[TILE_8BIT]       = (uint8 *) malloc(MAX_8BIT_TILES * 64);
-	IPPU.TileCache[TILE_2BIT_EVEN]  = (uint8 *) malloc(MAX_2BIT_TILES * 64);
-	IPPU.TileCache[TILE_2BIT_ODD]   = (uint8 *) malloc(MAX_2BIT_TILES * 64);
-	IPPU.TileCache[TILE_4BIT_EVEN]  = (uint8 *) malloc(MAX_4BIT_TILES * 64);
-	IPPU.TileCache[TILE_4BIT_ODD]   = (uint8 *) malloc(MAX_4BIT_TILES * 64);
+    RAM	 = AllocPages(0x20000);
+    SRAM = AllocPages(0x20000);
+    VRAM = AllocPages(0x10000);
+    ROM  = AllocROM();
+
+	IPPU.TileCache[TILE_2BIT]       = AllocPages(MAX_2BIT_TILES * 64);
+	IPPU.TileCache[TILE_4BIT]       = AllocPages(MAX_4BIT_TILES * 64);
+	IPPU.TileCache[TILE_8BIT]       = AllocPages(MAX_8BIT_TILES * 64);
+	IPPU.TileCache[TILE_2BIT_EVEN]  = AllocPages(MAX_2BIT_TILES * 64);
+	IPPU.TileCache[TILE_2BIT_ODD]   = AllocPages(MAX_2BIT_TILES * 64);
+	IPPU.TileCache[TILE_4BIT_EVEN]  = AllocPages(MAX_4BIT_TILES * 64);
+	IPPU.TileCache[TILE_4BIT_ODD]   = AllocPages(MAX_4BIT_TILES * 64);
 
 	IPPU.TileCached[TILE_2BIT]      = (uint8 *) malloc(MAX_2BIT_TILES);
 	IPPU.TileCached[TILE_4BIT]      = (uint8 *) malloc(MAX_4BIT_TILES);
@@ -1105,7 +1160,6 @@ bool8 CMemory::Init (void)
 	memset(RAM, 0,  0x20000);
 	memset(SRAM, 0, 0x20000);
 	memset(VRAM, 0, 0x10000);
-	memset(ROM, 0,  MAX_ROM_SIZE + 0x200 + 0x8000);
 
 	memset(IPPU.TileCache[TILE_2BIT], 0,       MAX_2BIT_TILES * 64);
 	memset(IPPU.TileCache[TILE_4BIT], 0,       MAX_4BIT_TILES * 64);
@@ -1172,7 +1226,7 @@ void CMemory::Deinit (void)
 	if (ROM)
 	{
 		ROM -= 0x8000;
-		free(ROM);
+		FreeROM(ROM);
 		ROM = NULL;
 	}
 
@@ -1521,7 +1575,7 @@ bool8 CMemory::LoadROMMem (const uint8 *source, uint32 sourceSize)
 
     do
     {
-        memset(ROM,0, MAX_ROM_SIZE);
+        ClearROM(ROM);
         memset(&Multi, 0,sizeof(Multi));
         memcpy(ROM,source,sourceSize);
     }
@@ -1539,7 +1593,7 @@ bool8 CMemory::LoadROM (const char *filename)
 
     do
     {
-        memset(ROM,0, MAX_ROM_SIZE);
+        ClearROM(ROM);
         memset(&Multi, 0,sizeof(Multi));
         totalFileSize = FileLoader(ROM, filename, MAX_ROM_SIZE);
 
@@ -1559,6 +1613,48 @@ bool8 CMemory::LoadROMInt (int32 ROMfillSize)
 	Settings.DisplayColor = BUILD_PIXEL(31, 31, 31);
 	SET_UI_COLOR(255, 255, 255);
 
+#ifndef __WIN32__
+	char	shared[PATH_MAX + 1];
+
+	if (Settings.SharedROM)
+		SharedROMPath(shared, ROM, ROMfillSize);
+
+	if (!Settings.SharedROM || !MapSharedROM(shared, ROMfillSize))
+#endif
+	{
+		if (!PrepareROM(ROMfillSize))
+			return (FALSE);
+
+#ifndef __WIN32__
+		if (Settings.SharedROM)
+			SaveSharedROM(shared, ROMfillSize);
+#endif
+	}
+
+	if (strncmp(LastRomFilename, ROMFilename, PATH_MAX + 1))
+	{
+		strncpy(LastRomFilename, ROMFilename, PATH_MAX + 1);
+		LastRomFilename[PATH_MAX] = 0;
+	}
+
+	memset(&SNESGameFixes, 0, sizeof(SNESGameFixes));
+	SNESGameFixes.SRAMInitialValue = 0x60;
+
+	S9xLoadCheatFile(S9xGetFilename(".cht", CHEAT_DIR));
+
+	InitROM();
+
+	S9xInitCheatData();
+	S9xApplyCheats(FALSE);
+
+	S9xReset();
+
+    return (TRUE);
+}
+
+// Removes the header and undoes interleaving of a freshly loaded image.
+bool8 CMemory::PrepareROM (int32 ROMfillSize)
+{
 	CalculatedSize = 0;
 	ExtendedFormat = NOPE;
 
@@ -1747,33 +1843,126 @@ bool8 CMemory::LoadROMInt (int32 ROMfillSize)
 		}
 	}
 
-	if (strncmp(LastRomFilename, ROMFilename, PATH_MAX + 1))
+	return (TRUE);
+}
+
+#ifndef __WIN32__
+
+// Shared ROM images (Settings.SharedROM): a prepared image is stored in /dev/shm,
+// named after a hash of the raw image and the options that affect preparing it.
+// Later loads of the same ROM, in this or any other process, map that file over
+// the ROM buffer instead of preparing it again. The mapping is private, so all
+// users read the same page cache pages and a game (or a cheat, or a ROM fix)
+// writing to ROM only gets a copy of the pages it touches.
+
+#define SHARED_ROM_MAGIC	0x4d4f5253
+#define SHARED_ROM_OFFSET	4096
+
+struct SSharedROMHeader
+{
+	uint32	magic;
+	uint32	size;
+	uint32	calculated_size;
+	uint8	extended_format;
+	uint8	lorom;
+	uint8	hirom;
+	uint8	header_count;
+};
+
+static uint32 SharedROMSize (int32 fillsize)
+{
+	return ((fillsize + 4095) & ~4095);
+}
+
+void CMemory::SharedROMPath (char *path, const uint8 *data, int32 fillsize)
+{
+	const uint8	options[] =
 	{
-		strncpy(LastRomFilename, ROMFilename, PATH_MAX + 1);
-		LastRomFilename[PATH_MAX] = 0;
-	}
+		Settings.ForceLoROM, Settings.ForceHiROM, Settings.ForceHeader, Settings.ForceNoHeader,
+		Settings.ForceInterleaved, Settings.ForceInterleaved2, Settings.ForceInterleaveGD24, Settings.ForceNotInterleaved,
+		HeaderCount != 0
+	};
 
-	memset(&SNESGameFixes, 0, sizeof(SNESGameFixes));
-	SNESGameFixes.SRAMInitialValue = 0x60;
+	uint64	hash = 0xcbf29ce484222325ULL; // FNV-1a
 
-	S9xLoadCheatFile(S9xGetFilename(".cht", CHEAT_DIR));
+	for (int32 i = 0; i < fillsize; i++)
+		hash = (hash ^ data[i]) * 0x100000001b3ULL;
 
-	InitROM();
+	for (uint32 i = 0; i < sizeof(options); i++)
+		hash = (hash ^ options[i]) * 0x100000001b3ULL;
 
-	S9xInitCheatData();
-	S9xApplyCheats(FALSE);
+	snprintf(path, PATH_MAX + 1, "/dev/shm/snes9x-rom-%08x%08x-%x", (uint32) (hash >> 32), (uint32) hash, fillsize);
+}
 
-	S9xReset();
+bool8 CMemory::MapSharedROM (const char *path, int32 fillsize)
+{
+	SSharedROMHeader	header;
 
-    return (TRUE);
+	int	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return (FALSE);
+
+	void	*p = MAP_FAILED;
+
+	if (read(fd, &header, sizeof(header)) == sizeof(header) &&
+		header.magic == SHARED_ROM_MAGIC && header.size == SharedROMSize(fillsize))
+		p = mmap(ROM, header.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, SHARED_ROM_OFFSET);
+
+	close(fd);
+
+	if (p == MAP_FAILED)
+		return (FALSE);
+
+	CalculatedSize = header.calculated_size;
+	ExtendedFormat = header.extended_format;
+	LoROM = header.lorom;
+	HiROM = header.hirom;
+	HeaderCount = header.header_count;
+
+	return (TRUE);
 }
 
+void CMemory::SaveSharedROM (const char *path, int32 fillsize)
+{
+	SSharedROMHeader	header;
+	char				tmp[PATH_MAX + 1];
+
+	memset(&header, 0, sizeof(header));
+	header.magic = SHARED_ROM_MAGIC;
+	header.size = SharedROMSize(fillsize);
+	header.calculated_size = CalculatedSize;
+	header.extended_format = ExtendedFormat;
+	header.lorom = LoROM;
+	header.hirom = HiROM;
+	header.header_count = HeaderCount;
+
+	// write to a temporary file first, so nobody maps a half-written image
+	snprintf(tmp, PATH_MAX + 1, "%s.XXXXXX", path);
+
+	int	fd = mkstemp(tmp);
+	if (fd < 0)
+		return;
+
+	bool8	ok = fchmod(fd, 0644) == 0 &&
+				 pwrite(fd, &header, sizeof(header), 0) == sizeof(header) &&
+				 pwrite(fd, ROM, header.size, SHARED_ROM_OFFSET) == (ssize_t) header.size;
+
+	close(fd);
+
+	if (ok && rename(tmp, path) == 0)
+		MapSharedROM(path, fillsize);
+	else
+		unlink(tmp);
+}
+
+#endif
+
 bool8 CMemory::LoadMultiCartMem (const uint8 *sourceA, uint32 sourceASize,
                                  const uint8 *sourceB, uint32 sourceBSize,
                                  const uint8 *bios, uint32 biosSize)
 {
     uint32 offset = 0;
-    memset(ROM, 0, MAX_ROM_SIZE);
+    ClearROM(ROM);
 	memset(&Multi, 0, sizeof(Multi));
 
     if(bios) {
@@ -1805,7 +1994,7 @@ bool8 CMemory::LoadMultiCartMem (const uint8 *sourceA, uint32 sourceASize,
 
 bool8 CMemory::LoadMultiCart (const char *cartA, const char *cartB)
 {
-    memset(ROM, 0, MAX_ROM_SIZE);
+    ClearROM(ROM);
 	memset(&Multi, 0, sizeof(Multi));
 
 	Settings.DisplayColor = BUILD_PIXEL(31, 31, 31);
@@ -2209,8 +2398,8 @@ static uint32 caCRC32 (uint8 *array, uint32 size, uint32 crc32)
 
 char * CMemory::Safe (const char *s)
 {
-	static char	*safe = NULL;
-	static int	safe_len = 0;
+	static S9X_TLS char	*safe = NULL;
+	static S9X_TLS int	safe_len = 0;
 
 	if (s == NULL)
 	{
@@ -2248,8 +2437,8 @@ char * CMemory::Safe (const char *s)
 
 char * CMemory::SafeANK (const char *s)
 {
-	static char	*safe = NULL;
-	static int	safe_len = 0;
+	static S9X_TLS char	*safe = NULL;
+	static S9X_TLS int	safe_len = 0;
 
 	if (s == NULL)
 	{
@@ -2596,6 +2785,8 @@ void CMemory::InitROM (void)
 			Map_LoROMMap();
     }
 
+	UpdateMemorySpeed();
+
 	Checksum_Calculate();
 
 	bool8 isChecksumOK = (ROMChecksum + ROMComplementChecksum == 0xffff) &
@@ -2969,6 +3160,31 @@ void CMemory::map_WriteProtectROM (void)
 	}
 }
 
+void CMemory::UpdateMemorySpeed (void)
+{
+	// Access speed of each block, so that the direct pointer path of the accessors
+	// doesn't have to decode the address. Only the $4000 block in the system banks
+	// mixes speeds, and that one is always MAP_CPU, which asks memory_speed() itself.
+	// Must be redone whenever CPU.FastROMSpeed changes.
+	for (int c = 0; c < 0x1000; c++)
+		MemorySpeed[c] = (uint8) memory_speed(c << MEMMAP_SHIFT);
+}
+
+void CMemory::map_SA1SharedRAM (void)
+{
+	// Route the S-CPU side of I-RAM and BW-RAM through the slow path,
+	// so that the SA-1 can be caught up before any shared access.
+	// SA1.Map keeps its direct pointers.
+	for (int c = 0; c < 0x1000; c++)
+	{
+		if (Map[c] == FillRAM && (c & 0xf) == 3)
+			Map[c] = WriteMap[c] = (uint8 *) MAP_IRAM;
+		else
+		if (Map[c] == SRAM || Map[c] == SRAM + 0x10000)
+			Map[c] = WriteMap[c] = (uint8 *) MAP_BWRAM_LINEAR;
+	}
+}
+
 void CMemory::Map_Initialize (void)
 {
 	for (int c = 0; c < 0x1000; c++)
@@ -3237,6 +3453,8 @@ void CMemory::Map_SA1LoROMMap (void)
 	for (int c = 0x600; c < 0x700; c++)
 		SA1.Map[c] = SA1.WriteMap[c] = (uint8 *) MAP_BWRAM_BITMAP;
 
+	map_SA1SharedRAM();
+
 	BWRAM = SRAM;
 }
 
@@ -3282,6 +3500,8 @@ void CMemory::Map_GNEXTSA1LoROMMap (void)
 	for (int c = 0x600; c < 0x700; c++)
 		SA1.Map[c] = SA1.WriteMap[c] = (uint8 *) MAP_BWRAM_BITMAP;
 
+	map_SA1SharedRAM();
+
 	BWRAM = SRAM;
 }
 
@@ -3433,7 +3653,7 @@ const char * CMemory::MapType (void)
 
 const char * CMemory::StaticRAMSize (void)
 {
-	static char	str[20];
+	static S9X_TLS char	str[20];
 
 	if (SRAMSize > 16)
 		strcpy(str, "Corrupt");
@@ -3445,7 +3665,7 @@ const char * CMemory::StaticRAMSize (void)
 
 const char * CMemory::Size (void)
 {
-	static char	str[20];
+	static S9X_TLS char	str[20];
 
 	if (Multi.cartType == 4)
 		strcpy(str, "N/A");
@@ -3460,7 +3680,7 @@ const char * CMemory::Size (void)
 
 const char * CMemory::Revision (void)
 {
-	static char	str[20];
+	static S9X_TLS char	str[20];
 
 	sprintf(str, "1.%d", HiROM ? ((ExtendedFormat != NOPE) ? ROM[0x40ffdb] : ROM[0xffdb]) : ROM[0x7fdb]);
 
@@ -3469,7 +3689,7 @@ const char * CMemory::Revision (void)
 
 const char * CMemory::KartContents (void)
 {
-	static char			str[64];
+	static S9X_TLS char			str[64];
 	static const char	*contents[3] = { "ROM", "ROM+RAM", "ROM+RAM+BAT" };
 
 	char	chip[16];
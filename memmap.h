@@ -210,6 +210,8 @@ struct CMemory
 		MAP_BWRAM,
 		MAP_BWRAM_BITMAP,
 		MAP_BWRAM_BITMAP2,
+		MAP_BWRAM_LINEAR,
+		MAP_IRAM,
 		MAP_SPC7110_ROM,
 		MAP_SPC7110_DRAM,
 		MAP_RONLY_SRAM,
@@ -240,6 +242,7 @@ struct CMemory
 	uint8	*WriteMap[MEMMAP_NUM_BLOCKS];
 	uint8	BlockIsRAM[MEMMAP_NUM_BLOCKS];
 	uint8	BlockIsROM[MEMMAP_NUM_BLOCKS];
+	uint8	MemorySpeed[MEMMAP_NUM_BLOCKS];
 	uint8	ExtendedFormat;
 
 	char	ROMFilename[PATH_MAX + 1];
@@ -277,6 +280,10 @@ struct CMemory
     bool8   LoadROMMem (const uint8 *, uint32);
 	bool8	LoadROM (const char *);
     bool8	LoadROMInt (int32);
+	bool8	PrepareROM (int32);
+	void	SharedROMPath (char *, const uint8 *, int32);
+	bool8	MapSharedROM (const char *, int32);
+	void	SaveSharedROM (const char *, int32);
     bool8   LoadMultiCartMem (const uint8 *, uint32, const uint8 *, uint32, const uint8 *, uint32);
 	bool8	LoadMultiCart (const char *, const char *);
     bool8	LoadMultiCartInt ();
@@ -311,6 +318,8 @@ struct CMemory
 	void	map_SetaRISC (void);
 	void	map_SetaDSP (void);
 	void	map_WriteProtectROM (void);
+	void	map_SA1SharedRAM (void);
+	void	UpdateMemorySpeed (void);
 	void	Map_Initialize (void);
 	void	Map_LoROMMap (void);
 	void	Map_NoMAD1LoROMMap (void);
@@ -362,8 +371,8 @@ struct SMulti
 	char	fileNameA[PATH_MAX + 1], fileNameB[PATH_MAX + 1];
 };
 
-extern CMemory	Memory;
-extern SMulti	Multi;
+extern S9X_TLS CMemory	Memory;
+extern S9X_TLS SMulti	Multi;
 
 void S9xAutoSaveSRAM (void);
 bool8 LoadZip(const char *, uint32 *, uint8 *);
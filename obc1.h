@@ -186,7 +186,7 @@ struct SOBC1
 	uint16	shift;
 };
 
-extern struct SOBC1	OBC1;
+extern S9X_TLS struct SOBC1	OBC1;
 
 void S9xSetOBC1 (uint8, uint16);
 uint8 S9xGetOBC1 (uint16);
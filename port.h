@@ -280,6 +280,14 @@ typedef int					pint;
 #define START_EXTERN_C	extern "C" {
 #define END_EXTERN_C	}
 
+// With S9X_MULTI_INSTANCE every piece of emulated machine state is thread-local,
+// so each thread that drives the core owns a separate SNES (see context.h).
+#ifdef S9X_MULTI_INSTANCE
+#define S9X_TLS	thread_local
+#else
+#define S9X_TLS
+#endif
+
 #ifndef __WIN32__
 #ifndef PATH_MAX
 #define PATH_MAX	1024
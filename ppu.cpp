@@ -194,7 +194,7 @@
 #include "missing.h"
 #endif
 
-extern uint8	*HDMAMemPointers[8];
+extern S9X_TLS uint8	*HDMAMemPointers[8];
 
 
 static inline void S9xLatchCounters (bool force)
@@ -1052,6 +1052,7 @@ void S9xSetPPU (uint8 Byte, uint16 Address)
 		else
 		if (Settings.SA1     && Address >= 0x2200)
 		{
+			S9xSA1Sync();
 			if (Address <= 0x23ff)
 				S9xSetSA1(Byte, Address);
 			else
@@ -1317,7 +1318,10 @@ uint8 S9xGetPPU (uint16 Address)
 			return (S9xGetSuperFX(Address));
 		else
 		if (Settings.SA1     && Address >= 0x2200)
+		{
+			S9xSA1Sync();
 			return (S9xGetSA1(Address));
+		}
 		else
 		if (Settings.BS      && Address >= 0x2188 && Address <= 0x219f)
 			return (S9xGetBSXPPU(Address));
@@ -1637,6 +1641,8 @@ void S9xSetCPU (uint8 Byte, uint16 Address)
 					}
 					else
 						CPU.FastROMSpeed = SLOW_ONE_CYCLE;
+
+					Memory.UpdateMemorySpeed();
 				}
 
 				break;
@@ -1677,7 +1683,7 @@ uint8 S9xGetCPU (uint16 Address)
 	if (Address < 0x4200)
 	{
 	#ifdef SNES_JOY_READ_CALLBACKS
-		extern bool8 pad_read;
+		extern S9X_TLS bool8 pad_read;
 		if (Address == 0x4016 || Address == 0x4017)
 		{
 			S9xOnSNESPadRead();
@@ -1789,7 +1795,7 @@ uint8 S9xGetCPU (uint16 Address)
 			case 0x421e: // JOY4L
 			case 0x421f: // JOY4H
 			#ifdef SNES_JOY_READ_CALLBACKS
-				extern bool8 pad_read;
+				extern S9X_TLS bool8 pad_read;
 				if (Memory.FillRAM[0x4200] & 1)
 				{
 					S9xOnSNESPadRead();
@@ -1818,7 +1824,7 @@ void S9xResetPPU (void)
 
 	IPPU.TotalEmulatedFrames = 0;
 	IPPU.PadIgnoredFrames = 0;
-	extern bool8 pad_read, pad_read_last;
+	extern S9X_TLS bool8 pad_read, pad_read_last;
 	pad_read = pad_read_last = FALSE;
 }
 
@@ -1967,6 +1973,7 @@ void S9xSoftResetPPU (void)
 	memset(IPPU.TileCached[TILE_2BIT_ODD], 0,  MAX_2BIT_TILES);
 	memset(IPPU.TileCached[TILE_4BIT_EVEN], 0, MAX_4BIT_TILES);
 	memset(IPPU.TileCached[TILE_4BIT_ODD], 0,  MAX_4BIT_TILES);
+	memset(IPPU.TileDirty, 0xff, sizeof(IPPU.TileDirty)); // all of VRAM is new to the render thread
 	IPPU.VRAMReadBuffer = 0; // XXX: FIXME: anything better?
 	IPPU.Interlace = FALSE;
 	IPPU.InterlaceOBJ = FALSE;
@@ -0,0 +1,385 @@
+/***********************************************************************************
+  Snes9x - Portable Super Nintendo Entertainment System (TM) emulator.
+
+  (c) Copyright 1996 - 2002  Gary Henderson (gary.henderson@ntlworld.com),
+                             Jerremy Koot (jkoot@snes9x.com)
+
+  (c) Copyright 2002 - 2004  Matthew Kendora
+
+  (c) Copyright 2002 - 2005  Peter Bortas (peter@bortas.org)
+
+  (c) Copyright 2004 - 2005  Joel Yliluoma (http://iki.fi/bisqwit/)
+
+  (c) Copyright 2001 - 2006  John Weidman (jweidman@slip.net)
+
+  (c) Copyright 2002 - 2006  funkyass (funkyass@spam.shaw.ca),
+                             Kris Bleakley (codeviolation@hotmail.com)
+
+  (c) Copyright 2002 - 2010  Brad Jorsch (anomie@users.sourceforge.net),
+                             Nach (n-a-c-h@users.sourceforge.net),
+
+  (c) Copyright 2002 - 2011  zones (kasumitokoduck@yahoo.com)
+
+  (c) Copyright 2006 - 2007  nitsuja
+
+  (c) Copyright 2009 - 2011  BearOso,
+                             OV2
+
+
+  BS-X C emulator code
+  (c) Copyright 2005 - 2006  Dreamer Nom,
+                             zones
+
+  C4 x86 assembler and some C emulation code
+  (c) Copyright 2000 - 2003  _Demo_ (_demo_@zsnes.com),
+                             Nach,
+                             zsKnight (zsknight@zsnes.com)
+
+  C4 C++ code
+  (c) Copyright 2003 - 2006  Brad Jorsch,
+                             Nach
+
+  DSP-1 emulator code
+  (c) Copyright 1998 - 2006  _Demo_,
+                             Andreas Naive (andreasnaive@gmail.com),
+                             Gary Henderson,
+                             Ivar (ivar@snes9x.com),
+                             John Weidman,
+                             Kris Bleakley,
+                             Matthew Kendora,
+                             Nach,
+                             neviksti (neviksti@hotmail.com)
+
+  DSP-2 emulator code
+  (c) Copyright 2003         John Weidman,
+                             Kris Bleakley,
+                             Lord Nightmare (lord_nightmare@users.sourceforge.net),
+                             Matthew Kendora,
+                             neviksti
+
+  DSP-3 emulator code
+  (c) Copyright 2003 - 2006  John Weidman,
+                             Kris Bleakley,
+                             Lancer,
+                             z80 gaiden
+
+  DSP-4 emulator code
+  (c) Copyright 2004 - 2006  Dreamer Nom,
+                             John Weidman,
+                             Kris Bleakley,
+                             Nach,
+                             z80 gaiden
+
+  OBC1 emulator code
+  (c) Copyright 2001 - 2004  zsKnight,
+                             pagefault (pagefault@zsnes.com),
+                             Kris Bleakley
+                             Ported from x86 assembler to C by sanmaiwashi
+
+  SPC7110 and RTC C++ emulator code used in 1.39-1.51
+  (c) Copyright 2002         Matthew Kendora with research by
+                             zsKnight,
+                             John Weidman,
+                             Dark Force
+
+  SPC7110 and RTC C++ emulator code used in 1.52+
+  (c) Copyright 2009         byuu,
+                             neviksti
+
+  S-DD1 C emulator code
+  (c) Copyright 2003         Brad Jorsch with research by
+                             Andreas Naive,
+                             John Weidman
+
+  S-RTC C emulator code
+  (c) Copyright 2001 - 2006  byuu,
+                             John Weidman
+
+  ST010 C++ emulator code
+  (c) Copyright 2003         Feather,
+                             John Weidman,
+                             Kris Bleakley,
+                             Matthew Kendora
+
+  Super FX x86 assembler emulator code
+  (c) Copyright 1998 - 2003  _Demo_,
+                             pagefault,
+                             zsKnight
+
+  Super FX C emulator code
+  (c) Copyright 1997 - 1999  Ivar,
+                             Gary Henderson,
+                             John Weidman
+
+  Sound emulator code used in 1.5-1.51
+  (c) Copyright 1998 - 2003  Brad Martin
+  (c) Copyright 1998 - 2006  Charles Bilyue'
+
+  Sound emulator code used in 1.52+
+  (c) Copyright 2004 - 2007  Shay Green (gblargg@gmail.com)
+
+  SH assembler code partly based on x86 assembler code
+  (c) Copyright 2002 - 2004  Marcus Comstedt (marcus@mc.pp.se)
+
+  2xSaI filter
+  (c) Copyright 1999 - 2001  Derek Liauw Kie Fa
+
+  HQ2x, HQ3x, HQ4x filters
+  (c) Copyright 2003         Maxim Stepin (maxim@hiend3d.com)
+
+  NTSC filter
+  (c) Copyright 2006 - 2007  Shay Green
+
+  GTK+ GUI code
+  (c) Copyright 2004 - 2011  BearOso
+
+  Win32 GUI code
+  (c) Copyright 2003 - 2006  blip,
+                             funkyass,
+                             Matthew Kendora,
+                             Nach,
+                             nitsuja
+  (c) Copyright 2009 - 2011  OV2
+
+  Mac OS GUI code
+  (c) Copyright 1998 - 2001  John Stiles
+  (c) Copyright 2001 - 2011  zones
+
+
+  Specific ports contains the works of other authors. See headers in
+  individual files.
+
+
+  Snes9x homepage: http://www.snes9x.com/
+
+  Permission to use, copy, modify and/or distribute Snes9x in both binary
+  and source form, for non-commercial purposes, is hereby granted without
+  fee, providing that this license information and copyright notice appear
+  with all copies and any derived work.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event shall the authors be held liable for any damages
+  arising from the use of this software or it's derivatives.
+
+  Snes9x is freeware for PERSONAL USE only. Commercial users should
+  seek permission of the copyright holders first. Commercial use includes,
+  but is not limited to, charging money for Snes9x or software derived from
+  Snes9x, including Snes9x or derivatives in commercial game bundles, and/or
+  using Snes9x as a promotion for your commercial product.
+
+  The copyright holders request that bug fixes and improvements to the code
+  should be forwarded to them so everyone can benefit from the modifications
+  in future versions.
+
+  Super NES and Super Nintendo Entertainment System are trademarks of
+  Nintendo Co., Limited and its subsidiary companies.
+ ***********************************************************************************/
+
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "snes9x.h"
+#include "memmap.h"
+#include "ppu.h"
+#include "gfx.h"
+#include "apu/apu.h"
+#include "snapshot.h"
+#include "audiocapture.h"
+#include "rollout.h"
+
+static bool8	in_rollout = FALSE;
+
+static bool8 WriteAll (int fd, const uint8 *buf, uint32 size)
+{
+	while (size)
+	{
+		ssize_t	n = write(fd, buf, size);
+		if (n <= 0)
+			return (FALSE);
+
+		buf  += n;
+		size -= n;
+	}
+
+	return (TRUE);
+}
+
+static bool8 ReadAll (int fd, uint8 *buf, uint32 size)
+{
+	while (size)
+	{
+		ssize_t	n = read(fd, buf, size);
+		if (n <= 0)
+			return (FALSE);
+
+		buf  += n;
+		size -= n;
+	}
+
+	return (TRUE);
+}
+
+static void RunRollout (int index, S9xRolloutFunc func, void *data, bool8 snapshot, int fd)
+{
+	in_rollout = TRUE;
+
+	S9xAudioCaptureDetach();
+	S9xDetachRenderThread();
+
+	Settings.SkipRendering = TRUE;
+	Settings.TurboMode = TRUE;
+	Settings.SoundSync = FALSE;
+	S9xSetSoundMute(TRUE);
+	S9xSetSoundSkip(TRUE);
+
+	uint8	*result = NULL, *state = NULL;
+	uint32	header[3];
+
+	header[1] = func(index, data, &result);
+	header[0] = S9xStateHash();
+	header[2] = 0;
+
+	if (snapshot)
+	{
+		uint32	size = S9xFreezeSize();
+
+		state = (uint8 *) malloc(size);
+		if (state && S9xFreezeGameMem(state, size))
+			header[2] = size;
+	}
+
+	bool8	ok = WriteAll(fd, (uint8 *) header, sizeof(header)) &&
+				 WriteAll(fd, result, header[1]) &&
+				 WriteAll(fd, state, header[2]);
+
+	// Leave without running the parent's atexit handlers or flushing its stdio.
+	_exit(ok ? 0 : 1);
+}
+
+bool8 S9xForkRollouts (int n, S9xRolloutFunc func, void *data, bool8 snapshot, SRollout *rollouts)
+{
+	pid_t	*pids = new pid_t[n];
+	int		*fds  = new int[n];
+	bool8	ok = TRUE;
+
+	memset(rollouts, 0, n * sizeof(SRollout));
+
+	// A child cannot wait for the render worker, so leave nothing pending,
+	// and the frame is the parent's to present anyway.
+	S9xFinishRendering();
+
+	fflush(stdout);
+	fflush(stderr);
+
+	for (int i = 0; i < n; i++)
+	{
+		int	p[2];
+
+		pids[i] = -1;
+		fds[i]  = -1;
+
+		if (pipe(p) != 0)
+		{
+			ok = FALSE;
+			continue;
+		}
+
+		pids[i] = fork();
+		if (pids[i] == 0)
+		{
+			for (int j = 0; j < i; j++)
+				if (fds[j] >= 0)
+					close(fds[j]);
+			close(p[0]);
+
+			RunRollout(i, func, data, snapshot, p[1]);
+		}
+
+		close(p[1]);
+
+		if (pids[i] < 0)
+		{
+			close(p[0]);
+			ok = FALSE;
+		}
+		else
+			fds[i] = p[0];
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		SRollout	*r = &rollouts[i];
+		uint32		header[3];
+		bool8		got = FALSE;
+
+		r->status = -1;
+
+		if (fds[i] < 0)
+			continue;
+
+		if (ReadAll(fds[i], (uint8 *) header, sizeof(header)))
+		{
+			r->hash = header[0];
+			r->result_size = header[1];
+			r->snapshot_size = header[2];
+			r->result = r->result_size ? (uint8 *) malloc(r->result_size) : NULL;
+			r->snapshot = r->snapshot_size ? (uint8 *) malloc(r->snapshot_size) : NULL;
+
+			got = (!r->result_size || (r->result && ReadAll(fds[i], r->result, r->result_size))) &&
+				  (!r->snapshot_size || (r->snapshot && ReadAll(fds[i], r->snapshot, r->snapshot_size)));
+		}
+
+		close(fds[i]);
+
+		int	status;
+		if (waitpid(pids[i], &status, 0) == pids[i] && WIFEXITED(status) && got)
+			r->status = WEXITSTATUS(status);
+
+		if (r->status != 0)
+			ok = FALSE;
+	}
+
+	delete [] pids;
+	delete [] fds;
+
+	return (ok);
+}
+
+void S9xFreeRollouts (int n, SRollout *rollouts)
+{
+	for (int i = 0; i < n; i++)
+	{
+		free(rollouts[i].result);
+		free(rollouts[i].snapshot);
+		rollouts[i].result = rollouts[i].snapshot = NULL;
+	}
+}
+
+bool8 S9xInRollout (void)
+{
+	return (in_rollout);
+}
+
+static uint32 HashBytes (uint32 h, const uint8 *p, uint32 size)
+{
+	for (uint32 i = 0; i < size; i++)
+		h = (h ^ p[i]) * 16777619;
+
+	return (h);
+}
+
+// FNV-1a over the memories a game can observe: WRAM, VRAM, SRAM, OAM and CGRAM.
+uint32 S9xStateHash (void)
+{
+	uint32	h = 2166136261u;
+	uint32	sram = Memory.SRAMSize ? (1 << (Memory.SRAMSize + 3)) * 128 : 0;
+
+	h = HashBytes(h, Memory.RAM, 0x20000);
+	h = HashBytes(h, Memory.VRAM, 0x10000);
+	h = HashBytes(h, Memory.SRAM, sram > 0x20000 ? 0x20000 : sram);
+	h = HashBytes(h, PPU.OAMData, sizeof(PPU.OAMData));
+	h = HashBytes(h, (uint8 *) PPU.CGDATA, sizeof(PPU.CGDATA));
+
+	return (h);
+}
@@ -179,7 +179,7 @@
 #include "snes9x.h"
 #include "memmap.h"
 
-uint8	SA1OpenBus;
+S9X_TLS uint8	SA1OpenBus;
 
 static void S9xSA1SetBWRAMMemMap (uint8);
 static void S9xSetSA1MemMap (uint32, uint8);
@@ -217,6 +217,8 @@ void S9xSA1Init (void)
 	SA1.overflow = FALSE;
 	SA1.VirtualBitmapFormat = 0;
 	SA1.variable_bit_pos = 0;
+	SA1.PendingSteps = 0;
+	SA1.BatchSteps = Settings.SA1BatchSteps > 0 ? Settings.SA1BatchSteps : SA1_DEFAULT_BATCH_STEPS;
 
 	SA1Registers.PBPC = 0;
 	SA1Registers.PB = 0;
@@ -280,6 +282,8 @@ static void S9xSA1SetBWRAMMemMap (uint8 val)
 
 void S9xSA1PostLoadState (void)
 {
+	SA1.PendingSteps = 0;
+
 	SA1.ShiftedPB = (uint32) SA1Registers.PB << 16;
 	SA1.ShiftedDB = (uint32) SA1Registers.DB << 16;
 
@@ -228,8 +228,12 @@ struct SSA1
 	bool8	overflow;
 	uint8	VirtualBitmapFormat;
 	uint8	variable_bit_pos;
+	int32	PendingSteps;
+	int32	BatchSteps;
 };
 
+#define SA1_DEFAULT_BATCH_STEPS	1
+
 #define SA1CheckCarry()		(SA1._Carry)
 #define SA1CheckZero()		(SA1._Zero == 0)
 #define SA1CheckIRQ()		(SA1Registers.PL & IRQ)
@@ -244,9 +248,9 @@ struct SSA1
 #define SA1ClearFlags(f)	(SA1Registers.P.W &= ~(f))
 #define SA1CheckFlag(f)		(SA1Registers.PL & (f))
 
-extern struct SSA1Registers	SA1Registers;
-extern struct SSA1			SA1;
-extern uint8				SA1OpenBus;
+extern S9X_TLS struct SSA1Registers	SA1Registers;
+extern S9X_TLS struct SSA1			SA1;
+extern S9X_TLS uint8				SA1OpenBus;
 extern struct SOpcodes		S9xSA1OpcodesM1X1[256];
 extern struct SOpcodes		S9xSA1OpcodesM1X0[256];
 extern struct SOpcodes		S9xSA1OpcodesM0X1[256];
@@ -267,6 +271,15 @@ void S9xSA1Init (void);
 void S9xSA1MainLoop (void);
 void S9xSA1PostLoadState (void);
 
+// The SA-1 lags behind the S-CPU by SA1.PendingSteps slices, at most
+// SA1.BatchSteps, and is also run when the S-CPU touches shared state or at
+// H-events. See S9xSA1MainLoop().
+static inline void S9xSA1Sync (void)
+{
+	if (SA1.PendingSteps)
+		S9xSA1MainLoop();
+}
+
 static inline void S9xSA1UnpackStatus (void)
 {
 	SA1._Zero = (SA1Registers.PL & Zero) == 0;
@@ -231,9 +231,28 @@
 #include "cpuops.cpp"
 
 static void S9xSA1UpdateTimer (void);
+static void S9xSA1RunSlice (void);
 
 
+// The S-CPU adds one slice to SA1.PendingSteps per executed instruction and
+// the SA-1 is caught up here in one batch, once SA1.BatchSteps slices are
+// pending or on emulated events (S-CPU access to SA-1 registers, I-RAM or
+// BW-RAM, DMA, H-events and the end of S9xMainLoop). Interrupts the SA-1
+// raises towards the S-CPU are asserted when the SA-1 sets them, so they can
+// be seen up to SA1.BatchSteps - 1 instructions late. Only the default batch
+// of 1, which steps both CPUs in lockstep, is exact; larger batches trade
+// accuracy for speed and can desync movies.
 void S9xSA1MainLoop (void)
+{
+	int32	steps = SA1.PendingSteps;
+
+	SA1.PendingSteps = 0;
+
+	while (steps-- > 0)
+		S9xSA1RunSlice();
+}
+
+static void S9xSA1RunSlice (void)
 {
 	if (Memory.FillRAM[0x2200] & 0x60)
 	{
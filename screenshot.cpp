@@ -264,12 +264,9 @@ bool8 S9xDoScreenshot (const char *fname, int width, int height)
 	sig_bit.green = 5;
 	sig_bit.blue  = 5;
 	png_set_sBIT(png_ptr, info_ptr, &sig_bit);
-	png_set_shift(png_ptr, &sig_bit);
 
 	png_write_info(png_ptr, info_ptr);
 
-	png_set_packing(png_ptr);
-
 	png_byte	*row_pointer = new png_byte[png_get_rowbytes(png_ptr, info_ptr)];
 	uint16		*screen = GFX.Screen;
 
@@ -279,9 +276,9 @@ bool8 S9xDoScreenshot (const char *fname, int width, int height)
 
 		for (int x = 0; x < width; x++)
 		{
-			uint32	r, g, b;
-
-			DECOMPOSE_PIXEL(screen[x], r, g, b);
+			// already widened to 8 bits the way png_set_shift() would
+			uint32	pixel = GFX.XRGB[screen[x]];
+			uint8	r = pixel >> 16, g = pixel >> 8, b = pixel;
 
 			*(rowpix++) = r;
 			*(rowpix++) = g;
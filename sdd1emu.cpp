@@ -193,16 +193,16 @@
 #include "port.h"
 #include "sdd1emu.h"
 
-static int valid_bits;
-static uint16 in_stream;
-static uint8 *in_buf;
-static uint8 bit_ctr[8];
-static uint8 context_states[32];
-static int context_MPS[32];
-static int bitplane_type;
-static int high_context_bits;
-static int low_context_bits;
-static int prev_bits[8];
+static S9X_TLS int valid_bits;
+static S9X_TLS uint16 in_stream;
+static S9X_TLS uint8 *in_buf;
+static S9X_TLS uint8 bit_ctr[8];
+static S9X_TLS uint8 context_states[32];
+static S9X_TLS int context_MPS[32];
+static S9X_TLS int bitplane_type;
+static S9X_TLS int high_context_bits;
+static S9X_TLS int low_context_bits;
+static S9X_TLS int prev_bits[8];
 
 static struct {
     uint8 code_size;
@@ -406,9 +406,9 @@ void SDD1_decompress(uint8 *out, uint8 *in, int len){
 }
 
 #if 0
-static uint8 cur_plane;
-static uint8 num_bits;
-static uint8 next_byte;
+static S9X_TLS uint8 cur_plane;
+static S9X_TLS uint8 num_bits;
+static S9X_TLS uint8 next_byte;
 
 void SDD1_init(uint8 *in){
     bitplane_type=in[0]>>6;
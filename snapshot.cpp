@@ -1176,7 +1176,7 @@ static void FreezeStruct (STREAM, const char *, void *, FreezeData *, int);
 
 void S9xResetSaveTimer (bool8 dontsave)
 {
-	static time_t	t = -1;
+	static S9X_TLS time_t	t = -1;
 
 	if (!Settings.DontSaveOopsSnapshot && !dontsave && t != -1 && time(NULL) - t > 300)
 	{
@@ -1392,6 +1392,7 @@ void S9xFreezeToStream (STREAM stream)
 	uint8	*soundsnapshot = new uint8[SPC_SAVE_STATE_BLOCK_SIZE];
 
 	S9xSetSoundMute(TRUE);
+	S9xSA1Sync();
 
 	sprintf(buffer, "%s:%04d\n", SNAPSHOT_MAGIC, SNAPSHOT_VERSION);
 	WRITE_STREAM(buffer, strlen(buffer), stream);
@@ -1483,6 +1484,8 @@ void S9xFreezeToStream (STREAM stream)
 	{
 		SnapshotScreenshotInfo	*ssi = new SnapshotScreenshotInfo;
 
+		S9xFinishRendering();
+
 		ssi->Width  = min(IPPU.RenderedScreenWidth,  MAX_SNES_WIDTH);
 		ssi->Height = min(IPPU.RenderedScreenHeight, MAX_SNES_HEIGHT);
 		ssi->Interlaced = GFX.DoInterlace;
@@ -1867,6 +1870,8 @@ int S9xUnfreezeFromStream (STREAM stream)
 
 		S9xControlPostLoadState(&ctl_snap);
 
+		Memory.UpdateMemorySpeed();
+
 		if (local_superfx)
 		{
 			GSU.pfPlot = fx_PlotTable[GSU.vMode];
@@ -1894,7 +1899,7 @@ int S9xUnfreezeFromStream (STREAM stream)
 		if (local_movie_data)
 		{
 			// restore last displayed pad_read status
-			extern bool8	pad_read, pad_read_last;
+			extern S9X_TLS bool8	pad_read, pad_read_last;
 			bool8			pad_read_temp = pad_read;
 
 			pad_read = pad_read_last;
@@ -1913,6 +1918,8 @@ int S9xUnfreezeFromStream (STREAM stream)
 
 		if (local_screenshot)
 		{
+			S9xFinishRendering();
+
 			SnapshotScreenshotInfo	*ssi = new SnapshotScreenshotInfo;
 
 			UnfreezeStructFromCopy(ssi, SnapScreenshot, COUNT(SnapScreenshot), local_screenshot, version);
@@ -189,6 +189,7 @@
 #include "cheats.h"
 #include "display.h"
 #include "conffile.h"
+#include "apu/resampler.h"
 #ifdef NETPLAY_SUPPORT
 #include "netplay.h"
 #endif
@@ -205,7 +206,87 @@ static char	*rom_filename = NULL;
 static bool parse_controller_spec (int, const char *);
 static void parse_crosshair_spec (enum crosscontrols, const char *);
 static bool try_load_config_file (const char *, ConfigFile &);
+static uint8 parse_resampler (const char *);
+static uint8 parse_render_mask (const char *);
 
+static uint8 parse_resampler (const char *arg)
+{
+	if (!strcasecmp(arg, "linear"))
+		return (RESAMPLER_LINEAR);
+	if (!strcasecmp(arg, "sinc"))
+		return (RESAMPLER_SINC);
+
+	return (RESAMPLER_HERMITE);
+}
+
+bool8 S9xParseRenderMask (const char *arg, uint8 *mask)
+{
+	static const struct
+	{
+		const char	*name;
+		uint8		bits;
+	}	parts[] =
+	{
+		{ "none",    0                      },
+		{ "all",     0xff                   },
+		{ "bg1",     RENDER_MASK_BG1        },
+		{ "bg2",     RENDER_MASK_BG2        },
+		{ "bg3",     RENDER_MASK_BG3        },
+		{ "bg4",     RENDER_MASK_BG4        },
+		{ "obj",     RENDER_MASK_OBJ        },
+		{ "sub",     RENDER_MASK_SUBSCREEN  },
+		{ "math",    RENDER_MASK_COLOR_MATH },
+		{ "windows", RENDER_MASK_WINDOWS    }
+	};
+
+	char	*end;
+	long	n = strtol(arg, &end, 0);
+
+	if (end != arg && *end == '\0')
+	{
+		if (n < 0 || n > 0xff)
+			return (FALSE);
+
+		*mask = (uint8) n;
+		return (TRUE);
+	}
+
+	uint8	bits = 0;
+
+	while (*arg)
+	{
+		size_t	len = strcspn(arg, ", ");
+		int		i;
+
+		if (len)
+		{
+			for (i = 0; i < (int) (sizeof(parts) / sizeof(parts[0])); i++)
+				if (strlen(parts[i].name) == len && !strncasecmp(arg, parts[i].name, len))
+					break;
+
+			if (i == (int) (sizeof(parts) / sizeof(parts[0])))
+				return (FALSE);
+
+			bits |= parts[i].bits;
+		}
+
+		arg += len;
+		arg += strspn(arg, ", ");
+	}
+
+	*mask = bits;
+	return (TRUE);
+}
+
+static uint8 parse_render_mask (const char *arg)
+{
+	uint8	mask = 0;
+
+	if (!S9xParseRenderMask(arg, &mask))
+		fprintf(stderr, "Invalid render mask '%s'.\n", arg);
+
+	return (mask);
+}
 
 static bool parse_controller_spec (int port, const char *arg)
 {
@@ -372,6 +453,7 @@ void S9xLoadConfigFiles (char **argv, int argc)
 	Settings.ForceInterleaveGD24        =  conf.GetBool("ROM::InterleaveGD24",                 false);
 	Settings.ApplyCheats                =  conf.GetBool("ROM::Cheat",                          false);
 	Settings.NoPatch                    = !conf.GetBool("ROM::Patch",                          true);
+	Settings.SharedROM                  =  conf.GetBool("ROM::Shared",                         false);
 
 	Settings.ForceLoROM = conf.GetBool("ROM::LoROM", false);
 	Settings.ForceHiROM = conf.GetBool("ROM::HiROM", false);
@@ -405,13 +487,18 @@ void S9xLoadConfigFiles (char **argv, int argc)
 	Settings.ReverseStereo              =  conf.GetBool("Sound::ReverseStereo",                false);
 	Settings.SoundPlaybackRate          =  conf.GetUInt("Sound::Rate",                         32000);
 	Settings.SoundInputRate             =  conf.GetUInt("Sound::InputRate",                    32000);
+	Settings.SoundResampler             =  parse_resampler(conf.GetString("Sound::Resampler", "Hermite"));
 	Settings.Mute                       =  conf.GetBool("Sound::Mute",                         false);
+	Settings.SkipSound                  =  conf.GetBool("Sound::Skip",                         false);
+	Settings.FastSPC700                 =  conf.GetBool("Sound::FastSPC700",                   false);
 
 	// Display
 
 	Settings.SupportHiRes               =  conf.GetBool("Display::HiRes",                      true);
 	Settings.Transparency               =  conf.GetBool("Display::Transparency",               true);
 	Settings.DisableGraphicWindows      = !conf.GetBool("Display::GraphicWindows",             true);
+	Settings.ThreadedRender             =  conf.GetBool("Display::ThreadedRender",             false);
+	Settings.RenderMask                 =  parse_render_mask(conf.GetString("Display::RenderMask", "none"));
 	Settings.DisplayFrameRate           =  conf.GetBool("Display::DisplayFrameRate",           true);
 	Settings.DisplayWatchedAddresses    =  conf.GetBool("Display::DisplayWatchedAddresses",    false);
 	Settings.DisplayPressedKeys         =  conf.GetBool("Display::DisplayInput",               false);
@@ -469,6 +556,8 @@ void S9xLoadConfigFiles (char **argv, int argc)
 	Settings.DisableGameSpecificHacks       = !conf.GetBool("Hack::EnableGameSpecificHacks",       true);
 	Settings.BlockInvalidVRAMAccessMaster   = !conf.GetBool("Hack::AllowInvalidVRAMAccess",        false);
 	Settings.HDMATimingHack                 =  conf.GetInt ("Hack::HDMATiming",                    100);
+	Settings.SA1BatchSteps                  =  conf.GetInt ("Hack::SA1BatchSteps",                 0);
+	Settings.DisableGSUPrefixCache          = !conf.GetBool("Hack::GSUPrefixCache",                true);
 
 	// Netplay
 
@@ -515,10 +604,13 @@ void S9xUsage (void)
 	S9xMessage(S9X_INFO, S9X_USAGE, "-soundsync                      Synchronize sound as far as possible");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-playbackrate <Hz>              Set sound playback rate");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-inputrate <Hz>                 Set sound input rate");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-resampler <kernel>             Resample sound with linear, hermite or sinc");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-reversestereo                  Reverse stereo sound output");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-nostereo                       Disable stereo sound output");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-eightbit                       Use 8bit sound instead of 16bit");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-mute                           Mute sound");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-nosoundsynth                   Emulate the sound chip without generating sound");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-fastspc700                     Step the SPC700 an instruction at a time");
 	S9xMessage(S9X_INFO, S9X_USAGE, "");
 
 	// DISPLAY OPTIONS
@@ -528,6 +620,10 @@ void S9xUsage (void)
 	S9xMessage(S9X_INFO, S9X_USAGE, "                                interlace modes");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-notransparency                 (Not recommended) Disable transparency effects");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-nowindows                      (Not recommended) Disable graphic window effects");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-threadedrender                 Draw each frame on a second thread while the next");
+	S9xMessage(S9X_INFO, S9X_USAGE, "                                is emulated (multi-instance builds only)");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-rendermask <parts>             Don't draw these, e.g. bg2,bg3,bg4,sub,math,windows");
+	S9xMessage(S9X_INFO, S9X_USAGE, "                                (bg1-bg4, obj, sub, math, windows, all, none)");
 	S9xMessage(S9X_INFO, S9X_USAGE, "");
 
 	// CONTROLLER OPTIONS
@@ -560,6 +656,8 @@ void S9xUsage (void)
 	S9xMessage(S9X_INFO, S9X_USAGE, "                                copier");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-header                         Assume the ROM image has a header of a copier");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-bsxbootup                      Boot up BS games from BS-X");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-sharedrom                      Share the loaded ROM image with other processes");
+	S9xMessage(S9X_INFO, S9X_USAGE, "                                through /dev/shm");
 	S9xMessage(S9X_INFO, S9X_USAGE, "");
 
 	// PATCH/CHEAT OPTIONS
@@ -587,6 +685,8 @@ void S9xUsage (void)
 	S9xMessage(S9X_INFO, S9X_USAGE, "-hdmatiming <1-199>             (Not recommended) Changes HDMA transfer timings");
 	S9xMessage(S9X_INFO, S9X_USAGE, "                                event comes");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-invalidvramaccess              (Not recommended) Allow invalid VRAM access");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-sa1batch <num>                 SA-1 batch size (default 1, larger is inexact)");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-nogsuprefixcache               Decode Super FX prefix opcodes one at a time");
 	S9xMessage(S9X_INFO, S9X_USAGE, "");
 
 	// OTHER OPTIONS
@@ -645,6 +745,14 @@ char * S9xParseArgs (char **argv, int argc)
 					S9xUsage();
 			}
 			else
+			if (!strcasecmp(argv[i], "-resampler"))
+			{
+				if (i + 1 < argc)
+					Settings.SoundResampler = parse_resampler(argv[++i]);
+				else
+					S9xUsage();
+			}
+			else
 			if (!strcasecmp(argv[i], "-reversestereo"))
 				Settings.ReverseStereo = TRUE;
 			else
@@ -657,6 +765,12 @@ char * S9xParseArgs (char **argv, int argc)
 			if (!strcasecmp(argv[i], "-mute"))
 				Settings.Mute = TRUE;
 			else
+			if (!strcasecmp(argv[i], "-nosoundsynth"))
+				Settings.SkipSound = TRUE;
+			else
+			if (!strcasecmp(argv[i], "-fastspc700"))
+				Settings.FastSPC700 = TRUE;
+			else
 
 			// DISPLAY OPTIONS
 
@@ -675,6 +789,17 @@ char * S9xParseArgs (char **argv, int argc)
 			if (!strcasecmp(argv[i], "-nowindows"))
 				Settings.DisableGraphicWindows = TRUE;
 			else
+			if (!strcasecmp(argv[i], "-threadedrender"))
+				Settings.ThreadedRender = TRUE;
+			else
+			if (!strcasecmp(argv[i], "-rendermask"))
+			{
+				if (i + 1 < argc && S9xParseRenderMask(argv[i + 1], &Settings.RenderMask))
+					i++;
+				else
+					S9xUsage();
+			}
+			else
 
 			// CONTROLLER OPTIONS
 
@@ -739,6 +864,9 @@ char * S9xParseArgs (char **argv, int argc)
 			if (!strcasecmp(argv[i], "-bsxbootup"))
 				Settings.BSXBootup = TRUE;
 			else
+			if (!strcasecmp(argv[i], "-sharedrom"))
+				Settings.SharedROM = TRUE;
+			else
 
 			// PATCH/CHEAT OPTIONS
 
@@ -860,6 +988,21 @@ char * S9xParseArgs (char **argv, int argc)
 			if (!strcasecmp(argv[i], "-invalidvramaccess"))
 				Settings.BlockInvalidVRAMAccessMaster = FALSE;
 			else
+			if (!strcasecmp(argv[i], "-sa1batch"))
+			{
+				if (i + 1 < argc)
+				{
+					int	p = atoi(argv[++i]);
+					if (p > 0)
+						Settings.SA1BatchSteps = p;
+				}
+				else
+					S9xUsage();
+			}
+			else
+			if (!strcasecmp(argv[i], "-nogsuprefixcache"))
+				Settings.DisableGSUPrefixCache = TRUE;
+			else
 
 			// OTHER OPTIONS
 
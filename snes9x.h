@@ -279,6 +279,16 @@
 #define HALTED_FLAG			(1 << 12)	// APU
 #define FRAME_ADVANCE_FLAG	(1 <<  9)
 
+// Settings.RenderMask: parts of the picture the renderer skips
+#define RENDER_MASK_BG1			(1 << 0)
+#define RENDER_MASK_BG2			(1 << 1)
+#define RENDER_MASK_BG3			(1 << 2)
+#define RENDER_MASK_BG4			(1 << 3)
+#define RENDER_MASK_OBJ			(1 << 4)
+#define RENDER_MASK_SUBSCREEN	(1 << 5)
+#define RENDER_MASK_COLOR_MATH	(1 << 6)
+#define RENDER_MASK_WINDOWS		(1 << 7)
+
 #define ROM_NAME_LEN	23
 #define AUTO_FRAMERATE	200
 
@@ -378,6 +388,7 @@ struct SSettings
 	bool8	ForceInterleaved2;
 	bool8	ForceInterleaveGD24;
 	bool8	ForceNotInterleaved;
+	bool8	SharedROM;
 	bool8	ForcePAL;
 	bool8	ForceNTSC;
 	bool8	PAL;
@@ -389,14 +400,19 @@ struct SSettings
 	bool8	SixteenBitSound;
 	uint32	SoundPlaybackRate;
 	uint32	SoundInputRate;
+	uint8	SoundResampler;
 	bool8	Stereo;
 	bool8	ReverseStereo;
 	bool8	Mute;
+	bool8	SkipSound;
+	bool8	FastSPC700;
 
 	bool8	SupportHiRes;
 	bool8	Transparency;
 	uint8	BG_Forced;
 	bool8	DisableGraphicWindows;
+	uint8	RenderMask;
+	bool8	ThreadedRender;
 
 	bool8	DisplayFrameRate;
 	bool8	DisplayWatchedAddresses;
@@ -415,6 +431,8 @@ struct SSettings
 	bool8	BlockInvalidVRAMAccessMaster;
 	bool8	BlockInvalidVRAMAccess;
 	int32	HDMATimingHack;
+	int32	SA1BatchSteps;
+	bool8	DisableGSUPrefixCache;
 
 	bool8	ForcedPause;
 	bool8	Paused;
@@ -424,6 +442,7 @@ struct SSettings
 	uint32	TurboSkipFrames;
 	uint32	AutoMaxSkipFrames;
 	bool8	TurboMode;
+	bool8	SkipRendering;
 	uint32	HighSpeedSeek;
 	bool8	FrameAdvance;
 
@@ -473,10 +492,10 @@ void S9xClearPause(uint32);
 void S9xExit(void);
 void S9xMessage(int, int, const char *);
 
-extern struct SSettings			Settings;
-extern struct SCPUState			CPU;
-extern struct STimings			Timings;
-extern struct SSNESGameFixes	SNESGameFixes;
-extern char						String[513];
+extern S9X_TLS struct SSettings			Settings;
+extern S9X_TLS struct SCPUState			CPU;
+extern S9X_TLS struct STimings			Timings;
+extern S9X_TLS struct SSNESGameFixes	SNESGameFixes;
+extern S9X_TLS char						String[513];
 
 #endif
@@ -205,7 +205,7 @@ static inline unsigned min (unsigned a, unsigned b)
 #include "srtcemu.h"
 #include "srtcemu.cpp"
 
-static SRTC	srtcemu;
+static S9X_TLS SRTC	srtcemu;
 
 
 void S9xInitSRTC (void)
@@ -189,6 +189,32 @@
 #include "ppu.h"
 #include "tile.h"
 
+#if !defined (TILE_SSE2) && (defined (__SSE2__) || defined (_M_X64))
+#define TILE_SSE2 1
+#endif
+
+#if TILE_SSE2
+#include <emmintrin.h>
+#endif
+
+// MathLine() does not match COLOR_SUB1_2 in GBR565. Multi-format builds
+// check the format at run time, a build for GBR565 alone leaves it out.
+#if TILE_SSE2 && !defined (GFX_MULTI_FORMAT)
+#define TILE_GBR565_GBR565			1
+#define TILE_FORMAT_IS_GBR565(F)	CONCAT(TILE_GBR565_, F)
+#if TILE_FORMAT_IS_GBR565(PIXEL_FORMAT)
+#define TILE_MATH_LINE	0
+#endif
+#endif
+
+#ifndef TILE_MATH_LINE
+#define TILE_MATH_LINE	TILE_SSE2
+#endif
+
+// GFX.MathBuffer flags left by the main screen renderers for S9xApplyColourMath
+#define MATH_ON			1
+#define MATH_CLIPPED	2
+
 static uint32	pixbit[8][16];
 static uint8	hrbit_odd[256];
 static uint8	hrbit_even[256];
@@ -254,6 +280,152 @@ void S9xInitTileRenderer (void)
 }
 
 // Here are the tile converters, selected by S9xSelectTileConverter().
+
+#if TILE_SSE2
+
+// Planar to chunky, one pair of bitplanes (16 bytes: 8 rows of 2 planes) at a time.
+// Each plane byte is broadcast across the 8 pixels of its row, tested against the
+// pixel's bit and weighted by the plane's value; rows[] holds two output rows each.
+
+static inline void DecodePlanes (const uint8 *tp, int plane, __m128i *rows)
+{
+	const __m128i	bits   = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, (char) 128, 1, 2, 4, 8, 16, 32, 64, (char) 128);
+	const __m128i	weight = _mm_unpacklo_epi64(_mm_set1_epi8((char) (1 << plane)), _mm_set1_epi8((char) (2 << plane)));
+	__m128i			v      = _mm_loadu_si128((const __m128i *) tp);
+	__m128i			half[2];
+
+	half[0] = _mm_unpacklo_epi8(v, v);
+	half[1] = _mm_unpackhi_epi8(v, v);
+
+	for (int h = 0; h < 2; h++)
+	{
+		__m128i	quad[2];
+
+		quad[0] = _mm_unpacklo_epi16(half[h], half[h]);
+		quad[1] = _mm_unpackhi_epi16(half[h], half[h]);
+
+		for (int q = 0; q < 2; q++)
+		{
+			// both planes of one row, 8 lanes each
+			__m128i	r0 = _mm_unpacklo_epi32(quad[q], quad[q]);
+			__m128i	r1 = _mm_unpackhi_epi32(quad[q], quad[q]);
+
+			r0 = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(r0, bits), bits), weight);
+			r1 = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(r1, bits), bits), weight);
+			r0 = _mm_or_si128(r0, _mm_srli_si128(r0, 8));
+			r1 = _mm_or_si128(r1, _mm_srli_si128(r1, 8));
+
+			rows[h * 2 + q] = _mm_or_si128(rows[h * 2 + q], _mm_unpacklo_epi64(r0, r1));
+		}
+	}
+}
+
+static inline uint8 StoreTile (uint8 *pCache, const __m128i *rows)
+{
+	__m128i	*p = (__m128i *) pCache;
+
+	_mm_storeu_si128(p + 0, rows[0]);
+	_mm_storeu_si128(p + 1, rows[1]);
+	_mm_storeu_si128(p + 2, rows[2]);
+	_mm_storeu_si128(p + 3, rows[3]);
+
+	__m128i	any = _mm_or_si128(_mm_or_si128(rows[0], rows[1]), _mm_or_si128(rows[2], rows[3]));
+
+	return (_mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) != 0xffff ? TRUE : BLANK_TILE);
+}
+
+// The hires converters pick every other pixel of two neighbouring tiles and pack
+// them into one planar row, which then decodes like any other.
+
+static inline void MergeHires (uint8 *planar, const uint8 *tp1, const uint8 *tp2, const uint8 *hrbit, int n)
+{
+	for (int i = 0; i < n; i++)
+		planar[i] = (hrbit[tp1[i]] << 4) | hrbit[tp2[i]];
+}
+
+static uint8 ConvertTile2 (uint8 *pCache, uint32 TileAddr, uint32)
+{
+	const uint8	*tp = &Memory.VRAM[TileAddr];
+	__m128i		rows[4] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+
+	DecodePlanes(tp, 0, rows);
+
+	return (StoreTile(pCache, rows));
+}
+
+static uint8 ConvertTile4 (uint8 *pCache, uint32 TileAddr, uint32)
+{
+	const uint8	*tp = &Memory.VRAM[TileAddr];
+	__m128i		rows[4] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+
+	DecodePlanes(tp,      0, rows);
+	DecodePlanes(tp + 16, 2, rows);
+
+	return (StoreTile(pCache, rows));
+}
+
+static uint8 ConvertTile8 (uint8 *pCache, uint32 TileAddr, uint32)
+{
+	const uint8	*tp = &Memory.VRAM[TileAddr];
+	__m128i		rows[4] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+
+	DecodePlanes(tp,      0, rows);
+	DecodePlanes(tp + 16, 2, rows);
+	DecodePlanes(tp + 32, 4, rows);
+	DecodePlanes(tp + 48, 6, rows);
+
+	return (StoreTile(pCache, rows));
+}
+
+static uint8 ConvertTile2h (uint8 *pCache, uint32 TileAddr, uint32 Tile, const uint8 *hrbit)
+{
+	const uint8	*tp1 = &Memory.VRAM[TileAddr];
+	const uint8	*tp2 = (Tile == 0x3ff) ? tp1 - (0x3ff << 4) : tp1 + (1 << 4);
+	uint8		planar[16];
+	__m128i		rows[4] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+
+	MergeHires(planar, tp1, tp2, hrbit, 16);
+	DecodePlanes(planar, 0, rows);
+
+	return (StoreTile(pCache, rows));
+}
+
+static uint8 ConvertTile4h (uint8 *pCache, uint32 TileAddr, uint32 Tile, const uint8 *hrbit)
+{
+	const uint8	*tp1 = &Memory.VRAM[TileAddr];
+	const uint8	*tp2 = (Tile == 0x3ff) ? tp1 - (0x3ff << 5) : tp1 + (1 << 5);
+	uint8		planar[32];
+	__m128i		rows[4] = { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+
+	MergeHires(planar, tp1, tp2, hrbit, 32);
+	DecodePlanes(planar,      0, rows);
+	DecodePlanes(planar + 16, 2, rows);
+
+	return (StoreTile(pCache, rows));
+}
+
+static uint8 ConvertTile2h_odd (uint8 *pCache, uint32 TileAddr, uint32 Tile)
+{
+	return (ConvertTile2h(pCache, TileAddr, Tile, hrbit_odd));
+}
+
+static uint8 ConvertTile4h_odd (uint8 *pCache, uint32 TileAddr, uint32 Tile)
+{
+	return (ConvertTile4h(pCache, TileAddr, Tile, hrbit_odd));
+}
+
+static uint8 ConvertTile2h_even (uint8 *pCache, uint32 TileAddr, uint32 Tile)
+{
+	return (ConvertTile2h(pCache, TileAddr, Tile, hrbit_even));
+}
+
+static uint8 ConvertTile4h_even (uint8 *pCache, uint32 TileAddr, uint32 Tile)
+{
+	return (ConvertTile4h(pCache, TileAddr, Tile, hrbit_even));
+}
+
+#else
+
 // Really, except for the definition of DOBIT and the number of times it is called, they're all the same.
 
 #define DOBIT(n, i) \
@@ -474,6 +646,8 @@ static uint8 ConvertTile4h_even (uint8 *pCache, uint32 TileAddr, uint32 Tile)
 
 #undef DOBIT
 
+#endif
+
 // First-level include: Get all the renderers.
 
 #include "tile.cpp"
@@ -553,27 +727,17 @@ void S9xSelectTileRenderers (int BGMode, bool8 sub, bool8 obj)
 		}
 	}
 
-	GFX.DrawTileNomath        = DT[0];
-	GFX.DrawClippedTileNomath = DCT[0];
-	GFX.DrawMosaicPixelNomath = DMP[0];
-	GFX.DrawBackdropNomath    = DB[0];
-	GFX.DrawMode7BG1Nomath    = DM7BG1[0];
-	GFX.DrawMode7BG2Nomath    = DM7BG2[0];
-
-	int	i;
+	// With colour math on, the main screen is plotted as if there was none
+	// and S9xApplyColourMath does the math afterwards.
+	int	n = (!sub && GFX.ColourMath) ? 1 : 0;
+	int	i = n ? 2 : 0;
 
-	if (!Settings.Transparency)
-		i = 0;
-	else
-	{
-		i = (Memory.FillRAM[0x2131] & 0x80) ? 4 : 1;
-		if (Memory.FillRAM[0x2131] & 0x40)
-		{
-			i++;
-			if (Memory.FillRAM[0x2130] & 2)
-				i++;
-		}
-	}
+	GFX.DrawTileNomath        = DT[n];
+	GFX.DrawClippedTileNomath = DCT[n];
+	GFX.DrawMosaicPixelNomath = DMP[n];
+	GFX.DrawBackdropNomath    = DB[n];
+	GFX.DrawMode7BG1Nomath    = DM7BG1[n];
+	GFX.DrawMode7BG2Nomath    = DM7BG2[n];
 
 	GFX.DrawTileMath        = DT[i];
 	GFX.DrawClippedTileMath = DCT[i];
@@ -672,6 +836,192 @@ void S9xSelectTileConverter (int depth, bool8 hires, bool8 sub, bool8 mosaic)
 	}
 }
 
+// Colour math for the main screen, done once a pixel for lines StartY...EndY
+// after both screens are drawn rather than every time a layer plots a pixel.
+// GFX.ColourMath is the op: 1-3 add, 4-6 sub, each as is, halved against the
+// fixed colour, or halved against the subscreen.
+
+static inline uint16 MathPixel (uint16 Main, uint16 Sub, uint8 SD, uint8 flags)
+{
+	bool8	clip = flags & MATH_CLIPPED;
+	uint16	Other = (SD & 0x20) ? Sub : (uint16) GFX.FixedColour;
+
+	switch (GFX.ColourMath)
+	{
+		case 1:	return (COLOR_ADD(Main, Other));
+		case 2:	return (clip ? COLOR_ADD(Main, GFX.FixedColour) : COLOR_ADD1_2(Main, GFX.FixedColour));
+		case 3:	return ((!clip && (SD & 0x20)) ? COLOR_ADD1_2(Main, Sub) : COLOR_ADD(Main, Other));
+		case 4:	return (COLOR_SUB(Main, Other));
+		case 5:	return (clip ? COLOR_SUB(Main, GFX.FixedColour) : COLOR_SUB1_2(Main, GFX.FixedColour));
+		default:
+		case 6:	return ((!clip && (SD & 0x20)) ? COLOR_SUB1_2(Main, Sub) : COLOR_SUB(Main, Other));
+	}
+}
+
+#if TILE_MATH_LINE
+
+// The same ops on 8 pixels, one colour field at a time so that saturating
+// and halving can't spill into the next field; the results are exactly
+// those of the COLOR_ macros.
+
+static inline __m128i MathAdd (__m128i a, __m128i b)
+{
+	const uint16	masks[3] = { (uint16) FIRST_COLOR_MASK, (uint16) SECOND_COLOR_MASK, (uint16) THIRD_COLOR_MASK };
+	__m128i			r = _mm_setzero_si128();
+
+	for (int f = 0; f < 3; f++)
+	{
+		__m128i	m = _mm_set1_epi16(masks[f]);
+		__m128i	v = _mm_adds_epu16(_mm_and_si128(a, m), _mm_and_si128(b, m));
+		__m128i	ok = _mm_cmpeq_epi16(_mm_andnot_si128(m, v), _mm_setzero_si128());
+		r = _mm_or_si128(r, _mm_or_si128(_mm_and_si128(ok, v), _mm_andnot_si128(ok, m)));
+	}
+
+	return (r);
+}
+
+static inline __m128i MathAdd1_2 (__m128i a, __m128i b)
+{
+	__m128i	low = _mm_set1_epi16(RGB_LOW_BITS_MASK);
+
+	return (_mm_add_epi16(_mm_add_epi16(_mm_srli_epi16(_mm_andnot_si128(low, a), 1), _mm_srli_epi16(_mm_andnot_si128(low, b), 1)),
+						  _mm_and_si128(_mm_and_si128(a, b), low)));
+}
+
+static inline __m128i MathSub (__m128i a, __m128i b)
+{
+	const uint16	masks[3] = { (uint16) FIRST_COLOR_MASK, (uint16) SECOND_COLOR_MASK, (uint16) THIRD_COLOR_MASK };
+	__m128i			r = _mm_setzero_si128();
+
+	for (int f = 0; f < 3; f++)
+	{
+		__m128i	m = _mm_set1_epi16(masks[f]);
+		r = _mm_or_si128(r, _mm_subs_epu16(_mm_and_si128(a, m), _mm_and_si128(b, m)));
+	}
+
+	return (r);
+}
+
+static inline __m128i MathSub1_2 (__m128i a, __m128i b)
+{
+	const uint16	masks[3] = { (uint16) FIRST_COLOR_MASK, (uint16) SECOND_COLOR_MASK, (uint16) THIRD_COLOR_MASK };
+	__m128i			r = _mm_setzero_si128();
+
+	b = _mm_andnot_si128(_mm_set1_epi16(RGB_LOW_BITS_MASK), b);
+
+	for (int f = 0; f < 3; f++)
+	{
+		__m128i	m = _mm_set1_epi16(masks[f]);
+		r = _mm_or_si128(r, _mm_and_si128(_mm_srli_epi16(_mm_subs_epu16(_mm_and_si128(a, m), _mm_and_si128(b, m)), 1), m));
+	}
+
+	return (r);
+}
+
+static inline __m128i Select (__m128i mask, __m128i a, __m128i b)
+{
+	return (_mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)));
+}
+
+static void MathLine (uint16 *S, const uint16 *Sub, const uint8 *SD, const uint8 *MB)
+{
+	const __m128i	zero = _mm_setzero_si128();
+	const __m128i	fixed = _mm_set1_epi16(GFX.FixedColour);
+	const __m128i	on = _mm_set1_epi16(MATH_ON), clipped = _mm_set1_epi16(MATH_CLIPPED), subbit = _mm_set1_epi16(0x20);
+	int				op = GFX.ColourMath;
+
+	for (int x = 0; x < SNES_WIDTH; x += 8)
+	{
+		__m128i	f = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (MB + x)), zero);
+		__m128i	domath = _mm_cmpeq_epi16(_mm_and_si128(f, on), on);
+
+		if (!_mm_movemask_epi8(domath))
+			continue;
+
+		__m128i	m = _mm_loadu_si128((const __m128i *) (S + x));
+		__m128i	sd = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *) (SD + x)), zero);
+		__m128i	usesub = _mm_cmpeq_epi16(_mm_and_si128(sd, subbit), subbit);
+		__m128i	half = _mm_cmpeq_epi16(_mm_and_si128(f, clipped), zero);
+		__m128i	other = Select(usesub, _mm_loadu_si128((const __m128i *) (Sub + x)), fixed);
+		__m128i	r;
+
+		switch (op)
+		{
+			case 1:	r = MathAdd(m, other); break;
+			case 2:	r = Select(half, MathAdd1_2(m, fixed), MathAdd(m, fixed)); break;
+			case 3:	r = Select(_mm_and_si128(half, usesub), MathAdd1_2(m, other), MathAdd(m, other)); break;
+			case 4:	r = MathSub(m, other); break;
+			case 5:	r = Select(half, MathSub1_2(m, fixed), MathSub(m, fixed)); break;
+			default:
+			case 6:	r = Select(_mm_and_si128(half, usesub), MathSub1_2(m, other), MathSub(m, other)); break;
+		}
+
+		_mm_storeu_si128((__m128i *) (S + x), Select(domath, r, m));
+	}
+}
+
+#endif
+
+void S9xApplyColourMath (void)
+{
+	uint16	*screen = GFX.Screen;
+	bool8	hires = PPU.BGMode == 5 || PPU.BGMode == 6 || IPPU.PseudoHires;
+
+	if (GFX.DoInterlace && GFX.InterlaceFrame)
+		screen += GFX.RealPPL;
+
+	for (uint32 l = GFX.StartY, Offset = l * GFX.PPL; l <= GFX.EndY; l++, Offset += GFX.PPL)
+	{
+		uint16			*S = screen + Offset;
+		const uint16	*Sub = GFX.SubScreen + Offset;
+		const uint8		*SD = GFX.SubZBuffer + Offset, *MB = GFX.MathBuffer + Offset;
+
+		if (!IPPU.DoubleWidthPixels)
+		{
+		#if TILE_MATH_LINE
+			// MathLine does not match COLOR_SUB1_2 in GBR565, keep it on MathPixel.
+			if (ALPHA_BITS_MASK == 0
+			#ifdef GFX_MULTI_FORMAT
+				&& GFX.PixelFormat != GBR565
+			#endif
+				)
+				MathLine(S, Sub, SD, MB);
+			else
+		#endif
+			for (int x = 0; x < SNES_WIDTH; x++)
+			{
+				if (MB[x] & MATH_ON)
+					S[x] = MathPixel(S[x], Sub[x], SD[x], MB[x]);
+			}
+		}
+		else
+		if (hires)
+		{
+			// See DRAW_PIXEL_H2x1, the odd pixel holds Main(x, y) for now.
+			for (int x = 0; x < SNES_WIDTH * 2; x += 2)
+			{
+				uint16	other = (MB[x] & MATH_CLIPPED) ? 0 : Sub[x + 2];
+
+				if (MB[x] & MATH_ON)
+				{
+					S[x] = MathPixel(S[x], Sub[x], SD[x], MB[x]);
+					S[x + 1] = MathPixel(other, S[x + 1], SD[x], MB[x]);
+				}
+				else
+					S[x + 1] = other;
+			}
+		}
+		else
+		{
+			for (int x = 0; x < SNES_WIDTH * 2; x += 2)
+			{
+				if (MB[x] & MATH_ON)
+					S[x] = S[x + 1] = MathPixel(S[x], Sub[x], SD[x], MB[x]);
+			}
+		}
+	}
+}
+
 /*****************************************************************************/
 #else
 #ifndef NAME1 // First-level: Get all the renderers.
@@ -711,18 +1061,6 @@ void S9xSelectTileConverter (int depth, bool8 hires, bool8 sub, bool8 mosaic)
 		GFX.RealScreenColors = &IPPU.ScreenColors[((Tile >> BG.PaletteShift) & BG.PaletteMask) + BG.StartPalette]; \
 	GFX.ScreenColors = GFX.ClipColors ? BlackColourMap : GFX.RealScreenColors
 
-#define NOMATH(Op, Main, Sub, SD) \
-	(Main)
-
-#define REGMATH(Op, Main, Sub, SD) \
-	(COLOR_##Op((Main), ((SD) & 0x20) ? (Sub) : GFX.FixedColour))
-
-#define MATHF1_2(Op, Main, Sub, SD) \
-	(GFX.ClipColors ? (COLOR_##Op((Main), GFX.FixedColour)) : (COLOR_##Op##1_2((Main), GFX.FixedColour)))
-
-#define MATHS1_2(Op, Main, Sub, SD) \
-	(GFX.ClipColors ? REGMATH(Op, Main, Sub, SD) : (((SD) & 0x20) ? COLOR_##Op##1_2((Main), (Sub)) : COLOR_##Op((Main), GFX.FixedColour)))
-
 // Basic routine to render an unclipped tile.
 // Input parameters:
 //     BPSTART = either StartLine or (StartLine * 2 + BG.InterlaceLine),
@@ -1023,7 +1361,77 @@ void S9xSelectTileConverter (int depth, bool8 hires, bool8 sub, bool8 mosaic)
 
 #define CLIP_10_BIT_SIGNED(a)	(((a) & 0x2000) ? ((a) | ~0x3ff) : ((a) & 0x3ff))
 
-extern struct SLineMatrixData	LineMatrixData[240];
+extern S9X_TLS struct SLineMatrixData	LineMatrixData[240];
+
+// Fetches count Mode 7 pixels of a line into b, starting at the matrix position
+// (AA + BB, CC + DD) and stepping by (aa, cc). The plotters below then work from b.
+// Pixels the repeat mode leaves transparent come back as 0, which is transparent anyway.
+
+static void FetchMode7Line (uint8 *b, int AA, int BB, int CC, int DD, int aa, int cc, int count)
+{
+	const uint8	*VRAM1 = Memory.VRAM + 1;
+	uint8		repeat = PPU.Mode7Repeat;
+	int			i = 0;
+
+#if TILE_SSE2
+	// Four pixels' map and tile offsets per step, the VRAM reads stay scalar.
+	__m128i	X    = _mm_set_epi32(AA + BB + 3 * aa, AA + BB + 2 * aa, AA + BB + aa, AA + BB);
+	__m128i	Y    = _mm_set_epi32(CC + DD + 3 * cc, CC + DD + 2 * cc, CC + DD + cc, CC + DD);
+	__m128i	dX   = _mm_set1_epi32(4 * aa);
+	__m128i	dY   = _mm_set1_epi32(4 * cc);
+	__m128i	wrap = _mm_set1_epi32(repeat ? 0 : -1);
+
+	for (; i + 4 <= count; i += 4, X = _mm_add_epi32(X, dX), Y = _mm_add_epi32(Y, dY))
+	{
+		__m128i	x  = _mm_srai_epi32(X, 8);
+		__m128i	y  = _mm_srai_epi32(Y, 8);
+		__m128i	in = _mm_or_si128(wrap, _mm_cmpeq_epi32(_mm_andnot_si128(_mm_set1_epi32(0x3ff), _mm_or_si128(x, y)), _mm_setzero_si128()));
+
+		x = _mm_and_si128(x, _mm_set1_epi32(0x3ff));
+		y = _mm_and_si128(y, _mm_set1_epi32(0x3ff));
+
+		__m128i	map  = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(y, _mm_set1_epi32(~7)), 5), _mm_and_si128(_mm_srli_epi32(x, 2), _mm_set1_epi32(~1)));
+		__m128i	tile = _mm_add_epi32(_mm_slli_epi32(_mm_and_si128(y, _mm_set1_epi32(7)), 4), _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(7)), 1));
+
+		int32	m[4], t[4], n[4];
+
+		_mm_storeu_si128((__m128i *) m, map);
+		_mm_storeu_si128((__m128i *) t, tile);
+		_mm_storeu_si128((__m128i *) n, in);
+
+		for (int j = 0; j < 4; j++)
+		{
+			if (n[j])
+				b[i + j] = VRAM1[(Memory.VRAM[m[j]] << 7) + t[j]];
+			else
+				b[i + j] = (repeat == 3) ? VRAM1[t[j]] : 0;
+		}
+	}
+
+	AA += i * aa;
+	CC += i * cc;
+#endif
+
+	for (; i < count; i++, AA += aa, CC += cc)
+	{
+		int	X = ((AA + BB) >> 8);
+		int	Y = ((CC + DD) >> 8);
+
+		if (!repeat)
+		{
+			X &= 0x3ff;
+			Y &= 0x3ff;
+		}
+
+		if (((X | Y) & ~0x3ff) == 0)
+			b[i] = *(VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7) + ((Y & 7) << 4) + ((X & 7) << 1));
+		else
+		if (repeat == 3)
+			b[i] = *(VRAM1 + ((Y & 7) << 4) + ((X & 7) << 1));
+		else
+			b[i] = 0;
+	}
+}
 
 #define NO_INTERLACE	1
 #define Z1				(D + 7)
@@ -1033,7 +1441,7 @@ extern struct SLineMatrixData	LineMatrixData[240];
 #define BG				0
 
 #define DRAW_TILE_NORMAL() \
-	uint8	*VRAM1 = Memory.VRAM + 1; \
+	uint8	Pixels[SNES_WIDTH + 16]; \
 	\
 	if (DCMODE) \
 	{ \
@@ -1091,46 +1499,18 @@ extern struct SLineMatrixData	LineMatrixData[240];
 		\
 		uint8	Pix; \
 		\
-		if (!PPU.Mode7Repeat) \
-		{ \
-			for (uint32 x = Left; x < Right; x++, AA += aa, CC += cc) \
-			{ \
-				int	X = ((AA + BB) >> 8) & 0x3ff; \
-				int	Y = ((CC + DD) >> 8) & 0x3ff; \
-				\
-				uint8	*TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-				uint8	b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1)); \
-				\
-				DRAW_PIXEL(x, Pix = (b & MASK)); \
-			} \
-		} \
-		else \
+		FetchMode7Line(Pixels, AA, BB, CC, DD, aa, cc, Right - Left); \
+		\
+		for (uint32 x = Left; x < Right; x++) \
 		{ \
-			for (uint32 x = Left; x < Right; x++, AA += aa, CC += cc) \
-			{ \
-				int	X = ((AA + BB) >> 8); \
-				int	Y = ((CC + DD) >> 8); \
-				\
-				uint8	b; \
-				\
-				if (((X | Y) & ~0x3ff) == 0) \
-				{ \
-					uint8	*TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-					b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1)); \
-				} \
-				else \
-				if (PPU.Mode7Repeat == 3) \
-					b = *(VRAM1    + ((Y & 7) << 4) + ((X & 7) << 1)); \
-				else \
-					continue; \
-				\
-				DRAW_PIXEL(x, Pix = (b & MASK)); \
-			} \
+			uint8	b = Pixels[x - Left]; \
+			\
+			DRAW_PIXEL(x, Pix = (b & MASK)); \
 		} \
 	}
 
 #define DRAW_TILE_MOSAIC() \
-	uint8	*VRAM1 = Memory.VRAM + 1; \
+	uint8	Pixels[SNES_WIDTH + 16]; \
 	\
 	if (DCMODE) \
 	{ \
@@ -1208,63 +1588,20 @@ extern struct SLineMatrixData	LineMatrixData[240];
 		int	CC = l->MatrixC * startx + ((l->MatrixC * xx) & ~63); \
 		\
 		uint8	Pix; \
-		uint8	ctr = 1; \
 		\
-		if (!PPU.Mode7Repeat) \
-		{ \
-			for (int32 x = MLeft; x < MRight; x++, AA += aa, CC += cc) \
-			{ \
-				if (--ctr) \
-					continue; \
-				ctr = HMosaic; \
-				\
-				int	X = ((AA + BB) >> 8) & 0x3ff; \
-				int	Y = ((CC + DD) >> 8) & 0x3ff; \
-				\
-				uint8	*TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-				uint8	b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1)); \
-				\
-				if ((Pix = (b & MASK))) \
-				{ \
-					for (int32 h = MosaicStart; h < VMosaic; h++) \
-					{ \
-						for (int32 w = x + HMosaic - 1; w >= x; w--) \
-							DRAW_PIXEL(w + h * GFX.PPL, (w >= (int32) Left && w < (int32) Right)); \
-					} \
-				} \
-			} \
-		} \
-		else \
+		/* only the first pixel of each mosaic block is fetched */ \
+		FetchMode7Line(Pixels, AA, BB, CC, DD, aa * HMosaic, cc * HMosaic, (MRight - MLeft) / HMosaic); \
+		\
+		for (int32 x = MLeft; x < MRight; x += HMosaic) \
 		{ \
-			for (int32 x = MLeft; x < MRight; x++, AA += aa, CC += cc) \
+			uint8	b = Pixels[(x - MLeft) / HMosaic]; \
+			\
+			if ((Pix = (b & MASK))) \
 			{ \
-				if (--ctr) \
-					continue; \
-				ctr = HMosaic; \
-				\
-				int	X = ((AA + BB) >> 8); \
-				int	Y = ((CC + DD) >> 8); \
-				\
-				uint8	b; \
-				\
-				if (((X | Y) & ~0x3ff) == 0) \
+				for (int32 h = MosaicStart; h < VMosaic; h++) \
 				{ \
-					uint8	*TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-					b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1)); \
-				} \
-				else \
-				if (PPU.Mode7Repeat == 3) \
-					b = *(VRAM1    + ((Y & 7) << 4) + ((X & 7) << 1)); \
-				else \
-					continue; \
-				\
-				if ((Pix = (b & MASK))) \
-				{ \
-					for (int32 h = MosaicStart; h < VMosaic; h++) \
-					{ \
-						for (int32 w = x + HMosaic - 1; w >= x; w--) \
-							DRAW_PIXEL(w + h * GFX.PPL, (w >= (int32) Left && w < (int32) Right)); \
-					} \
+					for (int32 w = x + HMosaic - 1; w >= x; w--) \
+						DRAW_PIXEL(w + h * GFX.PPL, (w >= (int32) Left && w < (int32) Right)); \
 				} \
 			} \
 		} \
@@ -1345,7 +1682,8 @@ extern struct SLineMatrixData	LineMatrixData[240];
 #define DRAW_PIXEL(N, M) \
 	if (Z1 > GFX.DB[Offset + N] && (M)) \
 	{ \
-		GFX.S[Offset + N] = MATH(GFX.ScreenColors[Pix], GFX.SubScreen[Offset + N], GFX.SubZBuffer[Offset + N]); \
+		GFX.S[Offset + N] = GFX.ScreenColors[Pix]; \
+		MATH_FLAGS(Offset + N); \
 		GFX.DB[Offset + N] = Z2; \
 	}
 
@@ -1363,7 +1701,8 @@ extern struct SLineMatrixData	LineMatrixData[240];
 #define DRAW_PIXEL_N2x1(N, M) \
 	if (Z1 > GFX.DB[Offset + 2 * N] && (M)) \
 	{ \
-		GFX.S[Offset + 2 * N] = GFX.S[Offset + 2 * N + 1] = MATH(GFX.ScreenColors[Pix], GFX.SubScreen[Offset + 2 * N], GFX.SubZBuffer[Offset + 2 * N]); \
+		GFX.S[Offset + 2 * N] = GFX.S[Offset + 2 * N + 1] = GFX.ScreenColors[Pix]; \
+		MATH_FLAGS(Offset + 2 * N); \
 		GFX.DB[Offset + 2 * N] = GFX.DB[Offset + 2 * N + 1] = Z2; \
 	}
 
@@ -1385,12 +1724,14 @@ extern struct SLineMatrixData	LineMatrixData[240];
 //     (e.g. no math, add fixed, add1/2 subscreen) using Main(x, y) as the "corresponding subscreen pixel".
 //     Also, color window clipping clips Sub(x + 1, y) if Main(x, y) is clipped, not Main(x + 1, y).
 //     We don't know how Sub(0, y) is handled.
+// With math left for S9xApplyColourMath, Main(x, y) goes where Sub(x + 1, y) will, for it to use.
 
 #define DRAW_PIXEL_H2x1(N, M) \
     if (Z1 > GFX.DB[Offset + 2 * N] && (M)) \
     { \
-        GFX.S[Offset + 2 * N] = MATH(GFX.ScreenColors[Pix], GFX.SubScreen[Offset + 2 * N], GFX.SubZBuffer[Offset + 2 * N]); \
-        GFX.S[Offset + 2 * N + 1] = MATH((GFX.ClipColors ? 0 : GFX.SubScreen[Offset + 2 * N + 2]), GFX.RealScreenColors[Pix], GFX.SubZBuffer[Offset + 2 * N]); \
+        GFX.S[Offset + 2 * N] = GFX.ScreenColors[Pix]; \
+        GFX.S[Offset + 2 * N + 1] = HIRES_SUB(Offset + 2 * N); \
+        MATH_FLAGS(Offset + 2 * N); \
         GFX.DB[Offset + 2 * N] = GFX.DB[Offset + 2 * N + 1] = Z2; \
     }
 
@@ -1458,7 +1799,7 @@ extern struct SLineMatrixData	LineMatrixData[240];
 #undef PITCH
 
 /*****************************************************************************/
-#else // Third-level: Renderers for each math mode for NAME1 + NAME2.
+#else // Third-level: Renderers for each screen for NAME1 + NAME2.
 /*****************************************************************************/
 
 #define CONCAT3(A, B, C)	A##B##C
@@ -1466,62 +1807,36 @@ extern struct SLineMatrixData	LineMatrixData[240];
 
 static void MAKENAME(NAME1, _, NAME2) (ARGS)
 {
-#define MATH(A, B, C)	NOMATH(x, A, B, C)
-	DRAW_TILE();
-#undef MATH
-}
-
-static void MAKENAME(NAME1, Add_, NAME2) (ARGS)
-{
-#define MATH(A, B, C)	REGMATH(ADD, A, B, C)
-	DRAW_TILE();
-#undef MATH
-}
-
-static void MAKENAME(NAME1, AddF1_2_, NAME2) (ARGS)
-{
-#define MATH(A, B, C)	MATHF1_2(ADD, A, B, C)
-	DRAW_TILE();
-#undef MATH
-}
-
-static void MAKENAME(NAME1, AddS1_2_, NAME2) (ARGS)
-{
-#define MATH(A, B, C)	MATHS1_2(ADD, A, B, C)
-	DRAW_TILE();
-#undef MATH
-}
-
-static void MAKENAME(NAME1, Sub_, NAME2) (ARGS)
-{
-#define MATH(A, B, C)	REGMATH(SUB, A, B, C)
+#define MATH_FLAGS(O)
+#define HIRES_SUB(O)	(GFX.ClipColors ? 0 : GFX.SubScreen[(O) + 2])
 	DRAW_TILE();
-#undef MATH
+#undef HIRES_SUB
+#undef MATH_FLAGS
 }
 
-static void MAKENAME(NAME1, SubF1_2_, NAME2) (ARGS)
+static void MAKENAME(NAME1, Main_, NAME2) (ARGS)
 {
-#define MATH(A, B, C)	MATHF1_2(SUB, A, B, C)
+#define MATH_FLAGS(O)	GFX.MathBuffer[O] = GFX.ClipColors ? MATH_CLIPPED : 0
+#define HIRES_SUB(O)	GFX.RealScreenColors[Pix]
 	DRAW_TILE();
-#undef MATH
+#undef HIRES_SUB
+#undef MATH_FLAGS
 }
 
-static void MAKENAME(NAME1, SubS1_2_, NAME2) (ARGS)
+static void MAKENAME(NAME1, MainMath_, NAME2) (ARGS)
 {
-#define MATH(A, B, C)	MATHS1_2(SUB, A, B, C)
+#define MATH_FLAGS(O)	GFX.MathBuffer[O] = GFX.ClipColors ? MATH_ON | MATH_CLIPPED : MATH_ON
+#define HIRES_SUB(O)	GFX.RealScreenColors[Pix]
 	DRAW_TILE();
-#undef MATH
+#undef HIRES_SUB
+#undef MATH_FLAGS
 }
 
-static void (*MAKENAME(Renderers_, NAME1, NAME2)[7]) (ARGS) =
+static void (*MAKENAME(Renderers_, NAME1, NAME2)[3]) (ARGS) =
 {
 	MAKENAME(NAME1, _, NAME2),
-	MAKENAME(NAME1, Add_, NAME2),
-	MAKENAME(NAME1, AddF1_2_, NAME2),
-	MAKENAME(NAME1, AddS1_2_, NAME2),
-	MAKENAME(NAME1, Sub_, NAME2),
-	MAKENAME(NAME1, SubF1_2_, NAME2),
-	MAKENAME(NAME1, SubS1_2_, NAME2)
+	MAKENAME(NAME1, Main_, NAME2),
+	MAKENAME(NAME1, MainMath_, NAME2)
 };
 
 #undef MAKENAME
@@ -182,5 +182,6 @@
 void S9xInitTileRenderer (void);
 void S9xSelectTileRenderers (int, bool8, bool8);
 void S9xSelectTileConverter (int, bool8, bool8, bool8);
+void S9xApplyColourMath (void);
 
 #endif
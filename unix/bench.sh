@@ -0,0 +1,94 @@
+#!/bin/sh
+#
+# Times snes9x-headless on one ROM under several option sets.
+#
+#   ./bench.sh <rom> [frames] [options] [options] ...
+#
+# Every option set is one argument, e.g. "-sa1batch 1". The empty string runs
+# the defaults. For each set the frame rate is printed together with a digest
+# of the -framehash output, so sets that must not change emulation can be
+# checked for identical output in the same run. Without option sets the SA-1
+# batch sizes are compared; only the default batch of 1 is exact, so larger
+# ones may show a different digest. For a Super FX game, compare the prefix
+# cache:
+#
+#   ./bench.sh starfox.sfc 3000 "" "-nogsuprefixcache"
+#
+# With SNES9X_REF set to another build, every set also runs on that one, and
+# the script fails when any of them draws different frames. To check the SSE2
+# tile decoding against the scalar one, on a game that streams tiles into
+# VRAM (large animated backgrounds, hires or 8bpp modes):
+#
+#   make snes9x-headless-scalar
+#   SNES9X_REF=./snes9x-headless-scalar ./bench.sh game.sfc 3000 ""
+#
+# BENCH_LUA runs a script alongside, e.g. oambench.lua, which fills OAM with
+# moving sprites every frame. Against a build from before the incremental
+# SetupOBJ it checks the sprite lines too:
+#
+#   SNES9X_REF=../old/unix/snes9x-headless BENCH_LUA=oambench.lua ./bench.sh game.sfc 3000 ""
+#
+# memselbench.lua flips a FastROM game between both ROM speeds every frame.
+# That times the memory accessors and checks the per-block speed table against
+# a build that still works out the speed of every access.
+
+SNES9X=${SNES9X:-./snes9x-headless}
+
+if [ $# -lt 1 ]; then
+	echo "usage: $0 <rom> [frames] [options] ..." >&2
+	exit 1
+fi
+
+rom=$1
+shift
+frames=3000
+if [ $# -gt 0 ]; then
+	frames=$1
+	shift
+fi
+if [ $# -eq 0 ]; then
+	set -- "" "-sa1batch 4" "-sa1batch 16"
+fi
+
+# An empty script keeps the default test.lua from taking over the frame loop,
+# and the frame rate counter would make every frame hash differ.
+tmp=${TMPDIR:-/tmp}/snes9x-bench.$$
+hashes=$tmp.hash
+script=$tmp.lua
+conf=$tmp.conf
+trap 'rm -f "$hashes" "$script" "$conf"' 0
+if [ -n "$BENCH_LUA" ]; then
+	cp "$BENCH_LUA" "$script" || exit 1
+else
+	: > "$script"
+fi
+printf '[Display]\nDisplayFrameRate = FALSE\n' > "$conf"
+
+status=0
+
+# run <binary> <options>: prints the frame rate and the digest of the frames
+run () {
+	# shellcheck disable=SC2086
+	fps=$("$1" -conf "$conf" -mute -maxframes "$frames" -framehash "$hashes" -luascript "$script" $2 "$rom" 2>&1 >/dev/null |
+		sed -n 's/.*(\([0-9.]*\) fps).*/\1/p')
+	echo "${fps:-?} $(cksum < "$hashes" | cut -d ' ' -f 1)"
+}
+
+for opts in "$@"; do
+	set -- $(run "$SNES9X" "$opts")
+	printf '%-32s %10s fps  frames %s\n' "${opts:-(defaults)}" "$1" "$2"
+
+	if [ -n "$SNES9X_REF" ]; then
+		digest=$2
+		set -- $(run "$SNES9X_REF" "$opts")
+		if [ "$2" = "$digest" ]; then
+			result=same
+		else
+			result=DIFFERENT
+			status=1
+		fi
+		printf '%-32s %10s fps  frames %s  %s\n' "  reference" "$1" "$2" "$result"
+	fi
+done
+
+exit $status
@@ -0,0 +1,411 @@
+/***********************************************************************************
+  Snes9x - Portable Super Nintendo Entertainment System (TM) emulator.
+
+  (c) Copyright 1996 - 2002  Gary Henderson (gary.henderson@ntlworld.com),
+                             Jerremy Koot (jkoot@snes9x.com)
+
+  (c) Copyright 2002 - 2004  Matthew Kendora
+
+  (c) Copyright 2002 - 2005  Peter Bortas (peter@bortas.org)
+
+  (c) Copyright 2004 - 2005  Joel Yliluoma (http://iki.fi/bisqwit/)
+
+  (c) Copyright 2001 - 2006  John Weidman (jweidman@slip.net)
+
+  (c) Copyright 2002 - 2006  funkyass (funkyass@spam.shaw.ca),
+                             Kris Bleakley (codeviolation@hotmail.com)
+
+  (c) Copyright 2002 - 2010  Brad Jorsch (anomie@users.sourceforge.net),
+                             Nach (n-a-c-h@users.sourceforge.net),
+
+  (c) Copyright 2002 - 2011  zones (kasumitokoduck@yahoo.com)
+
+  (c) Copyright 2006 - 2007  nitsuja
+
+  (c) Copyright 2009 - 2011  BearOso,
+                             OV2
+
+
+  BS-X C emulator code
+  (c) Copyright 2005 - 2006  Dreamer Nom,
+                             zones
+
+  C4 x86 assembler and some C emulation code
+  (c) Copyright 2000 - 2003  _Demo_ (_demo_@zsnes.com),
+                             Nach,
+                             zsKnight (zsknight@zsnes.com)
+
+  C4 C++ code
+  (c) Copyright 2003 - 2006  Brad Jorsch,
+                             Nach
+
+  DSP-1 emulator code
+  (c) Copyright 1998 - 2006  _Demo_,
+                             Andreas Naive (andreasnaive@gmail.com),
+                             Gary Henderson,
+                             Ivar (ivar@snes9x.com),
+                             John Weidman,
+                             Kris Bleakley,
+                             Matthew Kendora,
+                             Nach,
+                             neviksti (neviksti@hotmail.com)
+
+  DSP-2 emulator code
+  (c) Copyright 2003         John Weidman,
+                             Kris Bleakley,
+                             Lord Nightmare (lord_nightmare@users.sourceforge.net),
+                             Matthew Kendora,
+                             neviksti
+
+  DSP-3 emulator code
+  (c) Copyright 2003 - 2006  John Weidman,
+                             Kris Bleakley,
+                             Lancer,
+                             z80 gaiden
+
+  DSP-4 emulator code
+  (c) Copyright 2004 - 2006  Dreamer Nom,
+                             John Weidman,
+                             Kris Bleakley,
+                             Nach,
+                             z80 gaiden
+
+  OBC1 emulator code
+  (c) Copyright 2001 - 2004  zsKnight,
+                             pagefault (pagefault@zsnes.com),
+                             Kris Bleakley
+                             Ported from x86 assembler to C by sanmaiwashi
+
+  SPC7110 and RTC C++ emulator code used in 1.39-1.51
+  (c) Copyright 2002         Matthew Kendora with research by
+                             zsKnight,
+                             John Weidman,
+                             Dark Force
+
+  SPC7110 and RTC C++ emulator code used in 1.52+
+  (c) Copyright 2009         byuu,
+                             neviksti
+
+  S-DD1 C emulator code
+  (c) Copyright 2003         Brad Jorsch with research by
+                             Andreas Naive,
+                             John Weidman
+
+  S-RTC C emulator code
+  (c) Copyright 2001 - 2006  byuu,
+                             John Weidman
+
+  ST010 C++ emulator code
+  (c) Copyright 2003         Feather,
+                             John Weidman,
+                             Kris Bleakley,
+                             Matthew Kendora
+
+  Super FX x86 assembler emulator code
+  (c) Copyright 1998 - 2003  _Demo_,
+                             pagefault,
+                             zsKnight
+
+  Super FX C emulator code
+  (c) Copyright 1997 - 1999  Ivar,
+                             Gary Henderson,
+                             John Weidman
+
+  Sound emulator code used in 1.5-1.51
+  (c) Copyright 1998 - 2003  Brad Martin
+  (c) Copyright 1998 - 2006  Charles Bilyue'
+
+  Sound emulator code used in 1.52+
+  (c) Copyright 2004 - 2007  Shay Green (gblargg@gmail.com)
+
+  SH assembler code partly based on x86 assembler code
+  (c) Copyright 2002 - 2004  Marcus Comstedt (marcus@mc.pp.se)
+
+  2xSaI filter
+  (c) Copyright 1999 - 2001  Derek Liauw Kie Fa
+
+  HQ2x, HQ3x, HQ4x filters
+  (c) Copyright 2003         Maxim Stepin (maxim@hiend3d.com)
+
+  NTSC filter
+  (c) Copyright 2006 - 2007  Shay Green
+
+  GTK+ GUI code
+  (c) Copyright 2004 - 2011  BearOso
+
+  Win32 GUI code
+  (c) Copyright 2003 - 2006  blip,
+                             funkyass,
+                             Matthew Kendora,
+                             Nach,
+                             nitsuja
+  (c) Copyright 2009 - 2011  OV2
+
+  Mac OS GUI code
+  (c) Copyright 1998 - 2001  John Stiles
+  (c) Copyright 2001 - 2011  zones
+
+
+  Specific ports contains the works of other authors. See headers in
+  individual files.
+
+
+  Snes9x homepage: http://www.snes9x.com/
+
+  Permission to use, copy, modify and/or distribute Snes9x in both binary
+  and source form, for non-commercial purposes, is hereby granted without
+  fee, providing that this license information and copyright notice appear
+  with all copies and any derived work.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event shall the authors be held liable for any damages
+  arising from the use of this software or it's derivatives.
+
+  Snes9x is freeware for PERSONAL USE only. Commercial users should
+  seek permission of the copyright holders first. Commercial use includes,
+  but is not limited to, charging money for Snes9x or software derived from
+  Snes9x, including Snes9x or derivatives in commercial game bundles, and/or
+  using Snes9x as a promotion for your commercial product.
+
+  The copyright holders request that bug fixes and improvements to the code
+  should be forwarded to them so everyone can benefit from the modifications
+  in future versions.
+
+  Super NES and Super Nintendo Entertainment System are trademarks of
+  Nintendo Co., Limited and its subsidiary companies.
+ ***********************************************************************************/
+
+
+// dspcheck: plays the same DSP state through the DSP as it is built for the
+// emulator (with the SSE2 interpolation where available) and through the
+// scalar one, and compares every sample and the APU RAM the echo writes to.
+//
+//   ./dspcheck [-seconds n] [file.spc ...]
+//
+// SPC dumps (Sound Settings > Dump SPC, or any .spc file) only give the DSP
+// registers and APU RAM; the SPC700 program isn't run, so the voices that are
+// keyed on play out. Without files, a full scale state and random ones are
+// checked instead, the latter with random register writes along the way to
+// retrigger voices and vary pitch.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SPC_DSP				SPC_DSP_C
+#define SPC_State_Copier	SPC_State_Copier_C
+#include "dsp/SPC_DSP.h"
+#undef SPC_DSP
+#undef SPC_State_Copier
+#undef SPC_DSP_H
+#include "dsp/SPC_DSP.h"
+
+#define SPC_RAM_OFFSET	0x100
+#define SPC_REG_OFFSET	0x10100
+#define CHUNK_SAMPLES	4096
+#define RAM_PADDING		0x400
+
+// The DSP reads a few bytes past $FFFF for the sample directory and the echo
+// buffer instead of wrapping, so both copies get the same bytes there
+static unsigned char	ram[2][0x10000 + RAM_PADDING];
+static SPC_DSP::sample_t	out[2][CHUNK_SAMPLES * 2 + SPC_DSP::extra_size];
+static SPC_DSP			dsp;
+static SPC_DSP_C		dsp_c;
+static clock_t			elapsed[2];
+static unsigned int		seed;
+
+static unsigned int Random (void)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16);
+}
+
+static bool LoadSPC (const char *filename, unsigned char *regs)
+{
+	FILE	*fp;
+	bool	ok;
+
+	fp = fopen(filename, "rb");
+	if (!fp)
+		return (false);
+
+	ok = fseek(fp, SPC_RAM_OFFSET, SEEK_SET) == 0 && fread(ram[0], 1, 0x10000, fp) == 0x10000 &&
+		 fseek(fp, SPC_REG_OFFSET, SEEK_SET) == 0 && fread(regs, 1, SPC_DSP::register_count, fp) == SPC_DSP::register_count;
+	fclose(fp);
+
+	return (ok);
+}
+
+static void RandomState (unsigned char *regs, bool loud)
+{
+	// Loud states decode to samples near full scale, where the interpolation
+	// overflows and must wrap and clamp like the hardware
+	for (int i = 0; i < 0x10000; i++)
+		ram[0][i] = (unsigned char) (loud ? (Random() & 1 ? 0x77 : 0x88) : Random());
+	for (int i = 0; i < SPC_DSP::register_count; i++)
+		regs[i] = (unsigned char) Random();
+
+	regs[0x4c] = 0xff;				// KON
+	regs[0x5c] = 0;					// KOFF
+	regs[0x6c] = regs[0x6c] & 0x3f;	// FLG: no reset or mute
+}
+
+// All voices loop a block decoding to -32768 and step through every
+// interpolation position, which is where the first three taps overflow
+static void FullScaleState (unsigned char *regs)
+{
+	memset(ram[0], 0, 0x10000);
+	memset(regs, 0, SPC_DSP::register_count);
+
+	ram[0][0x200] = ram[0][0x202] = 0x00;	// directory at $200, sample 0 at $1000
+	ram[0][0x201] = ram[0][0x203] = 0x10;
+	ram[0][0x1000] = 0xc3;					// shift 12, loop, end
+	memset(&ram[0][0x1001], 0x88, 8);
+
+	for (int v = 0; v < 8; v++)
+	{
+		regs[v * 0x10 + 0] = regs[v * 0x10 + 1] = 0x7f;	// volume
+		regs[v * 0x10 + 2] = 0x10 + v;						// pitch
+		regs[v * 0x10 + 5] = 0x8f;							// ADSR, fastest attack
+		regs[v * 0x10 + 6] = 0xe0;							// sustain at full level
+	}
+
+	regs[0x0c] = regs[0x1c] = 0x7f;	// MVOL
+	regs[0x4c] = 0xff;				// KON
+	regs[0x5d] = 0x02;				// DIR
+	regs[0x6c] = 0x20;				// FLG: no echo writes
+}
+
+static void Write (int addr, int data)
+{
+	dsp.write(addr, data);
+	dsp_c.write(addr, data);
+}
+
+static bool Compare (const char *name, unsigned char const *regs, int seconds, bool writes)
+{
+	memcpy(ram[0] + 0x10000, ram[0], RAM_PADDING);
+	memcpy(ram[1], ram[0], sizeof(ram[1]));
+
+	dsp.init(ram[0]);
+	dsp.load(regs);
+	dsp_c.init(ram[1]);
+	dsp_c.load(regs);
+
+	for (long chunk = 0, sample = 0; chunk < 32000L * seconds; chunk += CHUNK_SAMPLES)
+	{
+		clock_t	t;
+
+		if (writes)
+		{
+			for (int n = Random() % 4; n; n--)
+			{
+				int	addr = Random() % SPC_DSP::register_count, data = Random() & 0xff;
+				if (addr == 0x6c)
+					data &= 0x3f;
+				Write(addr, data);
+			}
+		}
+
+		// run() can finish a sample past the chunk, so leave it some room
+		dsp.set_output(out[0], CHUNK_SAMPLES * 2 + SPC_DSP::extra_size);
+		dsp_c.set_output(out[1], CHUNK_SAMPLES * 2 + SPC_DSP::extra_size);
+
+		t = clock();
+		dsp.run(CHUNK_SAMPLES * 32);
+		elapsed[0] += clock() - t;
+
+		t = clock();
+		dsp_c.run(CHUNK_SAMPLES * 32);
+		elapsed[1] += clock() - t;
+
+		if (dsp.sample_count() != dsp_c.sample_count())
+		{
+			printf("dspcheck: %s: %d samples, scalar %d\n", name, dsp.sample_count(), dsp_c.sample_count());
+			return (false);
+		}
+
+		for (int i = 0; i < dsp.sample_count(); i++)
+		{
+			if (out[0][i] != out[1][i])
+			{
+				printf("dspcheck: %s: sample %ld (%s) is %d, scalar %d\n", name, sample + i / 2, i & 1 ? "right" : "left", out[0][i], out[1][i]);
+				return (false);
+			}
+		}
+
+		sample += dsp.sample_count() / 2;
+	}
+
+	if (memcmp(ram[0], ram[1], sizeof(ram[0])))
+	{
+		printf("dspcheck: %s: APU RAM differs\n", name);
+		return (false);
+	}
+
+	for (int i = 0; i < SPC_DSP::register_count; i++)
+	{
+		if (dsp.read(i) != dsp_c.read(i))
+		{
+			printf("dspcheck: %s: DSP register $%02x differs\n", name, i);
+			return (false);
+		}
+	}
+
+	return (true);
+}
+
+int main (int argc, char **argv)
+{
+	unsigned char	regs[SPC_DSP::register_count];
+	int				seconds = 60, failed = 0, i = 1;
+
+	if (i + 1 < argc && !strcmp(argv[i], "-seconds"))
+	{
+		seconds = atoi(argv[i + 1]);
+		i += 2;
+	}
+
+	if (i < argc && argv[i][0] == '-')
+	{
+		fprintf(stderr, "usage: %s [-seconds n] [file.spc ...]\n", argv[0]);
+		return (1);
+	}
+
+	if (i == argc)
+	{
+		FullScaleState(regs);
+		if (!Compare("full scale state", regs, seconds, false))
+			failed++;
+
+		for (int n = 1; n <= 16; n++)
+		{
+			char	name[32];
+
+			seed = n;
+			RandomState(regs, n & 1);
+			sprintf(name, "random state %d", n);
+			if (!Compare(name, regs, seconds, true))
+				failed++;
+		}
+	}
+	else
+	{
+		for (; i < argc; i++)
+		{
+			if (!LoadSPC(argv[i], regs))
+			{
+				printf("dspcheck: %s: can't read SPC dump\n", argv[i]);
+				failed++;
+			}
+			else
+			if (!Compare(argv[i], regs, seconds, false))
+				failed++;
+		}
+	}
+
+	printf("dspcheck: %.2fs, scalar %.2fs, %s\n", (double) elapsed[0] / CLOCKS_PER_SEC, (double) elapsed[1] / CLOCKS_PER_SEC, failed ? "FAILED" : "identical output");
+
+	return (failed ? 1 : 0);
+}
@@ -0,0 +1,740 @@
+/***********************************************************************************
+  Snes9x - Portable Super Nintendo Entertainment System (TM) emulator.
+
+  (c) Copyright 1996 - 2002  Gary Henderson (gary.henderson@ntlworld.com),
+                             Jerremy Koot (jkoot@snes9x.com)
+
+  (c) Copyright 2002 - 2004  Matthew Kendora
+
+  (c) Copyright 2002 - 2005  Peter Bortas (peter@bortas.org)
+
+  (c) Copyright 2004 - 2005  Joel Yliluoma (http://iki.fi/bisqwit/)
+
+  (c) Copyright 2001 - 2006  John Weidman (jweidman@slip.net)
+
+  (c) Copyright 2002 - 2006  funkyass (funkyass@spam.shaw.ca),
+                             Kris Bleakley (codeviolation@hotmail.com)
+
+  (c) Copyright 2002 - 2010  Brad Jorsch (anomie@users.sourceforge.net),
+                             Nach (n-a-c-h@users.sourceforge.net),
+
+  (c) Copyright 2002 - 2011  zones (kasumitokoduck@yahoo.com)
+
+  (c) Copyright 2006 - 2007  nitsuja
+
+  (c) Copyright 2009 - 2011  BearOso,
+                             OV2
+
+
+  BS-X C emulator code
+  (c) Copyright 2005 - 2006  Dreamer Nom,
+                             zones
+
+  C4 x86 assembler and some C emulation code
+  (c) Copyright 2000 - 2003  _Demo_ (_demo_@zsnes.com),
+                             Nach,
+                             zsKnight (zsknight@zsnes.com)
+
+  C4 C++ code
+  (c) Copyright 2003 - 2006  Brad Jorsch,
+                             Nach
+
+  DSP-1 emulator code
+  (c) Copyright 1998 - 2006  _Demo_,
+                             Andreas Naive (andreasnaive@gmail.com),
+                             Gary Henderson,
+                             Ivar (ivar@snes9x.com),
+                             John Weidman,
+                             Kris Bleakley,
+                             Matthew Kendora,
+                             Nach,
+                             neviksti (neviksti@hotmail.com)
+
+  DSP-2 emulator code
+  (c) Copyright 2003         John Weidman,
+                             Kris Bleakley,
+                             Lord Nightmare (lord_nightmare@users.sourceforge.net),
+                             Matthew Kendora,
+                             neviksti
+
+  DSP-3 emulator code
+  (c) Copyright 2003 - 2006  John Weidman,
+                             Kris Bleakley,
+                             Lancer,
+                             z80 gaiden
+
+  DSP-4 emulator code
+  (c) Copyright 2004 - 2006  Dreamer Nom,
+                             John Weidman,
+                             Kris Bleakley,
+                             Nach,
+                             z80 gaiden
+
+  OBC1 emulator code
+  (c) Copyright 2001 - 2004  zsKnight,
+                             pagefault (pagefault@zsnes.com),
+                             Kris Bleakley
+                             Ported from x86 assembler to C by sanmaiwashi
+
+  SPC7110 and RTC C++ emulator code used in 1.39-1.51
+  (c) Copyright 2002         Matthew Kendora with research by
+                             zsKnight,
+                             John Weidman,
+                             Dark Force
+
+  SPC7110 and RTC C++ emulator code used in 1.52+
+  (c) Copyright 2009         byuu,
+                             neviksti
+
+  S-DD1 C emulator code
+  (c) Copyright 2003         Brad Jorsch with research by
+                             Andreas Naive,
+                             John Weidman
+
+  S-RTC C emulator code
+  (c) Copyright 2001 - 2006  byuu,
+                             John Weidman
+
+  ST010 C++ emulator code
+  (c) Copyright 2003         Feather,
+                             John Weidman,
+                             Kris Bleakley,
+                             Matthew Kendora
+
+  Super FX x86 assembler emulator code
+  (c) Copyright 1998 - 2003  _Demo_,
+                             pagefault,
+                             zsKnight
+
+  Super FX C emulator code
+  (c) Copyright 1997 - 1999  Ivar,
+                             Gary Henderson,
+                             John Weidman
+
+  Sound emulator code used in 1.5-1.51
+  (c) Copyright 1998 - 2003  Brad Martin
+  (c) Copyright 1998 - 2006  Charles Bilyue'
+
+  Sound emulator code used in 1.52+
+  (c) Copyright 2004 - 2007  Shay Green (gblargg@gmail.com)
+
+  SH assembler code partly based on x86 assembler code
+  (c) Copyright 2002 - 2004  Marcus Comstedt (marcus@mc.pp.se)
+
+  2xSaI filter
+  (c) Copyright 1999 - 2001  Derek Liauw Kie Fa
+
+  HQ2x, HQ3x, HQ4x filters
+  (c) Copyright 2003         Maxim Stepin (maxim@hiend3d.com)
+
+  NTSC filter
+  (c) Copyright 2006 - 2007  Shay Green
+
+  GTK+ GUI code
+  (c) Copyright 2004 - 2011  BearOso
+
+  Win32 GUI code
+  (c) Copyright 2003 - 2006  blip,
+                             funkyass,
+                             Matthew Kendora,
+                             Nach,
+                             nitsuja
+  (c) Copyright 2009 - 2011  OV2
+
+  Mac OS GUI code
+  (c) Copyright 1998 - 2001  John Stiles
+  (c) Copyright 2001 - 2011  zones
+
+
+  Specific ports contains the works of other authors. See headers in
+  individual files.
+
+
+  Snes9x homepage: http://www.snes9x.com/
+
+  Permission to use, copy, modify and/or distribute Snes9x in both binary
+  and source form, for non-commercial purposes, is hereby granted without
+  fee, providing that this license information and copyright notice appear
+  with all copies and any derived work.
+
+  This software is provided 'as-is', without any express or implied
+  warranty. In no event shall the authors be held liable for any damages
+  arising from the use of this software or it's derivatives.
+
+  Snes9x is freeware for PERSONAL USE only. Commercial users should
+  seek permission of the copyright holders first. Commercial use includes,
+  but is not limited to, charging money for Snes9x or software derived from
+  Snes9x, including Snes9x or derivatives in commercial game bundles, and/or
+  using Snes9x as a promotion for your commercial product.
+
+  The copyright holders request that bug fixes and improvements to the code
+  should be forwarded to them so everyone can benefit from the modifications
+  in future versions.
+
+  Super NES and Super Nintendo Entertainment System are trademarks of
+  Nintendo Co., Limited and its subsidiary companies.
+ ***********************************************************************************/
+
+
+// snes9x-env: hosts several emulators, one context thread each (see context.h),
+// and steps them in lockstep for a trainer talking over a Unix socket. The
+// protocol is described in env.h.
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#ifdef HAVE_STRINGS_H
+#include <strings.h>
+#endif
+
+#include "snes9x.h"
+#include "memmap.h"
+#include "apu/apu.h"
+#include "gfx.h"
+#include "ppu.h"
+#include "movie.h"
+#include "snapshot.h"
+#include "display.h"
+#include "context.h"
+#include "env.h"
+
+extern "C" {
+	#include "lua.h"
+	#include "lauxlib.h"
+	#include "lualib.h"
+}
+
+#define ENV_MAX_RANGES	16
+#define ENV_ALIGN(n)	(((n) + 63) & ~63)
+
+uint8 S9xGetByteFree (uint32);
+
+struct SEnvInstance
+{
+	SContext	*ctx;
+	uint32		op;
+	uint32		frames;
+	uint16		*input;
+	uint8		*obs;
+	uint8		*screen;
+	uint8		*state;
+	uint32		state_size;
+	lua_State	*L;
+	uint32		hash;
+	bool8		ok;
+};
+
+static struct
+{
+	const char	*socket;
+	const char	*reward;
+	const char	*rom;
+	int			count;
+	int			scale;
+	int			ranges;
+	uint32		range_addr[ENV_MAX_RANGES];
+	uint32		range_size[ENV_MAX_RANGES];
+	uint32		ram_size;
+	uint32		width;
+	uint32		height;
+	uint32		check_frames;
+}	env;
+
+static int EnvReadByte (lua_State *L)
+{
+	lua_pushinteger(L, S9xGetByteFree((uint32) luaL_checkinteger(L, 1)));
+	return (1);
+}
+
+static int EnvReadByteSigned (lua_State *L)
+{
+	lua_pushinteger(L, (int8) S9xGetByteFree((uint32) luaL_checkinteger(L, 1)));
+	return (1);
+}
+
+static int EnvReadWord (lua_State *L)
+{
+	uint32	address = (uint32) luaL_checkinteger(L, 1);
+
+	lua_pushinteger(L, S9xGetByteFree(address) | (S9xGetByteFree(address + 1) << 8));
+	return (1);
+}
+
+static int EnvFrameCount (lua_State *L)
+{
+	lua_pushinteger(L, IPPU.TotalEmulatedFrames);
+	return (1);
+}
+
+static const struct luaL_reg env_memorylib[] =
+{
+	{ "readbyte",       EnvReadByte       },
+	{ "readbytesigned", EnvReadByteSigned },
+	{ "readword",       EnvReadWord       },
+	{ NULL, NULL }
+};
+
+static const struct luaL_reg env_emulib[] =
+{
+	{ "framecount", EnvFrameCount },
+	{ NULL, NULL }
+};
+
+bool8 S9xEnvParseArg (char **argv, int &i, int argc)
+{
+	if (!strcasecmp(argv[i], "-envsocket") || !strcasecmp(argv[i], "-envcount") ||
+		!strcasecmp(argv[i], "-envscale")  || !strcasecmp(argv[i], "-envram")   ||
+		!strcasecmp(argv[i], "-envreward") || !strcasecmp(argv[i], "-envcheck"))
+	{
+		if (i + 1 >= argc)
+			S9xUsage();
+	}
+	else
+		return (FALSE);
+
+	const char	*opt = argv[i], *val = argv[++i];
+
+	if (!strcasecmp(opt, "-envsocket"))
+		env.socket = val;
+	else
+	if (!strcasecmp(opt, "-envcount"))
+		env.count = atoi(val);
+	else
+	if (!strcasecmp(opt, "-envscale"))
+		env.scale = atoi(val);
+	else
+	if (!strcasecmp(opt, "-envreward"))
+		env.reward = val;
+	else
+	if (!strcasecmp(opt, "-envcheck"))
+		env.check_frames = atoi(val);
+	else
+	{
+		char	*end;
+
+		if (env.ranges == ENV_MAX_RANGES)
+			S9xUsage();
+
+		env.range_addr[env.ranges] = strtoul(val, &end, 0);
+		env.range_size[env.ranges] = (*end == ':') ? strtoul(end + 1, NULL, 0) : 1;
+		env.ranges++;
+	}
+
+	return (TRUE);
+}
+
+void S9xEnvUsage (void)
+{
+	S9xMessage(S9X_INFO, S9X_USAGE, "-envsocket <path>               Unix socket to serve batched steps on");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-envcount <num>                 Number of emulator instances (default: 1)");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-envscale <num>                 Downscale factor of observed frames (default: 2)");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-envram <addr>:<len>            RAM range to observe (repeatable)");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-envreward <filename>           Lua script defining reward() for each instance");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-envcheck <frames>              Don't serve, check that instances run in parallel");
+	S9xMessage(S9X_INFO, S9X_USAGE, "                                end in the same state as one run alone");
+	S9xMessage(S9X_INFO, S9X_USAGE, "");
+}
+
+static void EnvObserve (SEnvInstance *inst)
+{
+	SEnvObservation	*o = (SEnvObservation *) inst->obs;
+	uint8			*ram = inst->obs + sizeof(SEnvObservation);
+
+	o->reward = 0.0f;
+	o->done = 0;
+	o->frame = IPPU.TotalEmulatedFrames;
+
+	if (inst->L)
+	{
+		lua_State	*L = inst->L;
+
+		lua_getglobal(L, "reward");
+		if (lua_pcall(L, 0, 2, 0) == 0)
+		{
+			o->reward = (float) lua_tonumber(L, -2);
+			o->done = lua_isnumber(L, -1) ? (lua_tonumber(L, -1) != 0) : lua_toboolean(L, -1);
+		}
+		else
+			fprintf(stderr, "snes9x-env: %s\n", lua_tostring(L, -1));
+
+		lua_settop(L, 0);
+	}
+
+	for (int r = 0; r < env.ranges; r++)
+		for (uint32 a = 0; a < env.range_size[r]; a++)
+			*ram++ = S9xGetByteFree((env.range_addr[r] + a) & 0xffffff);
+
+	// The luma image after the RAM is boxed down by the renderer as it draws.
+	S9xFinishRendering();
+}
+
+static void EnvInit (void *data)
+{
+	SEnvInstance	*inst = (SEnvInstance *) data;
+
+	inst->ok = FALSE;
+
+	// Observations must not depend on wall-clock time or on-screen messages.
+	Settings.AutoDisplayMessages = FALSE;
+	Settings.DisplayFrameRate = FALSE;
+	Settings.DisplayPressedKeys = FALSE;
+	Settings.DisplayMovieFrame = FALSE;
+	Settings.DisplayWatchedAddresses = FALSE;
+
+	if (!Memory.Init() || !S9xInitAPU())
+		return;
+
+	S9xInitSound(100, 0);
+	S9xSetSoundMute(TRUE);
+	S9xSetSoundSkip(TRUE);
+#ifdef GFX_MULTI_FORMAT
+	S9xSetRenderPixelFormat(RGB565);
+#endif
+
+	GFX.Pitch = SNES_WIDTH * 2 * 2;
+	inst->screen = (uint8 *) calloc(GFX.Pitch * ((SNES_HEIGHT_EXTENDED + 4) * 2), 1);
+	if (!inst->screen)
+		return;
+	GFX.Screen = (uint16 *) (inst->screen + (GFX.Pitch * 2 * 2));
+
+	if (!S9xGraphicsInit() || !Memory.LoadROM(env.rom))
+		return;
+
+	if (!S9xSetObservation(inst->obs + sizeof(SEnvObservation) + env.ram_size, env.width, env.height))
+		return;
+
+	Settings.StopEmulation = FALSE;
+
+	inst->state_size = S9xFreezeSize();
+	inst->state = (uint8 *) malloc(inst->state_size);
+	if (!inst->state || !S9xFreezeGameMem(inst->state, inst->state_size))
+		return;
+
+	if (env.reward)
+	{
+		inst->L = luaL_newstate();
+		luaL_openlibs(inst->L);
+		luaL_register(inst->L, "memory", env_memorylib);
+		luaL_register(inst->L, "emu", env_emulib);
+		lua_settop(inst->L, 0);
+
+		if (luaL_dofile(inst->L, env.reward))
+		{
+			fprintf(stderr, "snes9x-env: %s\n", lua_tostring(inst->L, -1));
+			return;
+		}
+	}
+
+	EnvObserve(inst);
+	inst->ok = TRUE;
+}
+
+static void EnvStep (void *data)
+{
+	SEnvInstance	*inst = (SEnvInstance *) data;
+
+	if (inst->op == ENV_RESET)
+		S9xUnfreezeGameMem(inst->state, inst->state_size);
+	else
+	{
+		for (uint32 f = 0; f < inst->frames; f++)
+		{
+			MovieSetJoypad(0, *inst->input);
+			IPPU.RenderThisFrame = (f == inst->frames - 1);
+			S9xMainLoop();
+		}
+	}
+
+	EnvObserve(inst);
+}
+
+static void EnvDeinit (void *data)
+{
+	SEnvInstance	*inst = (SEnvInstance *) data;
+
+	if (inst->L)
+		lua_close(inst->L);
+
+	S9xGraphicsDeinit();
+	S9xDeinitAPU();
+	Memory.Deinit();
+
+	free(inst->screen);
+	free(inst->state);
+}
+
+static void EnvHashState (void *data)
+{
+	SEnvInstance	*inst = (SEnvInstance *) data;
+	uint8			*state = (uint8 *) malloc(inst->state_size);
+
+	inst->hash = 0;
+
+	if (state && S9xFreezeGameMem(state, inst->state_size))
+	{
+		inst->hash = 2166136261u;
+		for (uint32 i = 0; i < inst->state_size; i++)
+			inst->hash = (inst->hash ^ state[i]) * 16777619u;
+	}
+
+	free(state);
+}
+
+static void EnvRun (SEnvInstance *inst, int count, void (*func) (void *))
+{
+	for (int i = 0; i < count; i++)
+		S9xRunInContext(inst[i].ctx, func, &inst[i]);
+
+	for (int i = 0; i < count; i++)
+		S9xWaitContext(inst[i].ctx);
+}
+
+static void EnvCheckPass (SEnvInstance *inst, int count)
+{
+	for (int i = 0; i < count; i++)
+		inst[i].op = ENV_RESET;
+	EnvRun(inst, count, EnvStep);
+
+	for (uint32 f = 0; f < env.check_frames; f += 4)
+	{
+		// the same made-up pad sequence for every instance
+		uint16	pad = (uint16) (((f + 1) * 2654435761u) >> 16) & 0xfff0;
+
+		for (int i = 0; i < count; i++)
+		{
+			*inst[i].input = pad;
+			inst[i].op = ENV_STEP;
+			inst[i].frames = 4;
+		}
+
+		EnvRun(inst, count, EnvStep);
+	}
+
+	EnvRun(inst, count, EnvHashState);
+}
+
+// Runs all instances side by side and then the first one alone through the
+// same inputs, and compares their savestates.
+static bool8 EnvCheck (SEnvInstance *inst)
+{
+	uint32	*parallel = new uint32[env.count];
+	bool8	match = TRUE;
+
+	EnvCheckPass(inst, env.count);
+	for (int i = 0; i < env.count; i++)
+		parallel[i] = inst[i].hash;
+
+	EnvCheckPass(inst, 1);
+
+	for (int i = 0; i < env.count; i++)
+	{
+		printf("snes9x-env: instance %d state %08x, alone %08x\n", i, parallel[i], inst[0].hash);
+		if (!parallel[i] || parallel[i] != inst[0].hash)
+			match = FALSE;
+	}
+
+	printf("snes9x-env: %d instances after %u frames %s a single run.\n", env.count, env.check_frames, match ? "match" : "DO NOT match");
+
+	delete [] parallel;
+
+	return (match);
+}
+
+static bool8 EnvReadAll (int fd, void *buf, size_t size)
+{
+	for (uint8 *p = (uint8 *) buf; size; )
+	{
+		ssize_t	n = read(fd, p, size);
+		if (n <= 0)
+			return (FALSE);
+
+		p    += n;
+		size -= n;
+	}
+
+	return (TRUE);
+}
+
+static bool8 EnvWriteAll (int fd, const void *buf, size_t size)
+{
+	for (const uint8 *p = (const uint8 *) buf; size; )
+	{
+		ssize_t	n = write(fd, p, size);
+		if (n <= 0)
+			return (FALSE);
+
+		p    += n;
+		size -= n;
+	}
+
+	return (TRUE);
+}
+
+int S9xEnvServer (const char *rom)
+{
+	if ((!env.socket && !env.check_frames) || !rom)
+	{
+		fprintf(stderr, "snes9x-env: need -envsocket or -envcheck, and a ROM.\n");
+		return (1);
+	}
+
+	if (env.count <= 0)
+		env.count = 1;
+	if (env.scale <= 0 || env.scale > 8)
+		env.scale = 2;
+
+	env.rom = rom;
+	env.width = SNES_WIDTH / env.scale;
+	env.height = SNES_HEIGHT / env.scale;
+	env.ram_size = 0;
+	for (int r = 0; r < env.ranges; r++)
+		env.ram_size += env.range_size[r];
+
+	SEnvHello	hello;
+
+	memset(&hello, 0, sizeof(hello));
+	hello.magic = ENV_MAGIC;
+	hello.version = ENV_VERSION;
+	hello.count = env.count;
+	hello.width = env.width;
+	hello.height = env.height;
+	hello.ram_size = env.ram_size;
+	hello.input_offset = ENV_ALIGN(sizeof(SEnvHello));
+	hello.obs_offset = hello.input_offset + ENV_ALIGN(env.count * sizeof(uint16));
+	hello.obs_stride = ENV_ALIGN(sizeof(SEnvObservation) + env.ram_size + env.width * env.height);
+	hello.shm_size = hello.obs_offset + env.count * hello.obs_stride;
+	snprintf(hello.shm_name, sizeof(hello.shm_name), "/snes9x-env-%d", (int) getpid());
+
+	int	fd = shm_open(hello.shm_name, O_CREAT | O_RDWR | O_TRUNC, 0600);
+	if (fd < 0 || ftruncate(fd, hello.shm_size) != 0)
+	{
+		perror("snes9x-env: shm_open");
+		return (1);
+	}
+
+	uint8	*shm = (uint8 *) mmap(NULL, hello.shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (shm == MAP_FAILED)
+	{
+		perror("snes9x-env: mmap");
+		shm_unlink(hello.shm_name);
+		return (1);
+	}
+
+	memcpy(shm, &hello, sizeof(hello));
+
+	// Bring the instances up one at a time; loading a ROM touches frontend statics.
+	SEnvInstance	*inst = new SEnvInstance[env.count];
+	bool8			ok = TRUE;
+
+	for (int i = 0; i < env.count; i++)
+	{
+		memset(&inst[i], 0, sizeof(SEnvInstance));
+		inst[i].input = (uint16 *) (shm + hello.input_offset) + i;
+		inst[i].obs = shm + hello.obs_offset + i * hello.obs_stride;
+		inst[i].ctx = S9xCreateContext();
+
+		if (inst[i].ctx)
+		{
+			S9xRunInContext(inst[i].ctx, EnvInit, &inst[i]);
+			S9xWaitContext(inst[i].ctx);
+		}
+
+		ok = ok && inst[i].ok;
+	}
+
+	int	s = -1;
+
+	if (ok && env.check_frames)
+		ok = EnvCheck(inst);
+	else
+	if (ok)
+	{
+		struct sockaddr_un	addr;
+
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, env.socket, sizeof(addr.sun_path) - 1);
+		unlink(env.socket);
+
+		s = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (s < 0 || bind(s, (struct sockaddr *) &addr, sizeof(addr)) != 0 || listen(s, 1) != 0)
+		{
+			perror("snes9x-env: socket");
+			ok = FALSE;
+		}
+	}
+	else
+		fprintf(stderr, "snes9x-env: could not start the emulator instances.\n");
+
+	signal(SIGPIPE, SIG_IGN);
+
+	if (ok && !env.check_frames)
+		printf("snes9x-env: %d instances on %s, shared memory %s\n", env.count, env.socket, hello.shm_name);
+
+	for (bool8 quit = !ok || env.check_frames; !quit; )
+	{
+		int	c = accept(s, NULL, NULL);
+		if (c < 0)
+			break;
+
+		SEnvRequest	req;
+		SEnvReply	rep;
+
+		if (EnvWriteAll(c, &hello, sizeof(hello)))
+		{
+			while (EnvReadAll(c, &req, sizeof(req)))
+			{
+				rep.op = req.op;
+				rep.status = 0;
+
+				if (req.op == ENV_STEP || req.op == ENV_RESET)
+				{
+					for (int i = 0; i < env.count; i++)
+					{
+						inst[i].op = req.op;
+						inst[i].frames = req.frames;
+					}
+
+					EnvRun(inst, env.count, EnvStep);
+				}
+				else
+				if (req.op == ENV_QUIT)
+					quit = TRUE;
+				else
+					rep.status = 1;
+
+				if (!EnvWriteAll(c, &rep, sizeof(rep)) || quit)
+					break;
+			}
+		}
+
+		close(c);
+	}
+
+	if (s >= 0)
+	{
+		close(s);
+		unlink(env.socket);
+	}
+
+	for (int i = 0; i < env.count; i++)
+	{
+		if (inst[i].ctx)
+		{
+			S9xRunInContext(inst[i].ctx, EnvDeinit, &inst[i]);
+			S9xDeleteContext(inst[i].ctx);
+		}
+	}
+
+	delete [] inst;
+	munmap(shm, hello.shm_size);
+	shm_unlink(hello.shm_name);
+
+	return (ok ? 0 : 1);
+}
@@ -0,0 +1,11 @@
+-- Flips MEMSEL ($420D) every frame, so that a game running from banks $80-$FF
+-- alternates between FastROM and SlowROM timing, for bench.sh:
+--
+--   BENCH_LUA=memselbench.lua ./bench.sh game.sfc 3000 ""
+
+local frame = 0
+
+emu.registerbefore(function()
+	frame = frame + 1
+	memory.writebyte(0x420d, frame % 2)
+end)
@@ -0,0 +1,26 @@
+#!/bin/sh
+#
+# Checks that several emulator instances in one process don't disturb each
+# other: snes9x-env steps them in parallel through the same inputs, runs the
+# first one again on its own and compares the savestates. Needs a build
+# configured with --enable-multi-instance.
+#
+#   ./multitest.sh <rom> [frames] [instances]
+#
+# Exits non-zero when any instance ends in a different state.
+
+SNES9X_ENV=${SNES9X_ENV:-./snes9x-env}
+
+if [ $# -lt 1 ]; then
+	echo "usage: $0 <rom> [frames] [instances]" >&2
+	exit 1
+fi
+
+rom=$1
+frames=${2:-3000}
+count=${3:-2}
+
+out=$("$SNES9X_ENV" -envcount "$count" -envcheck "$frames" "$rom" 2>&1)
+status=$?
+printf '%s\n' "$out" | grep '^snes9x-env:'
+exit $status
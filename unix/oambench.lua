@@ -0,0 +1,49 @@
+-- Keeps all 128 sprites on screen for timing the sprite setup with bench.sh:
+--
+--   BENCH_LUA=oambench.lua ./bench.sh game.sfc 3000 ""
+--
+-- Before every frame the whole OAM is rewritten through $2102-$2104. The first
+-- OAMBENCH_MOVING sprites (default 4) move every frame, the others jump every
+-- 32 frames, and half of them are large, so lines are both kept and redone.
+
+local frame = 0
+local moving = tonumber(os.getenv("OAMBENCH_MOVING") or "4")
+
+emu.registerbefore(function()
+	frame = frame + 1
+
+	local x = {}
+
+	memory.writebyte(0x2101, 0x60)		-- 16x16 and 32x32 sprites
+	memory.writebyte(0x212c, 0x1f)		-- sprites on the main screen
+	memory.writebyte(0x2102, 0)
+	memory.writebyte(0x2103, 0)
+
+	for i = 0, 127 do
+		local t = frame
+		if i >= moving then
+			t = math.floor(frame / 32)
+		end
+
+		x[i] = (i * 37 + t * (i % 7 + 1)) % 512
+		memory.writebyte(0x2104, x[i] % 256)
+		memory.writebyte(0x2104, (i * 11 + t * (i % 5 + 1)) % 240)
+		memory.writebyte(0x2104, i)
+		memory.writebyte(0x2104, 0x30 + (i % 8) * 2)
+	end
+
+	-- X bit 8 and the size bit, four sprites a byte
+	for i = 0, 127, 4 do
+		local b = 0
+		for j = 0, 3 do
+			local s = i + j
+			if x[s] >= 256 then
+				b = b + bit.lshift(1, j * 2)
+			end
+			if s % 2 == 1 then
+				b = b + bit.lshift(2, j * 2)
+			end
+		end
+		memory.writebyte(0x2104, b)
+	end
+end)
@@ -215,6 +215,7 @@
 #include "cheats.h"
 #include "movie.h"
 #include "logger.h"
+#include "audiocapture.h"
 #include "display.h"
 #include "conffile.h"
 #ifdef NETPLAY_SUPPORT
@@ -224,6 +225,9 @@
 #include "debug.h"
 #endif
 #include "statemanager.h"
+#ifdef ENV_SERVER
+#include "env.h"
+#endif
 
 #ifdef NETPLAY_SUPPORT
 #ifdef _DEBUG
@@ -254,7 +258,10 @@ static const char	*s9x_base_dir        = NULL,
 					*rom_filename        = NULL,
 					*snapshot_filename   = NULL,
 					*play_smv_filename   = NULL,
-					*record_smv_filename = NULL;
+					*record_smv_filename = NULL,
+					*sound_capture_filename = NULL,
+					*frame_hash_filename = NULL,
+					*lua_script_filename = NULL;
 
 static char		default_dir[PATH_MAX + 1];
 
@@ -283,6 +290,9 @@ struct SUnixSettings
 	uint32	SoundFragmentSize;
 	uint32	rewindBufferSize;
 	uint32	rewindGranularity;
+	bool8	Headless;
+	bool8	NoRender;
+	uint32	MaxFrames;
 };
 
 struct SoundStatus
@@ -293,6 +303,7 @@ struct SoundStatus
 	uint32	err_rate;
 	int32	samples_mixed_so_far;
 	int32	play_position;
+	bool8	sixteen_bit;
 };
 
 static SUnixSettings	unixSettings;
@@ -300,13 +311,20 @@ static SoundStatus		so;
 
 static bool8	rewinding;
 
+static FILE		*frame_hash_file = NULL;
+static uint32	frame_hash_count = 0;
+
+static uint8			*headless_buffer = NULL;
+static struct timeval	headless_start;
+static uint32			headless_start_frame;
+static volatile bool8	headless_quit = FALSE;
+
 #ifndef NOSOUND
 static uint8			Buf[SOUND_BUFFER_SIZE];
 #endif
 
 #ifdef USE_THREADS
 static pthread_t		thread;
-static pthread_mutex_t	mutex;
 #endif
 
 #ifdef JOYSTICK_SUPPORT
@@ -444,17 +462,40 @@ void S9xExtraUsage (void)
 	S9xMessage(S9X_INFO, S9X_USAGE, "-dumpstreams                    Save audio/video data to disk");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-dumpmaxframes <num>            Stop emulator after saving specified number of");
 	S9xMessage(S9X_INFO, S9X_USAGE, "                                frames (use with -dumpstreams)");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-soundcapture <filename>        Capture sound to a .wav or .flac file, with frame");
+	S9xMessage(S9X_INFO, S9X_USAGE, "                                boundaries in <filename>.frames");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-framehash <filename>           Write a hash of every displayed frame to <filename>,");
+	S9xMessage(S9X_INFO, S9X_USAGE, "                                to compare renderer settings");
 	S9xMessage(S9X_INFO, S9X_USAGE, "");
 
 	S9xMessage(S9X_INFO, S9X_USAGE, "-rwbuffersize                   Rewind buffer size in MB");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-rwgranularity                  Rewind granularity in frames");
 	S9xMessage(S9X_INFO, S9X_USAGE, "");
 
+	S9xMessage(S9X_INFO, S9X_USAGE, "-luascript <filename>           Lua script to run (default: test.lua)");
+#ifndef HEADLESS
+	S9xMessage(S9X_INFO, S9X_USAGE, "-headless                       Run without display, sound and speed throttling");
+#endif
+	S9xMessage(S9X_INFO, S9X_USAGE, "-norender                       Only render frames requested by the Lua script");
+	S9xMessage(S9X_INFO, S9X_USAGE, "                                (use with -headless)");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-maxframes <num>                Stop emulator after specified number of frames");
+	S9xMessage(S9X_INFO, S9X_USAGE, "                                (use with -headless)");
+	S9xMessage(S9X_INFO, S9X_USAGE, "");
+
+#ifdef ENV_SERVER
+	S9xEnvUsage();
+#endif
+
 	S9xExtraDisplayUsage();
 }
 
 void S9xParseArg (char **argv, int &i, int argc)
 {
+#ifdef ENV_SERVER
+	if (S9xEnvParseArg(argv, i, argc))
+		return;
+#endif
+
 	if (!strcasecmp(argv[i], "-multi"))
 		Settings.Multi = TRUE;
 	else
@@ -549,6 +590,22 @@ void S9xParseArg (char **argv, int &i, int argc)
 	if (!strcasecmp(argv[i], "-dumpmaxframes"))
 		Settings.DumpStreamsMaxFrames = atoi(argv[++i]);
 	else
+	if (!strcasecmp(argv[i], "-soundcapture"))
+	{
+		if (i + 1 < argc)
+			sound_capture_filename = argv[++i];
+		else
+			S9xUsage();
+	}
+	else
+	if (!strcasecmp(argv[i], "-framehash"))
+	{
+		if (i + 1 < argc)
+			frame_hash_filename = argv[++i];
+		else
+			S9xUsage();
+	}
+	else
 	if (!strcasecmp(argv[i], "-rwbuffersize"))
 	{
 		if (i + 1 < argc)
@@ -564,6 +621,28 @@ void S9xParseArg (char **argv, int &i, int argc)
 		else
 			S9xUsage();
 	}
+	else
+	if (!strcasecmp(argv[i], "-luascript"))
+	{
+		if (i + 1 < argc)
+			lua_script_filename = argv[++i];
+		else
+			S9xUsage();
+	}
+	else
+	if (!strcasecmp(argv[i], "-headless"))
+		unixSettings.Headless = TRUE;
+	else
+	if (!strcasecmp(argv[i], "-norender"))
+		unixSettings.NoRender = TRUE;
+	else
+	if (!strcasecmp(argv[i], "-maxframes"))
+	{
+		if (i + 1 < argc)
+			unixSettings.MaxFrames = atoi(argv[++i]);
+		else
+			S9xUsage();
+	}
 	else
 		S9xParseDisplayArg(argv, i, argc);
 }
@@ -892,9 +971,33 @@ bool8 S9xInitUpdate (void)
 	return (TRUE);
 }
 
+static void WriteFrameHash (int width, int height)
+{
+	// 64-bit FNV-1a over the visible pixels. Always the whole frame, independent
+	// of GFX.FrameChanged, so the hashes can check that detection as well.
+	uint64	hash = 0xcbf29ce484222325ULL;
+
+	for (int y = 0; y < height; y++)
+	{
+		const uint8	*p = (const uint8 *) (GFX.Screen + y * GFX.RealPPL);
+
+		for (int x = 0; x < width * 2; x++)
+		{
+			hash ^= p[x];
+			hash *= 0x100000001b3ULL;
+		}
+	}
+
+	fprintf(frame_hash_file, "%u %d %d %016llx\n", frame_hash_count++, width, height, (unsigned long long) hash);
+}
+
 bool8 S9xDeinitUpdate (int width, int height)
 {
-	S9xPutImage(width, height);
+	if (frame_hash_file)
+		WriteFrameHash(width, height);
+
+	if (!unixSettings.Headless)
+		S9xPutImage(width, height);
 	return (TRUE);
 }
 
@@ -922,6 +1025,14 @@ void S9xAutoSaveSRAM (void)
 
 void S9xSyncSpeed (void)
 {
+	if (unixSettings.Headless)
+	{
+		// Run as fast as possible. With -norender, only frames the Lua script asks for
+		// with emu.requestframe() get rendered.
+		IPPU.RenderThisFrame = !unixSettings.NoRender;
+		return;
+	}
+
 #ifndef NOSOUND
 	if (Settings.SoundSync)
 	{
@@ -1411,8 +1522,7 @@ static void InitTimer (void)
 #ifdef USE_THREADS
 	if (unixSettings.ThreadSound)
 	{
-		pthread_mutex_init(&mutex, NULL);
-		pthread_create(&thread, NULL, S9xProcessSound, NULL);
+		pthread_create(&thread, NULL, S9xProcessSound, S9xGetSoundOutput());
 		return;
 	}
 #endif
@@ -1440,6 +1550,9 @@ static void InitTimer (void)
 
 bool8 S9xOpenSoundDevice (void)
 {
+	if (unixSettings.Headless)
+		return (FALSE);
+
 #ifndef NOSOUND
 	int	J, K;
 
@@ -1451,6 +1564,8 @@ bool8 S9xOpenSoundDevice (void)
 	if (ioctl(so.sound_fd, SNDCTL_DSP_SETFRAGMENT, &J) == -1)
 		return (FALSE);
 
+	so.sixteen_bit = Settings.SixteenBitSound;
+
 	J = K = Settings.SixteenBitSound ? AFMT_S16_NE : AFMT_U8;
 	if (ioctl(so.sound_fd, SNDCTL_DSP_SETFMT,      &J) == -1 || J != K)
 		return (FALSE);
@@ -1476,28 +1591,33 @@ bool8 S9xOpenSoundDevice (void)
 
 #ifndef NOSOUND
 
-static void * S9xProcessSound (void *)
+static void * S9xProcessSound (void *output)
 {
 	// If threads in use, this is to loop indefinitely.
 	// If not, this will be called by timer.
+	// The thread gets the instance's sound output, and doesn't read Settings
+	// since multi-instance builds give every thread its own.
 
 	audio_buf_info	info;
 	if (!unixSettings.ThreadSound && (ioctl(so.sound_fd, SNDCTL_DSP_GETOSPACE, &info) == -1 || info.bytes < (int) so.fragment_size))
 		return (NULL);
 
 #ifdef USE_THREADS
+	if (unixSettings.ThreadSound)
+		S9xSetSoundOutput((struct SSoundOutput *) output);
+
 	do
 	{
 #endif
 
 	int	sample_count = so.fragment_size;
-	if (Settings.SixteenBitSound)
+	if (so.sixteen_bit)
 		sample_count >>= 1;
 
+	// The resampler is a lock-free single-producer/single-consumer ring, so the
+	// sound thread doesn't need to lock out the emulation thread.
 #ifdef USE_THREADS
-	if (unixSettings.ThreadSound)
-		pthread_mutex_lock(&mutex);
-	else
+	if (!unixSettings.ThreadSound)
 #endif
 	if (block_signal)
 		return (NULL);
@@ -1506,24 +1626,19 @@ static void * S9xProcessSound (void *)
 
 	if (so.samples_mixed_so_far < sample_count)
 	{
-		unsigned	ofs = so.play_position + (Settings.SixteenBitSound ? (so.samples_mixed_so_far << 1) : so.samples_mixed_so_far);
+		unsigned	ofs = so.play_position + (so.sixteen_bit ? (so.samples_mixed_so_far << 1) : so.samples_mixed_so_far);
 		S9xMixSamples(Buf + (ofs & SOUND_BUFFER_SIZE_MASK), sample_count - so.samples_mixed_so_far);
 		so.samples_mixed_so_far = sample_count;
 	}
 
 	unsigned	bytes_to_write = sample_count;
-	if (Settings.SixteenBitSound)
+	if (so.sixteen_bit)
 		bytes_to_write <<= 1;
 
 	unsigned	byte_offset = so.play_position;
 	so.play_position += bytes_to_write;
 	so.play_position &= SOUND_BUFFER_SIZE_MASK;
 
-#ifdef USE_THREADS
-	if (unixSettings.ThreadSound)
-		pthread_mutex_unlock(&mutex);
-#endif
-
 	block_generate_sound = FALSE;
 
 	for (;;)
@@ -1557,9 +1672,57 @@ static void * S9xProcessSound (void *)
 
 #endif
 
+static void InitHeadlessScreen (void)
+{
+	GFX.Pitch = SNES_WIDTH * 2 * 2;
+	headless_buffer = (uint8 *) calloc(GFX.Pitch * ((SNES_HEIGHT_EXTENDED + 4) * 2), 1);
+	if (!headless_buffer)
+	{
+		fprintf(stderr, "Snes9x: Failed to allocate the screen buffer.\n");
+		exit(1);
+	}
+
+	GFX.Screen = (uint16 *) (headless_buffer + (GFX.Pitch * 2 * 2));
+
+	S9xGraphicsInit();
+}
+
+static void DeinitHeadlessScreen (void)
+{
+	S9xGraphicsDeinit();
+
+	free(headless_buffer);
+	headless_buffer = NULL;
+}
+
+static void ReportHeadlessSpeed (void)
+{
+	struct timeval	now;
+
+	gettimeofday(&now, NULL);
+
+	double	seconds = (now.tv_sec - headless_start.tv_sec) + (now.tv_usec - headless_start.tv_usec) / 1000000.0;
+	uint32	frames  = IPPU.TotalEmulatedFrames - headless_start_frame;
+
+	fprintf(stderr, "%u frames in %.2f seconds (%.1f fps)\n", frames, seconds, seconds > 0.0 ? frames / seconds : 0.0);
+}
+
+static void sigquithandler (int)
+{
+	headless_quit = TRUE;
+}
+
 void S9xExit (void)
 {
 	S9xMovieShutdown();
+	S9xAudioCaptureStop();
+
+	S9xFinishRendering();
+	if (frame_hash_file)
+	{
+		fclose(frame_hash_file);
+		frame_hash_file = NULL;
+	}
 
 	S9xSetSoundMute(TRUE);
 	Settings.StopEmulation = TRUE;
@@ -1574,7 +1737,20 @@ void S9xExit (void)
 	S9xResetSaveTimer(FALSE);
 
 	S9xUnmapAllControls();
-	S9xDeinitDisplay();
+
+	if (unixSettings.Headless)
+	{
+		ReportHeadlessSpeed();
+		DeinitHeadlessScreen();
+	}
+	else
+		S9xDeinitDisplay();
+
+	uint32	underruns, overruns;
+	S9xGetSampleStats(&underruns, &overruns);
+	if (underruns || overruns)
+		printf("Sound buffer underruns: %u, overruns: %u\n", underruns, overruns);
+
 	Memory.Deinit();
 	S9xDeinitAPU();
 
@@ -1657,6 +1833,14 @@ int main (int argc, char **argv)
 	unixSettings.rewindBufferSize = 0;
 	unixSettings.rewindGranularity = 1;
 
+#ifdef HEADLESS
+	unixSettings.Headless = TRUE;
+#else
+	unixSettings.Headless = FALSE;
+#endif
+	unixSettings.NoRender = FALSE;
+	unixSettings.MaxFrames = 0;
+
 	memset(&so, 0, sizeof(so));
 
 	rewinding = false;
@@ -1668,6 +1852,10 @@ int main (int argc, char **argv)
 
 	make_snes9x_dirs();
 
+#ifdef ENV_SERVER
+	return (S9xEnvServer(rom_filename));
+#endif
+
 	if (!Memory.Init() || !S9xInitAPU())
 	{
 		fprintf(stderr, "Snes9x: Memory allocation failure - not enough RAM/virtual memory available.\nExiting...\n");
@@ -1772,9 +1960,30 @@ int main (int argc, char **argv)
 #endif
 
 	S9xInitInputDevices();
-	S9xInitDisplay(argc, argv);
-	S9xSetupDefaultKeymap();
-	S9xTextMode();
+	if (unixSettings.Headless)
+	{
+		// No keyboard to map; input comes from movies, Lua or gamepads.
+		InitHeadlessScreen();
+
+		// Nobody listens, so only emulate what the game can see of the sound chip.
+		if (!Settings.DumpStreams)
+			S9xSetSoundSkip(TRUE);
+
+		struct sigaction	qa;
+		qa.sa_handler = sigquithandler;
+		qa.sa_flags = 0;
+		sigemptyset(&qa.sa_mask);
+		sigaction(SIGTERM, &qa, NULL);
+	#ifndef DEBUGGER
+		sigaction(SIGINT, &qa, NULL);
+	#endif
+	}
+	else
+	{
+		S9xInitDisplay(argc, argv);
+		S9xSetupDefaultKeymap();
+		S9xTextMode();
+	}
 
 #ifdef NETPLAY_SUPPORT
 	if (strlen(Settings.ServerName) == 0)
@@ -1840,16 +2049,32 @@ int main (int argc, char **argv)
 		}
 	}
 
-	S9xGraphicsMode();
+	if (sound_capture_filename && !S9xAudioCaptureStart(sound_capture_filename))
+	{
+		fprintf(stderr, "Couldn't capture sound to %s.\n", sound_capture_filename);
+		exit(1);
+	}
 
-	sprintf(String, "\"%s\" %s: %s", Memory.ROMName, TITLE, VERSION);
-	S9xSetTitle(String);
+	if (frame_hash_filename && !(frame_hash_file = fopen(frame_hash_filename, "w")))
+	{
+		fprintf(stderr, "Couldn't open %s.\n", frame_hash_filename);
+		exit(1);
+	}
+
+	if (!unixSettings.Headless)
+	{
+		S9xGraphicsMode();
+
+		sprintf(String, "\"%s\" %s: %s", Memory.ROMName, TITLE, VERSION);
+		S9xSetTitle(String);
+
+		InitTimer();
+	}
 
 #ifdef JOYSTICK_SUPPORT
 	uint32	JoypadSkip = 0;
 #endif
 
-	InitTimer();
 	S9xSetSoundMute(FALSE);
 
 #ifdef NETPLAY_SUPPORT
@@ -1859,13 +2084,29 @@ int main (int argc, char **argv)
 	int context = 0;
 	
         OpenLuaContext(context, PrintToWindowConsole, OnStart, OnStop);
-        RunLuaScriptFile(context, "test.lua");
+        RunLuaScriptFile(context, lua_script_filename ? lua_script_filename : "test.lua");
 	// CloseLuaContext(context);
 
 	// return (0);
 
+	gettimeofday(&headless_start, NULL);
+	headless_start_frame = IPPU.TotalEmulatedFrames;
+
 	while (1)
 	{
+		if (unixSettings.Headless)
+		{
+			if (headless_quit || (unixSettings.MaxFrames && IPPU.TotalEmulatedFrames - headless_start_frame >= unixSettings.MaxFrames))
+				S9xExit();
+
+			if (!Settings.Paused)
+				S9xMainLoop();
+			else
+				usleep(100000);
+
+			continue;
+		}
+
 	#ifdef NETPLAY_SUPPORT
 		if (NP_Activated)
 		{
@@ -235,6 +235,7 @@ struct GUIData
 	Cursor			point_cursor;
 	Cursor			cross_hair_cursor;
 	int				video_mode;
+	int				filter_threads;
 	int				mouse_x;
 	int				mouse_y;
 	bool8			mod1_pressed;
@@ -282,7 +283,7 @@ static bool8 CheckForPendingXEvents (Display *);
 static void SetXRepeat (bool8);
 static void SetupImage (void);
 static void TakedownImage (void);
-static void Repaint (bool8);
+static void Repaint (bool8, bool8);
 static void Convert16To24 (int, int);
 static void Convert16To24Packed (int, int);
 
@@ -301,6 +302,8 @@ void S9xExtraDisplayUsage (void)
 	S9xMessage(S9X_INFO, S9X_USAGE, "-v6                             Video mode: Super2xSaI");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-v7                             Video mode: EPX");
 	S9xMessage(S9X_INFO, S9X_USAGE, "-v8                             Video mode: hq2x");
+	S9xMessage(S9X_INFO, S9X_USAGE, "-filterthreads <num>            Split hq2x over this many threads");
+	S9xMessage(S9X_INFO, S9X_USAGE, "                                (not with --disable-sound)");
 	S9xMessage(S9X_INFO, S9X_USAGE, "");
 }
 
@@ -323,6 +326,14 @@ void S9xParseDisplayArg (char **argv, int &i, int argc)
 			case '8':	GUI.video_mode = VIDEOMODE_HQ2X;		break;
 		}
 	}
+	else
+	if (!strcasecmp(argv[i], "-filterthreads"))
+	{
+		if (i + 1 < argc)
+			GUI.filter_threads = atoi(argv[++i]);
+		else
+			S9xUsage();
+	}
 	else
 		S9xUsage();
 }
@@ -477,6 +488,8 @@ const char * S9xParseDisplayConfig (ConfigFile &conf, int pass)
 	else
 		GUI.video_mode = VIDEOMODE_BLOCKY;
 
+	GUI.filter_threads = conf.GetInt("Unix/X11::FilterThreads", 1);
+
 	return ("Unix/X11");
 }
 
@@ -568,6 +581,8 @@ void S9xInitDisplay (int argc, char **argv)
 	S9xBlitFilterInit();
 	S9xBlit2xSaIFilterInit();
 	S9xBlitHQ2xFilterInit();
+	if (!S9xBlitSetThreads(GUI.filter_threads))
+		fprintf(stderr, "Can't run filters on %d threads, using %d.\n", GUI.filter_threads, S9xBlitGetThreads());
 
 	XSetWindowAttributes	attrib;
 
@@ -786,6 +801,13 @@ void S9xPutImage (int width, int height)
 	int			copyWidth, copyHeight;
 	Blitter		blitFn = NULL;
 
+	// the window still shows an unchanged frame, only the pointer and the stream dump need updating
+	if (!GFX.FrameChanged && width == prevWidth && height == prevHeight)
+	{
+		Repaint(TRUE, FALSE);
+		return;
+	}
+
 	if (GUI.video_mode == VIDEOMODE_BLOCKY || GUI.video_mode == VIDEOMODE_TV || GUI.video_mode == VIDEOMODE_SMOOTH)
 		if ((width <= SNES_WIDTH) && ((prevWidth != width) || (prevHeight != height)))
 			S9xBlitClearDelta();
@@ -856,15 +878,19 @@ void S9xPutImage (int width, int height)
 			Convert16To24(copyWidth, copyHeight);
 	}
 
-	Repaint(TRUE);
+	Repaint(TRUE, TRUE);
 
 	prevWidth  = width;
 	prevHeight = height;
 }
 
+// The 8-bit components come from GFX.XRGB, so the window shows the same
+// colours as screenshots.
 static void Convert16To24 (int width, int height)
 {
-	if (GUI.pixel_format == 565)
+	const uint32	*xrgb = GFX.XRGB;
+
+	if (GUI.red_shift == 16 && GUI.green_shift == 8 && GUI.blue_shift == 0)
 	{
 		for (int y = 0; y < height; y++)
 		{
@@ -872,10 +898,7 @@ static void Convert16To24 (int width, int height)
 			uint32	*d = (uint32 *) (GUI.image->data + y * GUI.image->bytes_per_line);
 
 			for (int x = 0; x < width; x++)
-			{
-				uint32	pixel = *s++;
-				*d++ = (((pixel >> 11) & 0x1f) << (GUI.red_shift + 3)) | (((pixel >> 6) & 0x1f) << (GUI.green_shift + 3)) | ((pixel & 0x1f) << (GUI.blue_shift + 3));
-			}
+				*d++ = xrgb[*s++];
 		}
 	}
 	else
@@ -887,8 +910,8 @@ static void Convert16To24 (int width, int height)
 
 			for (int x = 0; x < width; x++)
 			{
-				uint32	pixel = *s++;
-				*d++ = (((pixel >> 10) & 0x1f) << (GUI.red_shift + 3)) | (((pixel >> 5) & 0x1f) << (GUI.green_shift + 3)) | ((pixel & 0x1f) << (GUI.blue_shift + 3));
+				uint32	pixel = xrgb[*s++];
+				*d++ = (((pixel >> 16) & 0xff) << GUI.red_shift) | (((pixel >> 8) & 0xff) << GUI.green_shift) | ((pixel & 0xff) << GUI.blue_shift);
 			}
 		}
 	}
@@ -896,85 +919,54 @@ static void Convert16To24 (int width, int height)
 
 static void Convert16To24Packed (int width, int height)
 {
-	if (GUI.pixel_format == 565)
+	const uint32	*xrgb = GFX.XRGB;
+
+	for (int y = 0; y < height; y++)
 	{
-		for (int y = 0; y < height; y++)
-		{
-			uint16	*s = (uint16 *) (GUI.blit_screen + y * GUI.blit_screen_pitch);
-			uint8	*d = (uint8 *)  (GUI.image->data + y * GUI.image->bytes_per_line);
+		uint16	*s = (uint16 *) (GUI.blit_screen + y * GUI.blit_screen_pitch);
+		uint8	*d = (uint8 *)  (GUI.image->data + y * GUI.image->bytes_per_line);
 
-		#ifdef LSB_FIRST
-			if (GUI.red_shift < GUI.blue_shift)
-		#else
-			if (GUI.red_shift > GUI.blue_shift)
-		#endif
-			{
-				for (int x = 0; x < width; x++)
-				{
-					uint32	pixel = *s++;
-					*d++ = (pixel >> (11 - 3)) & 0xf8;
-					*d++ = (pixel >>  (6 - 3)) & 0xf8;
-					*d++ = (pixel & 0x1f) << 3;
-				}
-			}
-			else
+	#ifdef LSB_FIRST
+		if (GUI.red_shift < GUI.blue_shift)
+	#else
+		if (GUI.red_shift > GUI.blue_shift)
+	#endif
+		{
+			for (int x = 0; x < width; x++)
 			{
-				for (int x = 0; x < width; x++)
-				{
-					uint32	pixel = *s++;
-					*d++ = (pixel & 0x1f) << 3;
-					*d++ = (pixel >>  (6 - 3)) & 0xf8;
-					*d++ = (pixel >> (11 - 3)) & 0xf8;
-				}
+				uint32	pixel = xrgb[*s++];
+				*d++ = pixel >> 16;
+				*d++ = pixel >>  8;
+				*d++ = pixel;
 			}
 		}
-	}
-	else
-	{
-		for (int y = 0; y < height; y++)
+		else
 		{
-			uint16	*s = (uint16 *) (GUI.blit_screen + y * GUI.blit_screen_pitch);
-			uint8	*d = (uint8 *)  (GUI.image->data + y * GUI.image->bytes_per_line);
-
-		#ifdef LSB_FIRST
-			if (GUI.red_shift < GUI.blue_shift)
-		#else
-			if (GUI.red_shift > GUI.blue_shift)
-		#endif
-			{
-				for (int x = 0; x < width; x++)
-				{
-					uint32	pixel = *s++;
-					*d++ = (pixel >> (10 - 3)) & 0xf8;
-					*d++ = (pixel >>  (5 - 3)) & 0xf8;
-					*d++ = (pixel & 0x1f) << 3;
-				}
-			}
-			else
+			for (int x = 0; x < width; x++)
 			{
-				for (int x = 0; x < width; x++)
-				{
-					uint32	pixel = *s++;
-					*d++ = (pixel & 0x1f) << 3;
-					*d++ = (pixel >>  (5 - 3)) & 0xf8;
-					*d++ = (pixel >> (10 - 3)) & 0xf8;
-				}
+				uint32	pixel = xrgb[*s++];
+				*d++ = pixel;
+				*d++ = pixel >>  8;
+				*d++ = pixel >> 16;
 			}
 		}
 	}
 }
 
-static void Repaint (bool8 isFrameBoundry)
+static void Repaint (bool8 isFrameBoundry, bool8 putImage)
 {
-#ifdef MITSHM
-	if (GUI.use_shared_memory)
+	if (putImage)
 	{
-		XShmPutImage(GUI.display, GUI.window, GUI.gc, GUI.image, 0, 0, 0, 0, SNES_WIDTH * 2, SNES_HEIGHT_EXTENDED * 2, False);
-		XSync(GUI.display, False);
+	#ifdef MITSHM
+		if (GUI.use_shared_memory)
+		{
+			XShmPutImage(GUI.display, GUI.window, GUI.gc, GUI.image, 0, 0, 0, 0, SNES_WIDTH * 2, SNES_HEIGHT_EXTENDED * 2, False);
+			XSync(GUI.display, False);
+		}
+		else
+	#endif
+			XPutImage(GUI.display, GUI.window, GUI.gc, GUI.image, 0, 0, 0, 0, SNES_WIDTH * 2, SNES_HEIGHT_EXTENDED * 2);
 	}
-	else
-#endif
-		XPutImage(GUI.display, GUI.window, GUI.gc, GUI.image, 0, 0, 0, 0, SNES_WIDTH * 2, SNES_HEIGHT_EXTENDED * 2);
 
 	Window			root, child;
 	int				root_x, root_y, x, y;
@@ -1071,7 +1063,7 @@ void S9xProcessEvents (bool8 block)
 				break;
 
 			case Expose:
-				Repaint(FALSE);
+				Repaint(FALSE, TRUE);
 				break;
 		}
 	}